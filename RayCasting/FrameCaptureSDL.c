@@ -0,0 +1,556 @@
+#include "FrameCaptureSDL.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include <SDL3/SDL.h>
+
+#define SCRATCH_ALIGNMENT   16
+
+struct FrameCaptureSDL
+{
+    SDL_IOStream *stream;
+    FrameCaptureFormat format;
+
+    int width;
+    int height;
+    int bytes_per_pixel;
+
+    // Frames are stored tightly packed, rows of width * bytes_per_pixel //
+    uint8_t **slots;
+    int slot_count;
+    size_t row_size;
+    size_t slot_size;
+
+    // Single producer (the render loop), single consumer (the writer thread). //
+    // Both only ever grow; a slot is free while head - tail < slot_count.     //
+    SDL_AtomicInt head;
+    SDL_AtomicInt tail;
+
+    // What a repeat copies, -1 until a frame has gone out; dropped frames never get here //
+    int last_published_slot;
+
+    SDL_Semaphore *frames_ready;
+    SDL_AtomicInt quit;
+    SDL_Thread *writer_thread;
+
+    // Owned by the writer thread //
+    uint8_t *bgrx_rows[2];
+    uint8_t *planes;
+    bool write_failed;
+
+    int frames_submitted;
+    SDL_AtomicInt frames_written;
+    SDL_AtomicInt frames_dropped;
+};
+
+static const char program_log_tag[] = "[FrameCaptureSDL.c]";
+
+// Color Conversion //
+// BT.601 studio range in 8-bit fixed point. Input is B, G, R, X in memory.  //
+// Chroma averages each 2x2 block as two rounding halvings, rows then pairs; //
+// the SSE2 path uses _mm_avg_epu8 for the same result bit for bit.          //
+
+static inline uint8_t FrameCaptureSDL_Luma(int b, int g, int r)
+{
+    return (uint8_t)((((66 * r) + (129 * g) + (25 * b) + 128) >> 8) + 16);
+}
+
+static inline uint8_t FrameCaptureSDL_ChromaU(int b, int g, int r)
+{
+    return (uint8_t)((((-38 * r) - (74 * g) + (112 * b) + 128) >> 8) + 128);
+}
+
+static inline uint8_t FrameCaptureSDL_ChromaV(int b, int g, int r)
+{
+    return (uint8_t)((((112 * r) - (94 * g) - (18 * b) + 128) >> 8) + 128);
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+// Four B, G, R, X pixels dotted with one coefficient per channel, four 32-bit sums //
+static inline __m128i FrameCaptureSDL_Dot4(__m128i pixels, __m128i coefficients)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);
+
+    __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+
+    return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+static inline __m128i FrameCaptureSDL_Scale4(__m128i sums, int offset)
+{
+    return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8), _mm_set1_epi32(offset));
+}
+#endif
+
+static void FrameCaptureSDL_ConvertLumaRow(const uint8_t *bgrx, uint8_t *luma, int width)
+{
+    int x = 0;
+
+#ifdef SDL_SSE2_INTRINSICS
+    const __m128i coefficients = _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0);
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i pixels_0 = _mm_load_si128((const __m128i *)(bgrx + (x * 4)));
+        __m128i pixels_1 = _mm_load_si128((const __m128i *)(bgrx + (x * 4) + 16));
+
+        __m128i luma_0 = FrameCaptureSDL_Scale4(FrameCaptureSDL_Dot4(pixels_0, coefficients), 16);
+        __m128i luma_1 = FrameCaptureSDL_Scale4(FrameCaptureSDL_Dot4(pixels_1, coefficients), 16);
+
+        __m128i packed = _mm_packs_epi32(luma_0, luma_1);
+        packed = _mm_packus_epi16(packed, packed);
+
+        _mm_storel_epi64((__m128i *)(luma + x), packed);
+    }
+#endif
+
+    for (; x < width; x++)
+    {
+        const uint8_t *pixel = bgrx + (x * 4);
+
+        luma[x] = FrameCaptureSDL_Luma(pixel[0], pixel[1], pixel[2]);
+    }
+}
+
+static void FrameCaptureSDL_ConvertChromaRow(const uint8_t *bgrx_0, const uint8_t *bgrx_1, uint8_t *chroma_u, uint8_t *chroma_v, int width)
+{
+    int x = 0;
+
+#ifdef SDL_SSE2_INTRINSICS
+    const __m128i coefficients_u = _mm_setr_epi16(112, -74, -38, 0, 112, -74, -38, 0);
+    const __m128i coefficients_v = _mm_setr_epi16(-18, -94, 112, 0, -18, -94, 112, 0);
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i rows_0 = _mm_avg_epu8(
+            _mm_load_si128((const __m128i *)(bgrx_0 + (x * 4))),
+            _mm_load_si128((const __m128i *)(bgrx_1 + (x * 4))));
+        __m128i rows_1 = _mm_avg_epu8(
+            _mm_load_si128((const __m128i *)(bgrx_0 + (x * 4) + 16)),
+            _mm_load_si128((const __m128i *)(bgrx_1 + (x * 4) + 16)));
+
+        __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(rows_0), _mm_castsi128_ps(rows_1), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(rows_0), _mm_castsi128_ps(rows_1), _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128i blocks = _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd));
+
+        __m128i u = FrameCaptureSDL_Scale4(FrameCaptureSDL_Dot4(blocks, coefficients_u), 128);
+        __m128i v = FrameCaptureSDL_Scale4(FrameCaptureSDL_Dot4(blocks, coefficients_v), 128);
+
+        __m128i packed = _mm_packs_epi32(u, v);
+        packed = _mm_packus_epi16(packed, packed);
+
+        uint32_t packed_u = (uint32_t)_mm_cvtsi128_si32(packed);
+        uint32_t packed_v = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(packed, 4));
+
+        memcpy(chroma_u + (x / 2), &packed_u, 4);
+        memcpy(chroma_v + (x / 2), &packed_v, 4);
+    }
+#endif
+
+    for (; x < width; x += 2)
+    {
+        int x_right = (x + 1 < width) ? x + 1 : x;
+
+        int block[3];
+        for (int channel = 0; channel < 3; channel++)
+        {
+            int left = (bgrx_0[(x * 4) + channel] + bgrx_1[(x * 4) + channel] + 1) >> 1;
+            int right = (bgrx_0[(x_right * 4) + channel] + bgrx_1[(x_right * 4) + channel] + 1) >> 1;
+
+            block[channel] = (left + right + 1) >> 1;
+        }
+
+        chroma_u[x / 2] = FrameCaptureSDL_ChromaU(block[0], block[1], block[2]);
+        chroma_v[x / 2] = FrameCaptureSDL_ChromaV(block[0], block[1], block[2]);
+    }
+}
+
+static void FrameCaptureSDL_ExpandRow(const FrameCaptureSDL *capture, const uint8_t *row, uint8_t *bgrx)
+{
+    if (capture->bytes_per_pixel == 4)
+    {
+        memcpy(bgrx, row, capture->row_size);
+        return;
+    }
+
+    for (int x = 0; x < capture->width; x++)
+    {
+        bgrx[(x * 4) + 0] = row[(x * 3) + 0];
+        bgrx[(x * 4) + 1] = row[(x * 3) + 1];
+        bgrx[(x * 4) + 2] = row[(x * 3) + 2];
+        bgrx[(x * 4) + 3] = 0;
+    }
+}
+
+// Writer Thread //
+
+static bool FrameCaptureSDL_WriteY4M(FrameCaptureSDL *capture, const uint8_t *frame)
+{
+    static const char frame_header[] = "FRAME\n";
+
+    int chroma_width = (capture->width + 1) / 2;
+    int chroma_height = (capture->height + 1) / 2;
+
+    uint8_t *plane_y = capture->planes;
+    uint8_t *plane_u = plane_y + ((size_t)capture->width * capture->height);
+    uint8_t *plane_v = plane_u + ((size_t)chroma_width * chroma_height);
+
+    for (int y = 0; y < capture->height; y += 2)
+    {
+        int y_next = (y + 1 < capture->height) ? y + 1 : y;
+
+        FrameCaptureSDL_ExpandRow(capture, frame + (y * capture->row_size), capture->bgrx_rows[0]);
+        FrameCaptureSDL_ExpandRow(capture, frame + (y_next * capture->row_size), capture->bgrx_rows[1]);
+
+        FrameCaptureSDL_ConvertLumaRow(capture->bgrx_rows[0], plane_y + ((size_t)y * capture->width), capture->width);
+        if (y_next != y)
+            FrameCaptureSDL_ConvertLumaRow(capture->bgrx_rows[1], plane_y + ((size_t)y_next * capture->width), capture->width);
+
+        size_t chroma_offset = (size_t)(y / 2) * chroma_width;
+        FrameCaptureSDL_ConvertChromaRow(capture->bgrx_rows[0], capture->bgrx_rows[1], plane_u + chroma_offset, plane_v + chroma_offset, capture->width);
+    }
+
+    size_t planes_size = ((size_t)capture->width * capture->height) + ((size_t)chroma_width * chroma_height * 2);
+
+    if (SDL_WriteIO(capture->stream, frame_header, sizeof(frame_header) - 1) != sizeof(frame_header) - 1)
+        return false;
+
+    return (SDL_WriteIO(capture->stream, capture->planes, planes_size) == planes_size);
+}
+
+static bool FrameCaptureSDL_WriteRaw(FrameCaptureSDL *capture, const uint8_t *frame)
+{
+    if (capture->bytes_per_pixel == 3)
+        return (SDL_WriteIO(capture->stream, frame, capture->slot_size) == capture->slot_size);
+
+    size_t packed_row_size = (size_t)capture->width * 3;
+
+    for (int y = 0; y < capture->height; y++)
+    {
+        const uint8_t *row = frame + (y * capture->row_size);
+
+        for (int x = 0; x < capture->width; x++)
+        {
+            capture->planes[(x * 3) + 0] = row[(x * 4) + 0];
+            capture->planes[(x * 3) + 1] = row[(x * 4) + 1];
+            capture->planes[(x * 3) + 2] = row[(x * 4) + 2];
+        }
+
+        if (SDL_WriteIO(capture->stream, capture->planes, packed_row_size) != packed_row_size)
+            return false;
+    }
+
+    return true;
+}
+
+static int SDLCALL FrameCaptureSDL_WriterThread(void *data)
+{
+    FrameCaptureSDL *capture = (FrameCaptureSDL *)data;
+
+    while (true)
+    {
+        SDL_WaitSemaphore(capture->frames_ready);
+
+        // Drain everything published so far, quitting only once the ring is empty //
+        while (true)
+        {
+            int tail = SDL_GetAtomicInt(&capture->tail);
+            if (tail == SDL_GetAtomicInt(&capture->head))
+                break;
+
+            const uint8_t *frame = capture->slots[(unsigned int)tail % (unsigned int)capture->slot_count];
+
+            if (!capture->write_failed)
+            {
+                bool written;
+                if (capture->format == FRAME_CAPTURE_FORMAT_Y4M)
+                    written = FrameCaptureSDL_WriteY4M(capture, frame);
+                else
+                    written = FrameCaptureSDL_WriteRaw(capture, frame);
+
+                if (written)
+                    SDL_AddAtomicInt(&capture->frames_written, 1);
+                else
+                {
+                    // Keep consuming so the render loop never waits on a dead stream //
+                    SDL_Log("%s Write failed, dropping the rest of the capture: %s", program_log_tag, SDL_GetError());
+                    capture->write_failed = true;
+                }
+            }
+
+            if (capture->write_failed)
+                SDL_AddAtomicInt(&capture->frames_dropped, 1);
+
+            SDL_SetAtomicInt(&capture->tail, tail + 1);
+        }
+
+        if (SDL_GetAtomicInt(&capture->quit) != 0)
+            break;
+    }
+
+    return 0;
+}
+
+// Producer Side //
+
+static uint8_t *FrameCaptureSDL_AcquireSlot(FrameCaptureSDL *capture, int *head)
+{
+    *head = SDL_GetAtomicInt(&capture->head);
+
+    capture->frames_submitted++;
+
+    // Writer Is Behind: Drop Instead Of Waiting //
+    if (*head - SDL_GetAtomicInt(&capture->tail) >= capture->slot_count)
+    {
+        SDL_AddAtomicInt(&capture->frames_dropped, 1);
+        return NULL;
+    }
+
+    return capture->slots[(unsigned int)*head % (unsigned int)capture->slot_count];
+}
+
+static void FrameCaptureSDL_PublishSlot(FrameCaptureSDL *capture, int head)
+{
+    capture->last_published_slot = (int)((unsigned int)head % (unsigned int)capture->slot_count);
+
+    // SDL atomics are full barriers, the slot contents are visible before the new head //
+    SDL_SetAtomicInt(&capture->head, head + 1);
+
+    SDL_SignalSemaphore(capture->frames_ready);
+}
+
+bool FrameCaptureSDL_Submit(FrameCaptureSDL *capture, const void *pixels, int pitch)
+{
+    int head;
+    uint8_t *slot = FrameCaptureSDL_AcquireSlot(capture, &head);
+    if (slot == NULL)
+        return false;
+
+    const uint8_t *row = (const uint8_t *)pixels;
+
+    if ((size_t)pitch == capture->row_size)
+        memcpy(slot, row, capture->slot_size);
+    else
+    {
+        for (int y = 0; y < capture->height; y++)
+            memcpy(slot + (y * capture->row_size), row + ((size_t)y * pitch), capture->row_size);
+    }
+
+    FrameCaptureSDL_PublishSlot(capture, head);
+
+    return true;
+}
+
+// Repeats the last published frame, keeps the stream at a constant rate when nothing was redrawn //
+bool FrameCaptureSDL_SubmitRepeat(FrameCaptureSDL *capture)
+{
+    if (capture->last_published_slot < 0)
+        return false;
+
+    int head;
+    uint8_t *slot = FrameCaptureSDL_AcquireSlot(capture, &head);
+    if (slot == NULL)
+        return false;
+
+    // Only this thread writes slots, so the published one is intact even if already written out //
+    const uint8_t *previous = capture->slots[capture->last_published_slot];
+
+    memcpy(slot, previous, capture->slot_size);
+
+    FrameCaptureSDL_PublishSlot(capture, head);
+
+    return true;
+}
+
+void FrameCaptureSDL_GetStats(FrameCaptureSDL *capture, FrameCaptureStats *stats)
+{
+    stats->frames_submitted = capture->frames_submitted;
+    stats->frames_written = SDL_GetAtomicInt(&capture->frames_written);
+    stats->frames_dropped = SDL_GetAtomicInt(&capture->frames_dropped);
+}
+
+// Lifetime //
+
+FrameCaptureSDL *FrameCaptureSDL_Create(const char *path, FrameCaptureFormat format, int width, int height, SDL_PixelFormat pixel_format, int frame_rate, int slot_count)
+{
+    int bytes_per_pixel;
+
+    switch (pixel_format)
+    {
+    case SDL_PIXELFORMAT_BGR24:
+        bytes_per_pixel = 3;
+        break;
+    case SDL_PIXELFORMAT_XRGB8888:
+    case SDL_PIXELFORMAT_ARGB8888:
+        bytes_per_pixel = 4;
+        break;
+    default:
+        SDL_Log("%s Unsupported pixel format for capture", program_log_tag);
+        return NULL;
+    }
+
+    if (slot_count < 2)
+        slot_count = 2;
+
+    FrameCaptureSDL *capture = (FrameCaptureSDL *)malloc(sizeof(FrameCaptureSDL));
+    if (capture == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for frame capture", program_log_tag);
+        return NULL;
+    }
+    memset(capture, 0, sizeof(FrameCaptureSDL));
+
+    capture->format = format;
+    capture->width = width;
+    capture->height = height;
+    capture->bytes_per_pixel = bytes_per_pixel;
+    capture->slot_count = slot_count;
+    capture->row_size = (size_t)width * bytes_per_pixel;
+    capture->slot_size = capture->row_size * height;
+
+    // Preallocated Ring, Nothing Is Allocated While Capturing //
+
+    capture->slots = (uint8_t **)malloc(sizeof(uint8_t *) * slot_count);
+    if (capture->slots == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for capture slots", program_log_tag);
+        goto Error;
+    }
+    memset(capture->slots, 0, sizeof(uint8_t *) * slot_count);
+
+    for (int i = 0; i < slot_count; i++)
+    {
+        capture->slots[i] = (uint8_t *)malloc(capture->slot_size);
+        if (capture->slots[i] == NULL)
+        {
+            SDL_Log("%s Failed to allocate memory for capture slot %d", program_log_tag, i);
+            goto Error;
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        capture->bgrx_rows[i] = (uint8_t *)SDL_aligned_alloc(SCRATCH_ALIGNMENT, (size_t)width * 4);
+        if (capture->bgrx_rows[i] == NULL)
+        {
+            SDL_Log("%s Failed to allocate memory for conversion rows", program_log_tag);
+            goto Error;
+        }
+    }
+
+    size_t planes_size = ((size_t)width * height) + ((size_t)((width + 1) / 2) * ((height + 1) / 2) * 2);
+    capture->planes = (uint8_t *)malloc(planes_size);
+    if (capture->planes == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for output planes", program_log_tag);
+        goto Error;
+    }
+
+    // Files and named pipes both work here //
+    capture->stream = SDL_IOFromFile(path, "wb");
+    if (capture->stream == NULL)
+    {
+        SDL_Log("%s Failed to open %s: %s", program_log_tag, path, SDL_GetError());
+        goto Error;
+    }
+
+    if (format == FRAME_CAPTURE_FORMAT_Y4M)
+    {
+        char header[128];
+        int header_length = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, frame_rate);
+
+        if (SDL_WriteIO(capture->stream, header, header_length) != (size_t)header_length)
+        {
+            SDL_Log("%s Failed to write stream header: %s", program_log_tag, SDL_GetError());
+            goto Error;
+        }
+    }
+
+    SDL_SetAtomicInt(&capture->head, 0);
+    SDL_SetAtomicInt(&capture->tail, 0);
+    capture->last_published_slot = -1;
+    SDL_SetAtomicInt(&capture->quit, 0);
+    SDL_SetAtomicInt(&capture->frames_written, 0);
+    SDL_SetAtomicInt(&capture->frames_dropped, 0);
+
+    capture->frames_ready = SDL_CreateSemaphore(0);
+    if (capture->frames_ready == NULL)
+    {
+        SDL_Log("%s Failed to create semaphore: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+
+    capture->writer_thread = SDL_CreateThread(FrameCaptureSDL_WriterThread, "FrameCapture", capture);
+    if (capture->writer_thread == NULL)
+    {
+        SDL_Log("%s Failed to create writer thread: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+
+    SDL_Log("%s Capturing %dx%d at %d fps to %s", program_log_tag, width, height, frame_rate, path);
+
+    return capture;
+
+Error:
+    FrameCaptureSDL_Destroy(capture);
+
+    return NULL;
+}
+
+void FrameCaptureSDL_Destroy(FrameCaptureSDL *capture)
+{
+    if (capture == NULL)
+        return;
+
+    // The writer flushes whatever is still queued before it exits //
+    if (capture->writer_thread != NULL)
+    {
+        SDL_SetAtomicInt(&capture->quit, 1);
+        SDL_SignalSemaphore(capture->frames_ready);
+
+        SDL_WaitThread(capture->writer_thread, NULL);
+
+        FrameCaptureStats stats;
+        FrameCaptureSDL_GetStats(capture, &stats);
+
+        SDL_Log("%s Capture closed: %d frames submitted, %d written, %d dropped",
+            program_log_tag, stats.frames_submitted, stats.frames_written, stats.frames_dropped);
+    }
+
+    if (capture->frames_ready != NULL)
+        SDL_DestroySemaphore(capture->frames_ready);
+
+    if (capture->stream != NULL)
+        SDL_CloseIO(capture->stream);
+
+    if (capture->slots != NULL)
+    {
+        for (int i = 0; i < capture->slot_count; i++)
+        {
+            if (capture->slots[i] != NULL)
+                free(capture->slots[i]);
+        }
+
+        free(capture->slots);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (capture->bgrx_rows[i] != NULL)
+            SDL_aligned_free(capture->bgrx_rows[i]);
+    }
+
+    if (capture->planes != NULL)
+        free(capture->planes);
+
+    free(capture);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <SDL3/SDL.h>
+
+typedef enum
+{
+    FRAME_CAPTURE_FORMAT_Y4M,   // 4:2:0, BT.601 studio range //
+    FRAME_CAPTURE_FORMAT_RAW    // Packed BGR24, no header //
+}
+FrameCaptureFormat;
+
+typedef struct
+{
+    int frames_submitted;
+    int frames_written;
+    int frames_dropped;
+}
+FrameCaptureStats;
+
+typedef struct FrameCaptureSDL FrameCaptureSDL;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern FrameCaptureSDL *FrameCaptureSDL_Create(const char *path, FrameCaptureFormat format, int width, int height, SDL_PixelFormat pixel_format, int frame_rate, int slot_count);
+    extern void FrameCaptureSDL_Destroy(FrameCaptureSDL *capture);
+
+    extern bool FrameCaptureSDL_Submit(FrameCaptureSDL *capture, const void *pixels, int pitch);
+    extern bool FrameCaptureSDL_SubmitRepeat(FrameCaptureSDL *capture);
+
+    extern void FrameCaptureSDL_GetStats(FrameCaptureSDL *capture, FrameCaptureStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#include "RayCastArena.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include <SDL3/SDL.h>
+
+struct RayCastArena
+{
+    uint8_t *base;
+    size_t capacity;
+    size_t used;
+};
+
+static const char program_log_tag[] = "[RayCastArena.c]";
+
+RayCastArena *RayCastArena_Create(size_t capacity)
+{
+    RayCastArena *arena = (RayCastArena *)malloc(sizeof(RayCastArena));
+    if (arena == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for arena", program_log_tag);
+        return NULL;
+    }
+
+    arena->capacity = RayCastArena_AlignSize(capacity);
+    arena->used = 0;
+
+    arena->base = (uint8_t *)SDL_aligned_alloc(RAYCAST_ARENA_ALIGNMENT, arena->capacity);
+    if (arena->base == NULL)
+    {
+        SDL_Log("%s Failed to allocate %zu bytes for arena", program_log_tag, arena->capacity);
+        free(arena);
+        return NULL;
+    }
+
+    // Vector passes may read lanes nobody wrote this frame, keep them defined //
+    memset(arena->base, 0, arena->capacity);
+
+    return arena;
+}
+
+void RayCastArena_Destroy(RayCastArena *arena)
+{
+    if (arena == NULL)
+        return;
+
+    SDL_aligned_free(arena->base);
+    free(arena);
+}
+
+void RayCastArena_Reset(RayCastArena *arena)
+{
+    arena->used = 0;
+}
+
+void *RayCastArena_Alloc(RayCastArena *arena, size_t size)
+{
+    size_t aligned_size = RayCastArena_AlignSize(size);
+
+    if (aligned_size > arena->capacity - arena->used)
+    {
+        SDL_Log("%s Out of space: %zu of %zu bytes used, %zu requested", program_log_tag, arena->used, arena->capacity, size);
+        return NULL;
+    }
+
+    void *ptr = arena->base + arena->used;
+    arena->used += aligned_size;
+
+    return ptr;
+}
+
+size_t RayCastArena_GetUsedBytes(const RayCastArena *arena)
+{
+    return arena->used;
+}
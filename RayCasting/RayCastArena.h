@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Cache line, also enough for any SSE / AVX load //
+#define RAYCAST_ARENA_ALIGNMENT 64
+
+typedef struct RayCastArena RayCastArena;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern RayCastArena *RayCastArena_Create(size_t capacity);
+    extern void RayCastArena_Destroy(RayCastArena *arena);
+
+    extern void RayCastArena_Reset(RayCastArena *arena);
+
+    extern void *RayCastArena_Alloc(RayCastArena *arena, size_t size);
+
+    extern size_t RayCastArena_GetUsedBytes(const RayCastArena *arena);
+
+    // Rounds an allocation size up so the next allocation stays aligned //
+    static inline size_t RayCastArena_AlignSize(size_t size)
+    {
+        return (size + (RAYCAST_ARENA_ALIGNMENT - 1)) & ~(size_t)(RAYCAST_ARENA_ALIGNMENT - 1);
+    }
+
+#ifdef __cplusplus
+}
+#endif
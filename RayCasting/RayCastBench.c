@@ -0,0 +1,358 @@
+#define _USE_MATH_DEFINES
+
+#include "RayCastBench.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+#include <SDL3/SDL.h>
+
+#include "RayCastLevelGen.h"
+
+#define BENCH_MAX_VALUES    16
+
+typedef struct
+{
+    int count;
+    double values[BENCH_MAX_VALUES];
+}
+RayCastBenchList;
+
+typedef struct
+{
+    int kind_count;
+    RayCastLevelGenKind kinds[RAYCAST_LEVELGEN_KIND_COUNT];
+
+    RayCastBenchList sizes;
+    RayCastBenchList densities;
+    RayCastBenchList run_lengths;
+    RayCastBenchList view_distances;
+    RayCastBenchList seeds;
+
+    int frames;
+}
+RayCastBenchConfig;
+
+// Rendered before timing, so texture decode and cold caches stay out of the numbers //
+static const int warmup_frames = 8;
+
+// Headless init starts the texture loader, the first frames wait for it //
+static const uint64_t texture_wait_ms = 5000;
+
+// Tries per pose to land in an empty cell before settling for the start //
+static const int pose_attempts = 64;
+
+static const char program_log_tag[] = "[RayCastBench.c]";
+
+static bool RayCastBench_ParseList(const char *text, RayCastBenchList *list)
+{
+    list->count = 0;
+
+    while (*text != '\0')
+    {
+        if (list->count >= BENCH_MAX_VALUES)
+            return false;
+
+        char *end;
+        list->values[list->count++] = strtod(text, &end);
+
+        if (end == text || (*end != ',' && *end != '\0'))
+            return false;
+
+        text = (*end == ',') ? end + 1 : end;
+    }
+
+    return (list->count > 0);
+}
+
+static bool RayCastBench_ParseKinds(const char *text, RayCastBenchConfig *config)
+{
+    char name[32];
+
+    config->kind_count = 0;
+
+    while (*text != '\0')
+    {
+        size_t length = strcspn(text, ",");
+        if (length == 0 || length >= sizeof(name) || config->kind_count >= RAYCAST_LEVELGEN_KIND_COUNT)
+            return false;
+
+        memcpy(name, text, length);
+        name[length] = '\0';
+
+        if (!RayCastLevelGen_FindKind(name, &config->kinds[config->kind_count]))
+            return false;
+
+        config->kind_count++;
+
+        text += length;
+        if (*text == ',')
+            text++;
+    }
+
+    return (config->kind_count > 0);
+}
+
+static void RayCastBench_SetDefaultList(RayCastBenchList *list, double value)
+{
+    list->count = 1;
+    list->values[0] = value;
+}
+
+static bool RayCastBench_ParseArgs(int argc, char *argv[], RayCastBenchConfig *config)
+{
+    memset(config, 0, sizeof(RayCastBenchConfig));
+
+    for (int i = 0; i < RAYCAST_LEVELGEN_KIND_COUNT; i++)
+        config->kinds[i] = (RayCastLevelGenKind)i;
+    config->kind_count = RAYCAST_LEVELGEN_KIND_COUNT;
+
+    config->sizes.count = 3;
+    config->sizes.values[0] = 64;
+    config->sizes.values[1] = 512;
+    config->sizes.values[2] = 4096;
+
+    RayCastBench_SetDefaultList(&config->densities, 0.3);
+    RayCastBench_SetDefaultList(&config->run_lengths, 8);
+    RayCastBench_SetDefaultList(&config->view_distances, 0);
+    RayCastBench_SetDefaultList(&config->seeds, 1);
+
+    config->frames = 120;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = strchr(arg, '=');
+
+        bool valid = false;
+
+        if (value != NULL)
+        {
+            size_t key_length = (size_t)(value - arg);
+            value++;
+
+            if (key_length == 4 && strncmp(arg, "kind", 4) == 0)
+                valid = RayCastBench_ParseKinds(value, config);
+            else if (key_length == 4 && strncmp(arg, "size", 4) == 0)
+                valid = RayCastBench_ParseList(value, &config->sizes);
+            else if (key_length == 7 && strncmp(arg, "density", 7) == 0)
+                valid = RayCastBench_ParseList(value, &config->densities);
+            else if (key_length == 3 && strncmp(arg, "run", 3) == 0)
+                valid = RayCastBench_ParseList(value, &config->run_lengths);
+            else if (key_length == 4 && strncmp(arg, "view", 4) == 0)
+                valid = RayCastBench_ParseList(value, &config->view_distances);
+            else if (key_length == 4 && strncmp(arg, "seed", 4) == 0)
+                valid = RayCastBench_ParseList(value, &config->seeds);
+            else if (key_length == 6 && strncmp(arg, "frames", 6) == 0)
+            {
+                config->frames = atoi(value);
+                valid = (config->frames > 0);
+            }
+        }
+
+        if (!valid)
+        {
+            SDL_Log("%s Bad argument \"%s\"", program_log_tag, arg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Seeded from the level, so every build renders the same views of the same level //
+static void RayCastBench_MakePoses(const RayCastGeneratedLevel *level, uint64_t seed, RayCastPose *poses, int count)
+{
+    uint64_t state = seed ^ 0x2545F4914F6CDD1DULL;
+
+    for (int i = 0; i < count; i++)
+    {
+        int cell_x = level->start_x;
+        int cell_y = level->start_y;
+
+        for (int attempt = 0; attempt < pose_attempts; attempt++)
+        {
+            // xorshift64, plenty for picking cells //
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            int x = (int)((state >> 32) % (uint64_t)level->view.size_x);
+            int y = (int)((state & 0xFFFFFFFFULL) % (uint64_t)level->view.size_y);
+
+            if (level->cells[((size_t)y * level->view.size_x) + x] == 0)
+            {
+                cell_x = x;
+                cell_y = y;
+                break;
+            }
+        }
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        poses[i].pos_x = cell_x + 0.5F;
+        poses[i].pos_y = cell_y + 0.5F;
+        poses[i].angle = (float)(state >> 40) / (float)(1 << 24) * 2.0F * (float)M_PI;
+    }
+}
+
+static bool RayCastBench_WaitForTextures(void)
+{
+    uint64_t wait_start = SDL_GetTicks();
+
+    while (!RayCast_PrepareBatch())
+    {
+        if (SDL_GetTicks() - wait_start > texture_wait_ms)
+        {
+            SDL_Log("%s Textures did not load, timing untextured walls", program_log_tag);
+            return false;
+        }
+
+        SDL_Delay(1);
+    }
+
+    return true;
+}
+
+// One level, every view distance. False only if the engine could not start //
+static bool RayCastBench_RunLevel(const RayCastBenchConfig *config, const RayCastLevelGenParams *params, const RayCastGeneratedLevel *level, double generate_ms)
+{
+    bool result = false;
+
+    RayCastRenderContext *context = NULL;
+    uint8_t *pixels = NULL;
+    RayCastPose *poses = NULL;
+
+    int width, height, bytes_per_pixel;
+    RayCast_GetFrameLayout(&width, &height, &bytes_per_pixel);
+
+    int pitch = width * bytes_per_pixel;
+
+    pixels = (uint8_t *)malloc((size_t)pitch * height);
+    poses = (RayCastPose *)malloc(sizeof(RayCastPose) * (size_t)config->frames);
+    if (pixels == NULL || poses == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for benchmark", program_log_tag);
+        goto Error;
+    }
+
+    RayCastBench_MakePoses(level, params->seed, poses, config->frames);
+
+    if (!RayCast_SetLevel(&level->view, level->start_x, level->start_y))
+        goto Error;
+
+    if (!RayCast_InitializeHeadless())
+        goto Error;
+
+    context = RayCast_CreateRenderContext();
+    if (context == NULL)
+        goto Error;
+
+    RayCastBench_WaitForTextures();
+
+    double wall_share = (double)level->wall_count / ((double)level->view.size_x * level->view.size_y);
+
+    for (int v = 0; v < config->view_distances.count; v++)
+    {
+        int view_distance = (int)config->view_distances.values[v];
+
+        RayCast_SetViewDistance(view_distance);
+
+        for (int i = 0; i < warmup_frames && i < config->frames; i++)
+            RayCast_RenderPose(context, &poses[i], pixels, pitch);
+
+        uint64_t rays = 0;
+        uint64_t start_time = SDL_GetTicksNS();
+
+        for (int i = 0; i < config->frames; i++)
+        {
+            int rays_traversed = RayCast_RenderPose(context, &poses[i], pixels, pitch);
+            if (rays_traversed > 0)
+                rays += (uint64_t)rays_traversed;
+        }
+
+        double elapsed_s = (SDL_GetTicksNS() - start_time) / 1000000000.0;
+
+        printf("%s,%d,%d,%.3f,%d,%llu,%.4f,%d,%d,%.1f,%.3f,%.3f,%.2f\n",
+            RayCastLevelGen_GetKindName(params->kind), params->size_x, params->size_y, params->density, params->run_length,
+            (unsigned long long)params->seed, wall_share, view_distance, config->frames,
+            (double)rays / config->frames, elapsed_s * 1000.0 / config->frames,
+            (elapsed_s > 0.0) ? (double)rays / elapsed_s / 1000000.0 : 0.0, generate_ms);
+        fflush(stdout);
+    }
+
+    result = true;
+
+Error:
+    RayCast_DestroyRenderContext(context);
+    RayCast_Deinitialize();
+    RayCast_SetViewDistance(0);
+
+    free(pixels);
+    free(poses);
+
+    return result;
+}
+
+int RayCastBench_Run(int argc, char *argv[])
+{
+    RayCastBenchConfig config;
+    if (!RayCastBench_ParseArgs(argc, argv, &config))
+        return 1;
+
+    int exit_code = 0;
+
+    printf("kind,size_x,size_y,density,run_length,seed,wall_share,view_distance,frames,rays_per_frame,ms_per_frame,mrays_per_s,generate_ms\n");
+    fflush(stdout);
+
+    for (int k = 0; k < config.kind_count; k++)
+    {
+        for (int s = 0; s < config.sizes.count; s++)
+        {
+            for (int d = 0; d < config.densities.count; d++)
+            {
+                for (int r = 0; r < config.run_lengths.count; r++)
+                {
+                    for (int e = 0; e < config.seeds.count; e++)
+                    {
+                        RayCastLevelGenParams params;
+                        params.kind = config.kinds[k];
+                        params.size_x = params.size_y = (int)config.sizes.values[s];
+                        params.seed = (uint64_t)config.seeds.values[e];
+                        params.density = (float)config.densities.values[d];
+                        params.run_length = (int)config.run_lengths.values[r];
+
+                        uint64_t generate_start = SDL_GetTicksNS();
+
+                        RayCastGeneratedLevel *level = RayCastLevelGen_Create(&params);
+                        if (level == NULL)
+                        {
+                            exit_code = 1;
+                            continue;
+                        }
+
+                        double generate_ms = (SDL_GetTicksNS() - generate_start) / 1000000.0;
+
+                        if (!RayCastBench_RunLevel(&config, &params, level, generate_ms))
+                            exit_code = 1;
+
+                        RayCastLevelGen_Destroy(level);
+                    }
+                }
+            }
+        }
+    }
+
+    // Leave the engine as a later caller expects it //
+    RayCast_SetLevel(NULL, 0, 0);
+
+    return exit_code;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastEngine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Arguments after --bench, each key=value with comma-separated values, e.g.       //
+    // kind=maze,city size=64,1024,16384 density=0.3 run=8 view=0,32 seed=1 frames=120 //
+    // Every combination is generated and rendered headless, one CSV row each on stdout. //
+    // Returns the exit code.                                                            //
+    extern int RayCastBench_Run(int argc, char *argv[]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,265 @@
+#include "RayCastDoors.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include <SDL3/SDL.h>
+
+typedef struct
+{
+    int32_t cell; // -1 for a free slot //
+    int32_t moving_index; // Into moving_cells, -1 while at rest //
+    uint16_t open;
+    uint16_t target;
+}
+RayCastDoor;
+
+// Open addressing with linear probing; doors are never removed, only reset //
+struct RayCastDoors
+{
+    RayCastDoor *slots;
+    int capacity; // Power of two //
+    int count;
+
+    int32_t *moving_cells;
+    int moving_count;
+    int moving_capacity;
+};
+
+static const int doors_initial_capacity = 64;
+
+static const char program_log_tag[] = "[RayCastDoors.c]";
+
+static inline uint32_t RayCastDoors_Hash(int cell)
+{
+    return (uint32_t)cell * 0x9E3779B1U;
+}
+
+static RayCastDoor *RayCastDoors_Find(const RayCastDoors *doors, int cell)
+{
+    uint32_t mask = (uint32_t)doors->capacity - 1;
+
+    for (uint32_t i = RayCastDoors_Hash(cell) & mask; ; i = (i + 1) & mask)
+    {
+        RayCastDoor *door = &doors->slots[i];
+
+        if (door->cell == cell)
+            return door;
+        if (door->cell < 0)
+            return NULL;
+    }
+}
+
+static RayCastDoor *RayCastDoors_Insert(RayCastDoor *slots, int capacity, int cell)
+{
+    uint32_t mask = (uint32_t)capacity - 1;
+
+    uint32_t i = RayCastDoors_Hash(cell) & mask;
+    while (slots[i].cell >= 0)
+        i = (i + 1) & mask;
+
+    RayCastDoor *door = &slots[i];
+    door->cell = cell;
+    door->moving_index = -1;
+    door->open = 0;
+    door->target = 0;
+
+    return door;
+}
+
+static RayCastDoor *RayCastDoors_Alloc(int capacity)
+{
+    RayCastDoor *slots = (RayCastDoor *)malloc(sizeof(RayCastDoor) * (size_t)capacity);
+    if (slots == NULL)
+        return NULL;
+
+    for (int i = 0; i < capacity; i++)
+        slots[i].cell = -1;
+
+    return slots;
+}
+
+// Kept at most half full, so probes stay short //
+static bool RayCastDoors_Grow(RayCastDoors *doors)
+{
+    int capacity = doors->capacity * 2;
+
+    RayCastDoor *slots = RayCastDoors_Alloc(capacity);
+    if (slots == NULL)
+        return false;
+
+    for (int i = 0; i < doors->capacity; i++)
+    {
+        if (doors->slots[i].cell >= 0)
+            *RayCastDoors_Insert(slots, capacity, doors->slots[i].cell) = doors->slots[i];
+    }
+
+    free(doors->slots);
+    doors->slots = slots;
+    doors->capacity = capacity;
+
+    return true;
+}
+
+static void RayCastDoors_StopMoving(RayCastDoors *doors, RayCastDoor *door)
+{
+    if (door->moving_index < 0)
+        return;
+
+    // Swapped with the last moving door, which keeps its index up to date //
+    int last_cell = doors->moving_cells[--doors->moving_count];
+    doors->moving_cells[door->moving_index] = last_cell;
+
+    RayCastDoor *last_door = RayCastDoors_Find(doors, last_cell);
+    last_door->moving_index = door->moving_index;
+
+    door->moving_index = -1;
+}
+
+RayCastDoors *RayCastDoors_Create(void)
+{
+    RayCastDoors *doors = (RayCastDoors *)calloc(1, sizeof(RayCastDoors));
+    if (doors == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for doors", program_log_tag);
+        return NULL;
+    }
+
+    doors->slots = RayCastDoors_Alloc(doors_initial_capacity);
+    if (doors->slots == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for door table", program_log_tag);
+        free(doors);
+        return NULL;
+    }
+
+    doors->capacity = doors_initial_capacity;
+
+    return doors;
+}
+
+void RayCastDoors_Destroy(RayCastDoors *doors)
+{
+    if (doors == NULL)
+        return;
+
+    free(doors->slots);
+    free(doors->moving_cells);
+    free(doors);
+}
+
+int RayCastDoors_GetOpen(const RayCastDoors *doors, int cell)
+{
+    if (doors == NULL)
+        return 0;
+
+    const RayCastDoor *door = RayCastDoors_Find(doors, cell);
+
+    return (door != NULL) ? door->open : 0;
+}
+
+bool RayCastDoors_IsOpening(const RayCastDoors *doors, int cell)
+{
+    if (doors == NULL)
+        return false;
+
+    const RayCastDoor *door = RayCastDoors_Find(doors, cell);
+
+    return (door != NULL && door->target == RAYCAST_DOOR_OPEN);
+}
+
+bool RayCastDoors_SetTarget(RayCastDoors *doors, int cell, bool open)
+{
+    if (doors == NULL || cell < 0)
+        return false;
+
+    RayCastDoor *door = RayCastDoors_Find(doors, cell);
+
+    if (door == NULL)
+    {
+        // Shut and never touched is what a missing door reads as already //
+        if (!open)
+            return true;
+
+        if ((doors->count + 1) * 2 > doors->capacity && !RayCastDoors_Grow(doors))
+            return false;
+
+        door = RayCastDoors_Insert(doors->slots, doors->capacity, cell);
+        doors->count++;
+    }
+
+    door->target = open ? RAYCAST_DOOR_OPEN : 0;
+
+    if (door->open == door->target || door->moving_index >= 0)
+        return true;
+
+    if (doors->moving_count == doors->moving_capacity)
+    {
+        int moving_capacity = (doors->moving_capacity > 0) ? doors->moving_capacity * 2 : 16;
+
+        int32_t *moving_cells = (int32_t *)realloc(doors->moving_cells, sizeof(int32_t) * (size_t)moving_capacity);
+        if (moving_cells == NULL)
+            return false;
+
+        doors->moving_cells = moving_cells;
+        doors->moving_capacity = moving_capacity;
+    }
+
+    door->moving_index = doors->moving_count;
+    doors->moving_cells[doors->moving_count++] = cell;
+
+    return true;
+}
+
+void RayCastDoors_Reset(RayCastDoors *doors, int cell)
+{
+    if (doors == NULL)
+        return;
+
+    RayCastDoor *door = RayCastDoors_Find(doors, cell);
+    if (door == NULL)
+        return;
+
+    RayCastDoors_StopMoving(doors, door);
+
+    door->open = 0;
+    door->target = 0;
+}
+
+void RayCastDoors_Clear(RayCastDoors *doors)
+{
+    if (doors == NULL)
+        return;
+
+    for (int i = 0; i < doors->capacity; i++)
+        doors->slots[i].cell = -1;
+
+    doors->count = 0;
+    doors->moving_count = 0;
+}
+
+int RayCastDoors_Step(RayCastDoors *doors, int step)
+{
+    if (doors == NULL)
+        return 0;
+
+    int moved = doors->moving_count;
+
+    // Backwards, a door that arrives swaps in one already stepped //
+    for (int i = doors->moving_count - 1; i >= 0; i--)
+    {
+        RayCastDoor *door = RayCastDoors_Find(doors, doors->moving_cells[i]);
+
+        if (door->open < door->target)
+            door->open = (uint16_t)((door->target - door->open > step) ? door->open + step : door->target);
+        else
+            door->open = (uint16_t)((door->open - door->target > step) ? door->open - step : door->target);
+
+        if (door->open == door->target)
+            RayCastDoors_StopMoving(doors, door);
+    }
+
+    return moved;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// How far a door is open, in this many steps from shut to clear of the cell //
+#define RAYCAST_DOOR_OPEN   256
+
+typedef struct RayCastDoors RayCastDoors;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Keyed by cell and sparse, a door nobody has touched takes no space and reads as shut //
+    extern RayCastDoors *RayCastDoors_Create(void);
+    extern void RayCastDoors_Destroy(RayCastDoors *doors);
+
+    extern int RayCastDoors_GetOpen(const RayCastDoors *doors, int cell);
+    extern bool RayCastDoors_IsOpening(const RayCastDoors *doors, int cell);
+
+    // The door slides there over the following steps. False when out of memory //
+    extern bool RayCastDoors_SetTarget(RayCastDoors *doors, int cell, bool open);
+
+    // Shuts the door at once, for a cell that was rebuilt //
+    extern void RayCastDoors_Reset(RayCastDoors *doors, int cell);
+
+    // Every door shut and at rest, as right after creation //
+    extern void RayCastDoors_Clear(RayCastDoors *doors);
+
+    // Moves every door that is not where it is headed; returns how many moved. //
+    // Costs the moving doors only, however many doors the level has.          //
+    extern int RayCastDoors_Step(RayCastDoors *doors, int step);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,31 +2,110 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <malloc.h>
+#include <memory.h>
 #include <math.h>
 
 #include <SDL3/SDL.h>
 
+#include "RayCastEngine.h"
 #include "KeyStatesSDL.h"
 #include "WindowCreationSDL.h"
+#include "TextureCacheSDL.h"
+#include "FrameCaptureSDL.h"
+#include "RayCastSpans.h"
+#include "RayCastLevel.h"
+#include "RayCastLightMap.h"
+#include "RayCastPVS.h"
+#include "RayCastArena.h"
+#include "RayCastFixed.h"
+#include "RayCastUpscale.h"
+#include "RayCastSnapshot.h"
+#include "RayCastPerf.h"
+#include "RayCastDoors.h"
 
 #define SCREEN_WIDTH    512
 #define SCREEN_HEIGHT   384
 #define CHANNELS        3
 #define SCALE_FACTOR    2
 
+#if CHANNELS == 4
+#define PIXEL_FORMAT    SDL_PIXELFORMAT_XRGB8888
+#else
+#define PIXEL_FORMAT    SDL_PIXELFORMAT_BGR24
+#endif
+
 #define LEVEL_SIZE_X    8
 #define LEVEL_SIZE_Y    8
 
+#define MATERIAL_COUNT  6
+
+#define MAX_COLUMN_LAYERS   8
+
+// Edge columns get this many extra rays, spread evenly across the pixel //
+#define AA_SUBSAMPLES   2
+
+// 1 = Traversal, Camera And Movement In 16.16 Fixed Point, Bit-Identical On Every Host //
+#ifndef RAYCAST_FIXED_POINT
+#define RAYCAST_FIXED_POINT 0
+#endif
+
 const char window_title[] = "RayCast Demo qwq";
 
 const int screen_width = SCREEN_WIDTH;
 const int screen_height = SCREEN_HEIGHT;
 const int screen_channels = CHANNELS;
 const int scale_factor = SCALE_FACTOR;
+const SDL_PixelFormat screen_pixel_format = PIXEL_FORMAT;
 
 const char wall_texture_name[] = "bricks.png";
 
+// Indexed by the cell value in level_cells, 0 is empty space //
+const char *const material_texture_names[MATERIAL_COUNT] =
+{
+    NULL,
+    "bricks.bmp",
+    NULL,
+    NULL,
+    "bricks.bmp",
+    "bricks.bmp"
+};
+const uint8_t boundary_material = 1;
+
+typedef enum
+{
+    MATERIAL_OPAQUE,
+    MATERIAL_MIRROR,    // Spawns a ray reflected off the face //
+    MATERIAL_GLASS,     // Spawns a ray carrying on through the cell //
+    MATERIAL_DOOR_X,    // A panel that slides left out of the cell as it opens //
+    MATERIAL_DOOR_Y     // A panel that slides up out of the cell as it opens //
+}
+RayCastMaterialKind;
+
+typedef struct
+{
+    RayCastMaterialKind kind;
+    int secondary_weight; // Out of 256, how much of the secondary ray shows over the face //
+}
+RayCastMaterial;
+
+// Same indices as the texture names; untextured faces are flat, so mirrors //
+// look silvered and glass tinted wherever the secondary ray is not drawn.  //
+const RayCastMaterial materials[MATERIAL_COUNT] =
+{
+    { MATERIAL_OPAQUE, 0 },
+    { MATERIAL_OPAQUE, 0 },
+    { MATERIAL_MIRROR, 208 },
+    { MATERIAL_GLASS, 176 },
+    { MATERIAL_DOOR_X, 0 },
+    { MATERIAL_DOOR_Y, 0 }
+};
+
+const size_t texture_cache_budget = 32 * 1024 * 1024;
+
 const float fade_distance = 8.0F;
 
 const float half_fov = 40.0F / 180.0F * (float)M_PI;
@@ -39,51 +118,399 @@ const float player_vel_sprint_per_tick = 0.05F;
 const float player_accel_per_tick = 0.0025F;
 const float player_fraction = 0.8F;
 
-const uint8_t level_data[LEVEL_SIZE_X][LEVEL_SIZE_Y] =
+// The Built-In Level, Used Unless RayCast_SetLevel Picks Another //
+
+const uint8_t demo_level_data[LEVEL_SIZE_X][LEVEL_SIZE_Y] =
 {
     { 1, 1, 1, 1, 1, 1, 1, 1 },
-    { 1, 0, 1, 0, 0, 0, 0, 1 },
-    { 1, 0, 0, 0, 0, 1, 0, 1 },
+    { 1, 0, 5, 0, 0, 0, 0, 1 },
     { 1, 0, 0, 0, 0, 1, 0, 1 },
-    { 1, 0, 0, 0, 0, 0, 0, 1 },
-    { 1, 0, 0, 0, 1, 1, 1, 1 },
+    { 1, 0, 0, 0, 0, 1, 0, 2 },
+    { 1, 0, 0, 0, 0, 0, 0, 2 },
+    { 1, 0, 0, 0, 3, 1, 1, 1 },
     { 1, 1, 0, 0, 0, 0, 0, 1 },
     { 1, 1, 1, 1, 1, 1, 1, 1 }
 };
-const int level_size_x = LEVEL_SIZE_X;
-const int level_size_y = LEVEL_SIZE_Y;
+// In sixteenths of a cell, only read for wall cells //
+const uint8_t demo_level_height_data[LEVEL_SIZE_X][LEVEL_SIZE_Y] =
+{
+    { 16, 16, 16, 16, 16, 16, 16, 16 },
+    { 16,  0, 16,  0,  0,  0,  0, 16 },
+    { 16,  0,  0,  0,  0,  6,  0, 16 },
+    { 16,  0,  0,  0,  0, 10,  0, 16 },
+    { 16,  0,  0,  0,  0,  0,  0, 16 },
+    { 16,  0,  0,  0, 16, 16, 16, 16 },
+    { 16, 16,  0,  0,  0,  0,  0, 16 },
+    { 16, 32, 32, 32, 32, 32, 32, 32 }
+};
+const float level_height_unit = 1.0F / 16.0F;
+
+const RayCastLight demo_level_lights[] =
+{
+    { 1.5F, 1.5F, 0.8F, 5.0F, 1.0F },
+    { 6.5F, 4.5F, 0.8F, 5.0F, 0.9F },
+    { 3.5F, 6.5F, 0.8F, 4.0F, 0.8F }
+};
+const int demo_level_light_count = sizeof(demo_level_lights) / sizeof(demo_level_lights[0]);
+
+const int max_dynamic_lights = 4;
+const int lantern_light_id = 0;
+const float lantern_radius = 3.0F;
+const float lantern_intensity = 0.6F;
+
+// Matches the tick rate in main.c, skipped frames are repeated to keep it //
+const int capture_frame_rate = 60;
+const int capture_slot_count = 8;
+const char capture_path_env[] = "RAYCAST_CAPTURE";
+
+// "surface" skips the renderer and upscales straight into the window surface //
+const char present_mode_env[] = "RAYCAST_PRESENT";
+
+// About four seconds of ticks to rewind through //
+const int snapshot_ring_capacity = 256;
+const int rewind_ticks = 60;
+const char snapshot_path[] = "snapshot.bin";
+
+// Hardware counters per tick stage, written as CSV to the path in this variable //
+const char perf_csv_env[] = "RAYCAST_PERF";
+
+typedef enum
+{
+    PERF_STAGE_EVENTS,
+    PERF_STAGE_LEVEL,
+    PERF_STAGE_MOVEMENT,
+    PERF_STAGE_SNAPSHOT,
+    PERF_STAGE_TEXTURES,
+    PERF_STAGE_CAST,
+    PERF_STAGE_FILL,
+    PERF_STAGE_PRESENT,
+    PERF_STAGE_COUNT
+}
+RayCastPerfStage;
+
+const char *const perf_stage_names[PERF_STAGE_COUNT] =
+{
+    "events",
+    "level",
+    "movement",
+    "snapshot",
+    "textures",
+    "cast",
+    "fill",
+    "present"
+};
 
 const float player_wall_inside_threshold = 0.4F;
 const float player_block_offset = 0.0001F;
 
-const float player_start_x = 3;
-const float player_start_y = 3;
+const int demo_player_start_x = 3;
+const int demo_player_start_y = 3;
 
 const float ray_unstable_threshold = 0.0001F;
 
 const float z_cutoff = 0.0001F;
 
+const int adaptive_span_size = 16;
+
+const int max_column_layers = MAX_COLUMN_LAYERS;
+
+// Neighboring front hits further apart than this share of the nearer depth are an edge //
+const float aa_depth_threshold = 0.1F;
+
+// Secondary rays per frame, shared by every mirror and glass face in the view; //
+// a ray spawned this many faces deep spawns no more.                           //
+const int max_secondary_rays = 1024;
+const int max_secondary_bounces = 4;
+
+// Level edits queued between ticks; past this many the rest are refused until the next tick //
+#define MAX_LEVEL_EDITS 256
+
+// A door takes a little over half a second to slide, and can only be walked through fully open //
+const int door_step_per_tick = 8;
+
+// Stale PVS sets rebaked per tick after an edit, so a large edit spreads over several ticks //
+const int pvs_rebake_per_tick = 8;
+
+#if RAYCAST_FIXED_POINT
+// The tuning values above as 16.16 integers, written out so no compiler rounds them //
+const RayCastAngle half_fov_angle = 7282;                   // 40 degrees //
+const RayCastAngle player_turn_speed_angle = 455;           // 2.5 degrees //
+
+const RayCastFixed player_vel_walk_fixed = 1638;            // 0.025 //
+const RayCastFixed player_vel_sprint_fixed = 3277;          // 0.05 //
+const RayCastFixed player_accel_fixed = 164;                // 0.0025 //
+const RayCastFixed player_fraction_fixed = 52429;           // 0.8 //
+const RayCastFixed player_stop_threshold_fixed = 7;         // 0.0001 //
+
+const RayCastFixed player_wall_inside_threshold_fixed = 26214;  // 0.4 //
+const RayCastFixed player_block_offset_fixed = 7;           // 0.0001 //
+
+const RayCastFixed level_height_unit_fixed = RAYCAST_FIXED_ONE / 16;
+
+const RayCastFixed z_cutoff_fixed = 7;                      // 0.0001 //
+
+// Walls taller than this many screens all cover the window the same way //
+const int max_bar_screens = 1024;
+#endif
+
+typedef struct
+{
+    float pos_x, pos_y;
+    float angle;
+    float dir_x, dir_y;
+
+    int cell_x, cell_y;
+
+    float max_norm_offset_x;
+    float half_screen_width;
+
+    float height_z_one;
+    float middle_y;
+
+#if RAYCAST_FIXED_POINT
+    struct
+    {
+        RayCastFixed pos_x, pos_y;
+        RayCastFixed dir_x, dir_y;
+        RayCastFixed plane_x, plane_y;
+
+        int64_t height_z_one;
+        int64_t middle_y;
+    }
+    fixed;
+#endif
+}
+RayCastCamera;
+
 static float player_x, player_y;
 static float player_vel_x, player_vel_y;
 static float player_angle;
 
-static float *z_list;
-static float *texture_x_list;
+#if RAYCAST_FIXED_POINT
+// Authoritative player state; the float player_* above are views of it for everything else //
+typedef struct
+{
+    RayCastFixed x, y;
+    RayCastFixed vel_x, vel_y;
+    RayCastAngle angle;
+}
+RayCastPlayerFixed;
+
+static RayCastPlayerFixed player_fixed;
+#endif
+
+// Column Hit Records, Structure Of Arrays //
+// Layer-major, (layer * column_stride) + x; every layer row starts on a cache line //
+typedef struct
+{
+    float *depth;
+    float *u;
+    float *height;
+    float *fog;
+    int32_t *cell;
+    int32_t *secondary; // Hit slot holding the secondary ray of a mirror or glass hit, -1 for none //
+    uint8_t *face;
+    uint8_t *material;
+    uint8_t *layer_count;
+}
+RayCastColumnHits;
+
+// One ray through the grid. Secondary rays start on the face that spawned them and carry //
+// the depth reached there, so every hit records how deep its image lies from the camera. //
+typedef struct
+{
+#if RAYCAST_FIXED_POINT
+    RayCastFixed pos_x, pos_y;
+    RayCastFixed dir_x, dir_y;
+
+    int64_t depth;
+#else
+    float pos_x, pos_y;
+    float angle;
+    float dir_x, dir_y;
+
+    float depth;
+    float depth_dir_x, depth_dir_y; // The camera's forward, mirrored along with the ray //
+#endif
+
+    int cell_x, cell_y;
+    int bounces;
+}
+RayCastRay;
+
+typedef struct
+{
+    int slot;
+    int layer;
+    RayCastRay ray;
+}
+RayCastSecondaryRay;
+
+static size_t frame_arena_size;
+static int column_stride;
+
+// Hit slots from here on hold secondary rays, in the order they were traced //
+static int secondary_slot_base;
+static int secondary_queue_capacity;
+
+// Everything one view needs while it is cast and filled; one per rendering thread //
+struct RayCastRenderContext
+{
+    RayCastArena *arena;
+    RayCastColumnHits hits;
+    int rays_traversed;
+    int aa_rays;
+
+    // Spawned by mirror and glass hits, waiting for the pass that cast them to finish //
+    RayCastSecondaryRay *secondary_queue;
+    int secondary_queue_count;
+
+    int secondary_rays;
+    int secondary_skipped;
+};
+
+static RayCastRenderContext *main_context = NULL;
+
+// Resolved on the main thread before filling, the texture cache is not thread-safe //
+static SDL_Surface *frame_materials[MATERIAL_COUNT];
+
+// The Level Being Played, Cells Row-Major //
+// Copied from the source when initializing; edits only ever change the copy //
+static const uint8_t *level_source_cells = &demo_level_data[0][0];
+static const uint8_t *level_source_heights = &demo_level_height_data[0][0];
+static uint8_t *level_cells = NULL;
+static uint8_t *level_heights = NULL;
+static int level_size_x = LEVEL_SIZE_X;
+static int level_size_y = LEVEL_SIZE_Y;
+
+static const RayCastLight *level_lights = demo_level_lights;
+static int level_light_count = sizeof(demo_level_lights) / sizeof(demo_level_lights[0]);
+
+static int player_start_x = 3;
+static int player_start_y = 3;
+
+// Cells from the camera on either axis before a ray gives up, 0 for no limit //
+static int view_distance = 0;
+
+static float level_max_height;
+#if RAYCAST_FIXED_POINT
+static RayCastFixed level_max_height_fixed;
+#endif
+
+// Wall cells of each height, so the tallest wall is known again after an edit without a scan //
+static int level_height_counts[256];
+
+// Doors may stand open, the PVS looks past them rather than rebake as they move //
+static uint8_t material_see_through[MATERIAL_COUNT];
+
+static RayCastDoors *doors = NULL;
+
+typedef enum
+{
+    LEVEL_EDIT_CELL,
+    LEVEL_EDIT_DOOR
+}
+RayCastLevelEditKind;
+
+typedef struct
+{
+    RayCastLevelEditKind kind;
+    int cell;
+    uint8_t material;
+    uint8_t height;
+    bool open;
+
+    uint64_t tick; // Set once applied //
+    uint64_t hash; // Of the edits applied up to this one, with their ticks //
+}
+RayCastLevelEdit;
+
+// Every edit since the level was loaded. The ones from level_edit_applied on are queued, //
+// applied together at the start of the next tick so a frame never shows half a batch.    //
+// Snapshots name a point along it, restoring one replays the level up to there.          //
+static RayCastLevelEdit *level_edits = NULL;
+static int level_edit_count = 0;
+static int level_edit_capacity = 0;
+static int level_edit_applied = 0;
+
+// The cells as they were before a restore, and the ones it changed //
+static uint8_t *level_restore_cells = NULL;
+static uint8_t *level_restore_heights = NULL;
+static int32_t *level_changed_cells = NULL;
+
+static RayCastLightMap *light_map = NULL;
+static RayCastPVS *pvs = NULL;
+static bool pvs_requested = false; // Set once its bake was tried, whether or not it gave a PVS //
 
 static SDL_Window *window = NULL;
 static SDL_Renderer *renderer = NULL;
 static SDL_Texture *texture = NULL;
 
-static SDL_Surface *wall_texture = NULL;
+// Window Surface Present Path //
+static bool surface_present = false;
+static uint8_t *frame_pixels = NULL;
+static int frame_pitch = 0;
+static SDL_Surface *frame_surface = NULL; // Wraps frame_pixels for the SDL blit fallback //
+static int present_surface_width = 0;
+static int present_surface_height = 0;
+
+static TextureCacheSDL *texture_cache = NULL;
+
+static FrameCaptureSDL *frame_capture = NULL;
+static int capture_index = 0;
 
 static KeyStatesSDL key_states;
 
+// Rollback History //
+static RayCastSnapshotRing *snapshot_ring = NULL;
+static RayCastSnapshot start_snapshot;
+static uint64_t simulation_tick = 0;
+
+static bool fog_enabled = true;
+static bool adaptive_cast_enabled = true;
+static bool stats_log_enabled = false;
+static bool lighting_enabled = true;
+static bool lantern_enabled = false;
+static bool antialias_enabled = false;
+
+// Hardware Counters, NULL Until Asked For //
+static RayCastPerf *perf_counters = NULL;
+static bool perf_overlay_enabled = false;
+
+static RayCastFrameStats frame_stats;
+static RayCastFrameStats stats_log_accum;
+static int stats_log_frames = 0;
+static uint64_t stats_log_last_tick = 0;
+static uint64_t stats_present_ns = 0;
+static int stats_present_count = 0;
+
+// Bumped whenever something outside the camera changes what a frame shows //
+static uint32_t settings_revision = 0;
+static uint32_t level_revision = 0;
+
+typedef struct
+{
+    float player_x, player_y;
+    float player_angle;
+
+    uint32_t settings_revision;
+    uint32_t level_revision;
+    uint32_t lighting_revision;
+}
+RayCastViewState;
+
+static RayCastViewState rendered_view_state;
+static bool frame_dirty = true;
+static bool present_dirty = true;
+static bool frame_skipped = false;
+
 static bool initialized = false;
 
 static bool quit = false;
 
 static const char program_log_tag[] = "[RayCastEngine.c]";
 
+#if !RAYCAST_FIXED_POINT
 static float RayCast_Vec2Len(float x, float y)
 {
     return sqrtf((x * x) + (y * y));
@@ -104,6 +531,7 @@ static void RayCast_VecClampLength(float *x, float *y, float max_length)
         *y *= vec_norm;
     }
 }
+#endif
 
 static inline float RayCast_WrapAngle(float angle)
 {
@@ -118,178 +546,694 @@ static inline float RayCast_WrapAngle(float angle)
     return output;
 }
 
+static inline float RayCast_GetWallHeight(int x, int y)
+{
+    return level_heights[(y * level_size_x) + x] * level_height_unit;
+}
+
 bool RayCast_Initialize(void);
 void RayCast_Deinitialize(void);
 
-bool RayCast_Initialize(void)
+static void RayCast_StartCapture(const char *path);
+
+#if RAYCAST_FIXED_POINT
+static void RayCast_SyncPlayerFromFixed(void);
+#endif
+
+RayCastRenderContext *RayCast_CreateRenderContext(void)
 {
-    if (!SDL_Init(SDL_INIT_VIDEO))
+    RayCastRenderContext *context = (RayCastRenderContext *)malloc(sizeof(RayCastRenderContext));
+    if (context == NULL)
     {
-        SDL_Log("Failed to initialize: %s", SDL_GetError());
-        return false;
+        SDL_Log("%s Failed to allocate memory for render context", program_log_tag);
+        return NULL;
     }
+    memset(context, 0, sizeof(RayCastRenderContext));
 
-    KeyStatesSDL_ClearStates(&key_states);
+    context->arena = RayCastArena_Create(frame_arena_size);
+    if (context->arena == NULL)
+    {
+        SDL_Log("%s Failed to create frame arena", program_log_tag);
+        free(context);
+        return NULL;
+    }
 
-    int pixel_count = screen_width * screen_height;
+    return context;
+}
+
+void RayCast_DestroyRenderContext(RayCastRenderContext *context)
+{
+    if (context == NULL)
+        return;
+
+    RayCastArena_Destroy(context->arena);
+    free(context);
+}
 
-    z_list = (float *)malloc(sizeof(float) * screen_width);
-    if (z_list == NULL)
+bool RayCast_SetLevel(const RayCastLevelView *level, int start_x, int start_y)
+{
+    if (initialized)
     {
-        SDL_Log("%s Failed to allocate memory for z-list", program_log_tag);
+        SDL_Log("%s The level can only be changed before initializing", program_log_tag);
         return false;
     }
 
-    texture_x_list = (float *)malloc(sizeof(float) * screen_width);
-    if (texture_x_list == NULL)
+    if (level == NULL)
     {
-        SDL_Log("%s Failed to allocate memory for texture x-list", program_log_tag);
-        return false;
-    }
+        level_source_cells = &demo_level_data[0][0];
+        level_source_heights = &demo_level_height_data[0][0];
+        level_size_x = LEVEL_SIZE_X;
+        level_size_y = LEVEL_SIZE_Y;
 
-    int window_width = screen_width * scale_factor;
-    int window_height = screen_height * scale_factor;
+        level_lights = demo_level_lights;
+        level_light_count = demo_level_light_count;
 
-    window = WindowCreationSDL_CreateWindowCentered(window_title, window_width, window_height, SDL_WINDOW_HIGH_PIXEL_DENSITY);
-    if (window == NULL)
-    {
-        SDL_Log("%s Failed to create window", program_log_tag);
-        goto Error;
+        player_start_x = demo_player_start_x;
+        player_start_y = demo_player_start_y;
+
+        return true;
     }
-    SDL_SetWindowRelativeMouseMode(window, true);
 
-    renderer = SDL_CreateRenderer(window, NULL);
-    if (renderer == NULL)
+    if (level->size_x < 1 || level->size_y < 1 || level->height_unit != level_height_unit ||
+        start_x < 0 || start_x >= level->size_x || start_y < 0 || start_y >= level->size_y ||
+        level->cells[(start_y * level->size_x) + start_x] != 0)
     {
-        SDL_Log("%s Failed to create renderer: %s", program_log_tag, SDL_GetError());
-        goto Error;
+        SDL_Log("%s Rejected a %dx%d level starting at (%d, %d)", program_log_tag, level->size_x, level->size_y, start_x, start_y);
+        return false;
     }
 
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_BGR24, SDL_TEXTUREACCESS_STREAMING, screen_width, screen_height);
-    if (texture == NULL)
+    // Cell values index the materials, one scan now saves a check per ray //
+    size_t cell_count = (size_t)level->size_x * (size_t)level->size_y;
+    for (size_t i = 0; i < cell_count; i++)
     {
-        SDL_Log("%s Failed to create texture: %s", program_log_tag, SDL_GetError());
-        goto Error;
+        if (level->cells[i] >= MATERIAL_COUNT)
+        {
+            SDL_Log("%s Rejected a level with unknown material %d", program_log_tag, level->cells[i]);
+            return false;
+        }
     }
-    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
-
-    wall_texture = SDL_LoadBMP("bricks.bmp");
-    if (wall_texture == NULL)
-        SDL_Log("%s Failed to load texture for wall: %s", program_log_tag, SDL_GetError());
 
-    player_x = player_start_x + 0.5F;
-    player_y = player_start_y + 0.5F;
-    player_angle = 0;
+    level_source_cells = level->cells;
+    level_source_heights = level->heights;
+    level_size_x = level->size_x;
+    level_size_y = level->size_y;
 
-    quit = false;
+    level_lights = NULL;
+    level_light_count = 0;
 
-    initialized = true;
+    player_start_x = start_x;
+    player_start_y = start_y;
 
     return true;
+}
 
-Error:
-    RayCast_Deinitialize();
+void RayCast_SetViewDistance(int cells)
+{
+    view_distance = (cells > 0) ? cells : 0;
 
-    return false;
+    settings_revision++;
 }
 
-void RayCast_Deinitialize(void)
+static inline bool RayCast_IsDoor(uint8_t material)
 {
-    if (z_list != NULL)
-    {
-        free(z_list);
-        z_list = NULL;
-    }
+    return (materials[material].kind == MATERIAL_DOOR_X || materials[material].kind == MATERIAL_DOOR_Y);
+}
 
-    if (texture_x_list != NULL)
-    {
-        free(texture_x_list);
-        texture_x_list = NULL;
-    }
+static void RayCast_UpdateMaxHeight(void)
+{
+    int max_height = 255;
+    while (max_height > 0 && level_height_counts[max_height] == 0)
+        max_height--;
+
+    level_max_height = max_height * level_height_unit;
+#if RAYCAST_FIXED_POINT
+    level_max_height_fixed = max_height * level_height_unit_fixed;
+#endif
+}
 
-    if (window != NULL)
+static void RayCast_CountHeights(void)
+{
+    size_t cell_count = (size_t)level_size_x * (size_t)level_size_y;
+
+    memset(level_height_counts, 0, sizeof(level_height_counts));
+    for (size_t i = 0; i < cell_count; i++)
     {
-        SDL_DestroyWindow(window);
-        window = NULL;
+        if (level_cells[i] != 0)
+            level_height_counts[level_heights[i]]++;
     }
 
-    if (renderer != NULL)
+    RayCast_UpdateMaxHeight();
+}
+
+// The level as the PVS and lightmap read it, edits land in it in place //
+static void RayCast_GetLevelView(RayCastLevelView *level_view)
+{
+    level_view->size_x = level_size_x;
+    level_view->size_y = level_size_y;
+    level_view->cells = level_cells;
+    level_view->heights = level_heights;
+    level_view->see_through = material_see_through;
+    level_view->height_unit = level_height_unit;
+}
+
+// Baked, or loaded from disk, the first time something needs it, so a run that never  //
+// asks, like the benchmark, neither bakes one nor writes it out. Until then edits     //
+// have nothing to update, the bake starts from the level as it is.                    //
+static RayCastPVS *RayCast_RequirePVS(void)
+{
+    if (!pvs_requested)
     {
-        SDL_DestroyRenderer(renderer);
-        renderer = NULL;
+        pvs_requested = true;
+
+        RayCastLevelView level_view;
+        RayCast_GetLevelView(&level_view);
+
+        pvs = RayCastPVS_Create(&level_view);
+        if (pvs == NULL)
+            SDL_Log("%s No PVS, visibility queries walk the grid", program_log_tag);
     }
 
-    if (texture != NULL)
+    return pvs;
+}
+
+// Everything except the window, shared by the windowed and headless modes //
+static bool RayCast_InitializeWorld(void)
+{
+    // Padded so every float row of the hit records is a whole number of cache lines.     //
+    // The slots past screen_width hold the anti-aliasing rays of one edge column, then the //
+    // secondary rays.                                                                      //
+    secondary_slot_base = screen_width + AA_SUBSAMPLES;
+    column_stride = (int)(RayCastArena_AlignSize(sizeof(float) * (secondary_slot_base + max_secondary_rays)) / sizeof(float));
+
+    size_t layer_slots = (size_t)column_stride * max_column_layers;
+
+    // Every queued ray comes from a different hit recorded since the queue was last emptied //
+    secondary_queue_capacity = (int)layer_slots;
+
+    frame_arena_size =
+        (RayCastArena_AlignSize(sizeof(float) * layer_slots) * 4) +
+        (RayCastArena_AlignSize(sizeof(int32_t) * layer_slots) * 2) +
+        (RayCastArena_AlignSize(sizeof(uint8_t) * layer_slots) * 2) +
+        RayCastArena_AlignSize(sizeof(uint8_t) * column_stride) +
+        RayCastArena_AlignSize(sizeof(RayCastSecondaryRay) * secondary_queue_capacity);
+
+    main_context = RayCast_CreateRenderContext();
+    if (main_context == NULL)
+        return false;
+
+    size_t cell_count = (size_t)level_size_x * (size_t)level_size_y;
+
+    level_cells = (uint8_t *)malloc(cell_count);
+    level_heights = (uint8_t *)malloc(cell_count);
+    level_restore_cells = (uint8_t *)malloc(cell_count);
+    level_restore_heights = (uint8_t *)malloc(cell_count);
+    level_changed_cells = (int32_t *)malloc(sizeof(int32_t) * cell_count);
+    doors = RayCastDoors_Create();
+    if (level_cells == NULL || level_heights == NULL || level_restore_cells == NULL || level_restore_heights == NULL ||
+        level_changed_cells == NULL || doors == NULL)
     {
-        SDL_DestroyTexture(texture);
-        texture = NULL;
+        SDL_Log("%s Failed to allocate memory for level", program_log_tag);
+        return false;
     }
 
-    if (wall_texture != NULL)
+    memcpy(level_cells, level_source_cells, cell_count);
+    memcpy(level_heights, level_source_heights, cell_count);
+
+    RayCast_CountHeights();
+
+    for (int i = 0; i < MATERIAL_COUNT; i++)
+        material_see_through[i] = RayCast_IsDoor((uint8_t)i);
+
+    level_edit_count = 0;
+    level_edit_applied = 0;
+
+    RayCastLevelView level_view;
+    RayCast_GetLevelView(&level_view);
+
+    // Levels without lights, e.g. generated ones, skip the lightmap; its bake would light nothing. //
+    // Both are baked once per level, later runs load them from disk.                               //
+    if (level_light_count > 0)
     {
-        SDL_DestroySurface(wall_texture);
-        wall_texture = NULL;
+        light_map = RayCastLightMap_Create(&level_view, level_lights, level_light_count, max_dynamic_lights, RayCast_RequirePVS());
+        if (light_map == NULL)
+            SDL_Log("%s Failed to create lightmap, walls will be unlit", program_log_tag);
     }
+    else
+        SDL_Log("%s Level has no lights, walls will be unlit", program_log_tag);
 
-    initialized = false;
-}
+    // Textures are decoded on demand by the cache's loader thread //
+    texture_cache = TextureCacheSDL_Create(material_texture_names, MATERIAL_COUNT, screen_pixel_format, texture_cache_budget);
+    if (texture_cache == NULL)
+        SDL_Log("%s Failed to create texture cache, walls will be untextured", program_log_tag);
 
-static bool RayCast_CheckIsWall(int x, int y)
-{
-    if (x < 0 || x >= level_size_x)
-        return true;
+    player_x = player_start_x + 0.5F;
+    player_y = player_start_y + 0.5F;
+    player_angle = 0;
 
-    if (y < 0 || y >= level_size_y)
-        return true;
+#if RAYCAST_FIXED_POINT
+    RayCastFixed_InitTables();
+
+    player_fixed.x = RayCastFixed_FromInt(player_start_x) + RAYCAST_FIXED_HALF;
+    player_fixed.y = RayCastFixed_FromInt(player_start_y) + RAYCAST_FIXED_HALF;
+    player_fixed.vel_x = player_fixed.vel_y = 0;
+    player_fixed.angle = 0;
 
-    return (level_data[y][x] != 0);
+    RayCast_SyncPlayerFromFixed();
+#endif
+
+    // Restarting is restoring this, nothing is reloaded //
+    simulation_tick = 0;
+    RayCast_SaveSnapshot(&start_snapshot);
+
+    snapshot_ring = RayCastSnapshotRing_Create(snapshot_ring_capacity);
+    if (snapshot_ring == NULL)
+        SDL_Log("%s Failed to create snapshot ring, rewinding is disabled", program_log_tag);
+
+    return true;
 }
 
-static void RayCast_PlayerCollisionDetection(void)
+static bool RayCast_AllocateFramePixels(void)
 {
-    const float offset_from_tile_center = 0.5F + player_block_offset;
-
-    float player_x_floor = floorf(player_x);
-    float player_y_floor = floorf(player_y);
-    int player_x_int = (int)player_x_floor;
-    int player_y_int = (int)player_y_floor;
+    frame_pitch = screen_width * screen_channels;
 
-    if (level_data[player_y_int][player_x_int] != 0)
+    frame_pixels = (uint8_t *)malloc((size_t)frame_pitch * screen_height);
+    if (frame_pixels == NULL)
     {
-        float tile_center_x = player_x_floor + 0.5F;
-        float tile_center_y = player_y_floor + 0.5F;
+        SDL_Log("%s Failed to allocate memory for framebuffer", program_log_tag);
+        return false;
+    }
+    memset(frame_pixels, 0, (size_t)frame_pitch * screen_height);
 
-        float tile_center_to_player_x = player_x - tile_center_x;
-        float tile_center_to_player_y = player_y - tile_center_y;
+    return true;
+}
 
-        bool horz_inside = fabsf(tile_center_to_player_x) < player_wall_inside_threshold;
-        bool vert_inside = fabsf(tile_center_to_player_y) < player_wall_inside_threshold;
-        bool both_inside = horz_inside && vert_inside;
+// The frame is rendered into system memory and upscaled on present //
+static bool RayCast_InitializeSurfacePresent(void)
+{
+    if (!RayCast_AllocateFramePixels())
+        return false;
 
-        bool is_wall_l = RayCast_CheckIsWall(player_x_int - 1, player_y_int);
-        bool is_wall_r = RayCast_CheckIsWall(player_x_int + 1, player_y_int);
-        bool is_wall_u = RayCast_CheckIsWall(player_x_int, player_y_int - 1);
-        bool is_wall_d = RayCast_CheckIsWall(player_x_int, player_y_int + 1);
+    frame_surface = SDL_CreateSurfaceFrom(screen_width, screen_height, screen_pixel_format, frame_pixels, frame_pitch);
+    if (frame_surface == NULL)
+    {
+        SDL_Log("%s Failed to create frame surface: %s", program_log_tag, SDL_GetError());
+        return false;
+    }
 
-        bool is_corner;
-        if (tile_center_to_player_x >= 0.0F && tile_center_to_player_y >= 0)
-            is_corner = is_wall_d && is_wall_r;
-        else if (tile_center_to_player_x < 0.0F && tile_center_to_player_y >= 0)
-            is_corner = is_wall_d && is_wall_l;
-        else if (tile_center_to_player_x < 0.0F && tile_center_to_player_y < 0)
-            is_corner = is_wall_u && is_wall_l;
-        else if (tile_center_to_player_x >= 0.0F && tile_center_to_player_y < 0)
-            is_corner = is_wall_u && is_wall_r;
-        else
-            is_corner = true;
+    SDL_Surface *window_surface = SDL_GetWindowSurface(window);
+    if (window_surface == NULL)
+    {
+        SDL_Log("%s Failed to get window surface: %s", program_log_tag, SDL_GetError());
+        return false;
+    }
 
-        bool push_both_dir = both_inside || is_corner;
+    SDL_Log("%s Presenting through the window surface, %s", program_log_tag,
+        RayCastUpscale_IsSupported(screen_pixel_format, window_surface->format) ? "SIMD upscaler" : "SDL blit");
 
-        // Horizontal //
+    return true;
+}
 
-        if (!horz_inside || push_both_dir)
-        {
-            if (tile_center_to_player_x >= 0.0F && (!is_wall_r || push_both_dir))
+bool RayCast_Initialize(void)
+{
+    if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+        SDL_Log("Failed to initialize: %s", SDL_GetError());
+        return false;
+    }
+
+    KeyStatesSDL_ClearStates(&key_states);
+
+    int pixel_count = screen_width * screen_height;
+
+    if (!RayCast_InitializeWorld())
+        goto Error;
+
+    int window_width = screen_width * scale_factor;
+    int window_height = screen_height * scale_factor;
+
+    window = WindowCreationSDL_CreateWindowCentered(window_title, window_width, window_height, SDL_WINDOW_HIGH_PIXEL_DENSITY);
+    if (window == NULL)
+    {
+        SDL_Log("%s Failed to create window", program_log_tag);
+        goto Error;
+    }
+    SDL_SetWindowRelativeMouseMode(window, true);
+
+    // A window surface and a renderer cannot share a window, the choice is made once here //
+    const char *present_mode = SDL_getenv(present_mode_env);
+    surface_present = (present_mode != NULL && SDL_strcasecmp(present_mode, "surface") == 0);
+
+    if (surface_present)
+    {
+        if (!RayCast_InitializeSurfacePresent())
+            goto Error;
+    }
+    else
+    {
+        renderer = SDL_CreateRenderer(window, NULL);
+        if (renderer == NULL)
+        {
+            SDL_Log("%s Failed to create renderer: %s", program_log_tag, SDL_GetError());
+            goto Error;
+        }
+
+        texture = SDL_CreateTexture(renderer, screen_pixel_format, SDL_TEXTUREACCESS_STREAMING, screen_width, screen_height);
+        if (texture == NULL)
+        {
+            SDL_Log("%s Failed to create texture: %s", program_log_tag, SDL_GetError());
+            goto Error;
+        }
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+        // Captured frames are rendered here and uploaded, a locked texture is write-only //
+        if (!RayCast_AllocateFramePixels())
+            goto Error;
+    }
+
+    // Record the whole session, e.g. for QA runs //
+    const char *capture_path = SDL_getenv(capture_path_env);
+    if (capture_path != NULL && capture_path[0] != '\0')
+        RayCast_StartCapture(capture_path);
+
+    const char *perf_csv_path = SDL_getenv(perf_csv_env);
+    if (perf_csv_path != NULL && perf_csv_path[0] != '\0')
+    {
+        perf_counters = RayCastPerf_Create(perf_stage_names, PERF_STAGE_COUNT, perf_csv_path);
+        if (perf_counters == NULL)
+            SDL_Log("%s Failed to start hardware counters", program_log_tag);
+    }
+
+    quit = false;
+
+    frame_dirty = true;
+    present_dirty = true;
+    frame_skipped = false;
+
+    initialized = true;
+
+    return true;
+
+Error:
+    RayCast_Deinitialize();
+
+    return false;
+}
+
+// No window, renderer or input; views are rendered through RayCast_RenderPose //
+bool RayCast_InitializeHeadless(void)
+{
+    if (!SDL_Init(0))
+    {
+        SDL_Log("Failed to initialize: %s", SDL_GetError());
+        return false;
+    }
+
+    if (!RayCast_InitializeWorld())
+    {
+        RayCast_Deinitialize();
+        return false;
+    }
+
+    initialized = true;
+
+    return true;
+}
+
+void RayCast_Deinitialize(void)
+{
+    if (main_context != NULL)
+    {
+        RayCast_DestroyRenderContext(main_context);
+        main_context = NULL;
+    }
+
+    if (window != NULL)
+    {
+        SDL_DestroyWindow(window);
+        window = NULL;
+    }
+
+    if (renderer != NULL)
+    {
+        SDL_DestroyRenderer(renderer);
+        renderer = NULL;
+    }
+
+    if (texture != NULL)
+    {
+        SDL_DestroyTexture(texture);
+        texture = NULL;
+    }
+
+    if (frame_surface != NULL)
+    {
+        SDL_DestroySurface(frame_surface);
+        frame_surface = NULL;
+    }
+
+    if (frame_pixels != NULL)
+    {
+        free(frame_pixels);
+        frame_pixels = NULL;
+    }
+
+    surface_present = false;
+    present_surface_width = 0;
+    present_surface_height = 0;
+
+    if (texture_cache != NULL)
+    {
+        TextureCacheSDL_Destroy(texture_cache);
+        texture_cache = NULL;
+    }
+
+    if (light_map != NULL)
+    {
+        RayCastLightMap_Destroy(light_map);
+        light_map = NULL;
+    }
+
+    if (pvs != NULL)
+    {
+        RayCastPVS_Destroy(pvs);
+        pvs = NULL;
+    }
+    pvs_requested = false;
+
+    if (doors != NULL)
+    {
+        RayCastDoors_Destroy(doors);
+        doors = NULL;
+    }
+
+    if (level_cells != NULL)
+    {
+        free(level_cells);
+        level_cells = NULL;
+    }
+
+    if (level_heights != NULL)
+    {
+        free(level_heights);
+        level_heights = NULL;
+    }
+
+    if (level_restore_cells != NULL)
+    {
+        free(level_restore_cells);
+        level_restore_cells = NULL;
+    }
+
+    if (level_restore_heights != NULL)
+    {
+        free(level_restore_heights);
+        level_restore_heights = NULL;
+    }
+
+    if (level_changed_cells != NULL)
+    {
+        free(level_changed_cells);
+        level_changed_cells = NULL;
+    }
+
+    if (level_edits != NULL)
+    {
+        free(level_edits);
+        level_edits = NULL;
+    }
+
+    level_edit_count = 0;
+    level_edit_capacity = 0;
+    level_edit_applied = 0;
+
+    if (frame_capture != NULL)
+    {
+        FrameCaptureSDL_Destroy(frame_capture);
+        frame_capture = NULL;
+    }
+
+    if (snapshot_ring != NULL)
+    {
+        RayCastSnapshotRing_Destroy(snapshot_ring);
+        snapshot_ring = NULL;
+    }
+
+    if (perf_counters != NULL)
+    {
+        RayCastPerf_Destroy(perf_counters);
+        perf_counters = NULL;
+    }
+    perf_overlay_enabled = false;
+
+    initialized = false;
+}
+
+static bool RayCast_CheckIsOutside(int x, int y)
+{
+    return (x < 0 || x >= level_size_x || y < 0 || y >= level_size_y);
+}
+
+static inline bool RayCast_CheckIsPastView(const RayCastCamera *camera, int x, int y)
+{
+    if (view_distance <= 0)
+        return false;
+
+    return (abs(x - camera->cell_x) > view_distance || abs(y - camera->cell_y) > view_distance);
+}
+
+static bool RayCast_CheckIsWall(int x, int y)
+{
+    if (x < 0 || x >= level_size_x)
+        return true;
+
+    if (y < 0 || y >= level_size_y)
+        return true;
+
+    int cell = (y * level_size_x) + x;
+
+    // A door lets nobody through until it is fully open //
+    if (RayCast_IsDoor(level_cells[cell]))
+        return (RayCastDoors_GetOpen(doors, cell) < RAYCAST_DOOR_OPEN);
+
+    return (level_cells[cell] != 0);
+}
+
+#if RAYCAST_FIXED_POINT
+static void RayCast_PlayerCollisionDetection(void)
+{
+    const RayCastFixed offset_from_tile_center = RAYCAST_FIXED_HALF + player_block_offset_fixed;
+
+    int player_x_int = RayCastFixed_Floor(player_fixed.x);
+    int player_y_int = RayCastFixed_Floor(player_fixed.y);
+
+    if (RayCast_CheckIsWall(player_x_int, player_y_int))
+    {
+        RayCastFixed tile_center_x = RayCastFixed_FromInt(player_x_int) + RAYCAST_FIXED_HALF;
+        RayCastFixed tile_center_y = RayCastFixed_FromInt(player_y_int) + RAYCAST_FIXED_HALF;
+
+        RayCastFixed tile_center_to_player_x = player_fixed.x - tile_center_x;
+        RayCastFixed tile_center_to_player_y = player_fixed.y - tile_center_y;
+
+        bool horz_inside = RayCastFixed_Abs(tile_center_to_player_x) < player_wall_inside_threshold_fixed;
+        bool vert_inside = RayCastFixed_Abs(tile_center_to_player_y) < player_wall_inside_threshold_fixed;
+        bool both_inside = horz_inside && vert_inside;
+
+        bool is_wall_l = RayCast_CheckIsWall(player_x_int - 1, player_y_int);
+        bool is_wall_r = RayCast_CheckIsWall(player_x_int + 1, player_y_int);
+        bool is_wall_u = RayCast_CheckIsWall(player_x_int, player_y_int - 1);
+        bool is_wall_d = RayCast_CheckIsWall(player_x_int, player_y_int + 1);
+
+        bool is_corner;
+        if (tile_center_to_player_x >= 0 && tile_center_to_player_y >= 0)
+            is_corner = is_wall_d && is_wall_r;
+        else if (tile_center_to_player_x < 0 && tile_center_to_player_y >= 0)
+            is_corner = is_wall_d && is_wall_l;
+        else if (tile_center_to_player_x < 0 && tile_center_to_player_y < 0)
+            is_corner = is_wall_u && is_wall_l;
+        else
+            is_corner = is_wall_u && is_wall_r;
+
+        bool push_both_dir = both_inside || is_corner;
+
+        // Horizontal //
+
+        if (!horz_inside || push_both_dir)
+        {
+            if (tile_center_to_player_x >= 0 && (!is_wall_r || push_both_dir))
+            {
+                player_fixed.x = tile_center_x + offset_from_tile_center;
+                player_fixed.vel_x = 0;
+            }
+            else if (tile_center_to_player_x < 0 && (!is_wall_l || push_both_dir))
+            {
+                player_fixed.x = tile_center_x - offset_from_tile_center;
+                player_fixed.vel_x = 0;
+            }
+        }
+
+        // Vertical //
+
+        if (!vert_inside || push_both_dir)
+        {
+            if (tile_center_to_player_y >= 0 && (!is_wall_d || push_both_dir))
+            {
+                player_fixed.y = tile_center_y + offset_from_tile_center;
+                player_fixed.vel_y = 0;
+            }
+            else if (tile_center_to_player_y < 0 && (!is_wall_u || push_both_dir))
+            {
+                player_fixed.y = tile_center_y - offset_from_tile_center;
+                player_fixed.vel_y = 0;
+            }
+        }
+    }
+}
+#else
+static void RayCast_PlayerCollisionDetection(void)
+{
+    const float offset_from_tile_center = 0.5F + player_block_offset;
+
+    float player_x_floor = floorf(player_x);
+    float player_y_floor = floorf(player_y);
+    int player_x_int = (int)player_x_floor;
+    int player_y_int = (int)player_y_floor;
+
+    if (RayCast_CheckIsWall(player_x_int, player_y_int))
+    {
+        float tile_center_x = player_x_floor + 0.5F;
+        float tile_center_y = player_y_floor + 0.5F;
+
+        float tile_center_to_player_x = player_x - tile_center_x;
+        float tile_center_to_player_y = player_y - tile_center_y;
+
+        bool horz_inside = fabsf(tile_center_to_player_x) < player_wall_inside_threshold;
+        bool vert_inside = fabsf(tile_center_to_player_y) < player_wall_inside_threshold;
+        bool both_inside = horz_inside && vert_inside;
+
+        bool is_wall_l = RayCast_CheckIsWall(player_x_int - 1, player_y_int);
+        bool is_wall_r = RayCast_CheckIsWall(player_x_int + 1, player_y_int);
+        bool is_wall_u = RayCast_CheckIsWall(player_x_int, player_y_int - 1);
+        bool is_wall_d = RayCast_CheckIsWall(player_x_int, player_y_int + 1);
+
+        bool is_corner;
+        if (tile_center_to_player_x >= 0.0F && tile_center_to_player_y >= 0)
+            is_corner = is_wall_d && is_wall_r;
+        else if (tile_center_to_player_x < 0.0F && tile_center_to_player_y >= 0)
+            is_corner = is_wall_d && is_wall_l;
+        else if (tile_center_to_player_x < 0.0F && tile_center_to_player_y < 0)
+            is_corner = is_wall_u && is_wall_l;
+        else if (tile_center_to_player_x >= 0.0F && tile_center_to_player_y < 0)
+            is_corner = is_wall_u && is_wall_r;
+        else
+            is_corner = true;
+
+        bool push_both_dir = both_inside || is_corner;
+
+        // Horizontal //
+
+        if (!horz_inside || push_both_dir)
+        {
+            if (tile_center_to_player_x >= 0.0F && (!is_wall_r || push_both_dir))
             {
                 player_x = tile_center_x + offset_from_tile_center;
                 player_vel_x = 0.0F;
@@ -319,550 +1263,2677 @@ static void RayCast_PlayerCollisionDetection(void)
     }
 }
 
-static void RayCast_DoRayCastAndRender(void)
+#endif
+
+// Carves this frame's hit records out of the arena, no heap traffic after startup //
+static bool RayCast_BeginFrameHits(RayCastRenderContext *context)
 {
-    float half_screen_width = screen_width / 2.0F;
+    RayCastArena_Reset(context->arena);
+
+    size_t layer_slots = (size_t)column_stride * max_column_layers;
+
+    context->hits.depth = (float *)RayCastArena_Alloc(context->arena, sizeof(float) * layer_slots);
+    context->hits.u = (float *)RayCastArena_Alloc(context->arena, sizeof(float) * layer_slots);
+    context->hits.height = (float *)RayCastArena_Alloc(context->arena, sizeof(float) * layer_slots);
+    context->hits.fog = (float *)RayCastArena_Alloc(context->arena, sizeof(float) * layer_slots);
+    context->hits.cell = (int32_t *)RayCastArena_Alloc(context->arena, sizeof(int32_t) * layer_slots);
+    context->hits.secondary = (int32_t *)RayCastArena_Alloc(context->arena, sizeof(int32_t) * layer_slots);
+    context->hits.face = (uint8_t *)RayCastArena_Alloc(context->arena, sizeof(uint8_t) * layer_slots);
+    context->hits.material = (uint8_t *)RayCastArena_Alloc(context->arena, sizeof(uint8_t) * layer_slots);
+    context->hits.layer_count = (uint8_t *)RayCastArena_Alloc(context->arena, sizeof(uint8_t) * column_stride);
+    context->secondary_queue = (RayCastSecondaryRay *)RayCastArena_Alloc(context->arena, sizeof(RayCastSecondaryRay) * secondary_queue_capacity);
+
+    context->secondary_queue_count = 0;
+    context->secondary_rays = 0;
+    context->secondary_skipped = 0;
+
+    return (context->secondary_queue != NULL);
+}
 
-    float max_norm_offset_x = tanf(half_fov);
+// Fog brightness for every hit slot in use, four at a time straight from the aligned depth //
+// rows. Slots past a column's layer count hold stale depths and are never read back.       //
+static void RayCast_ComputeFog(RayCastRenderContext *context)
+{
+    // Rows start on cache lines, so rounding up to four stays inside the row //
+    int slot_end = (secondary_slot_base + context->secondary_rays + 3) & ~3;
 
-    float player_dir_x = cosf(player_angle);
-    float player_dir_y = sinf(player_angle);
+    for (int layer = 0; layer < max_column_layers; layer++)
+    {
+        const float *ptr_depth = context->hits.depth + ((size_t)layer * column_stride);
+        float *ptr_fog = context->hits.fog + ((size_t)layer * column_stride);
 
-    float height_z_one = (float)screen_width / (max_norm_offset_x * 2.0F);
+#ifdef SDL_SSE2_INTRINSICS
+        const __m128 fade = _mm_set1_ps(fade_distance);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0F);
 
-    for (int x = 0; x < screen_width; x++)
+        for (int i = 0; i < slot_end; i += 4)
+        {
+            __m128 depth = _mm_load_ps(ptr_depth + i);
+
+            __m128 brightness = _mm_div_ps(_mm_max_ps(_mm_sub_ps(fade, depth), zero), fade);
+
+            _mm_store_ps(ptr_fog + i, _mm_min_ps(brightness, one));
+        }
+#else
+        for (int i = 0; i < slot_end; i++)
+        {
+            float brightness = fmaxf(fade_distance - ptr_depth[i], 0.0F) / fade_distance;
+
+            ptr_fog[i] = fminf(brightness, 1.0F);
+        }
+#endif
+    }
+}
+
+// For slots cast after the fog pass, one at a time //
+static void RayCast_ComputeSlotFog(RayCastRenderContext *context, int slot)
+{
+    for (int layer = 0; layer < context->hits.layer_count[slot]; layer++)
+    {
+        int index = (layer * column_stride) + slot;
+
+        context->hits.fog[index] = fminf(fmaxf(fade_distance - context->hits.depth[index], 0.0F) / fade_distance, 1.0F);
+    }
+}
+
+#if RAYCAST_FIXED_POINT
+static inline RayCastFixed RayCast_GetWallHeightFixed(int x, int y)
+{
+    return level_heights[(y * level_size_x) + x] * level_height_unit_fixed;
+}
+
+static void RayCast_RecordLayerFixed(RayCastRenderContext *context, int x, int layer, int64_t depth, RayCastFixed hit_pos_x, RayCastFixed hit_pos_y, int hit_from_udlr, int hit_cell, uint8_t material, float wall_height)
+{
+    int index = (layer * column_stride) + x;
+
+    // Converted once here, the fill only ever reads floats //
+    context->hits.depth[index] = RayCastFixed_ToFloat(depth);
+    context->hits.material[index] = material;
+    context->hits.face[index] = (uint8_t)hit_from_udlr;
+    context->hits.cell[index] = hit_cell;
+    context->hits.secondary[index] = -1;
+    context->hits.height[index] = wall_height;
+
+    switch (hit_from_udlr)
+    {
+    case 1:
+    case 2:
+        context->hits.u[index] = RayCastFixed_ToFloat(hit_pos_x & RAYCAST_FIXED_FRACTION_MASK);
+        break;
+    case 3:
+    case 4:
+        context->hits.u[index] = RayCastFixed_ToFloat(hit_pos_y & RAYCAST_FIXED_FRACTION_MASK);
+        break;
+    }
+}
+
+// Direction through column x on the camera plane. Its forward component is one, so the //
+// ray parameter at a hit is already the perpendicular depth (to the sine table's error). //
+static void RayCast_GetRayDirFixed(const RayCastCamera *camera, RayCastFixed screen_x, RayCastFixed *ray_dir_x, RayCastFixed *ray_dir_y)
+{
+    RayCastFixed norm_offset_x = (RayCastFixed)(((2 * (int64_t)screen_x) - ((int64_t)screen_width * RAYCAST_FIXED_ONE)) / screen_width);
+
+    *ray_dir_x = camera->fixed.dir_x + RayCastFixed_Mul(camera->fixed.plane_x, norm_offset_x);
+    *ray_dir_y = camera->fixed.dir_y + RayCastFixed_Mul(camera->fixed.plane_y, norm_offset_x);
+}
+
+// Queues the ray a mirror or glass hit spawns, traced once the pass that cast this one is done //
+static void RayCast_QueueSecondary(RayCastRenderContext *context, const RayCastRay *ray, int x, int layer, int64_t depth, RayCastFixed hit_pos_x, RayCastFixed hit_pos_y, int hit_from_udlr, int hit_cell)
+{
+    const RayCastMaterial *material = &materials[level_cells[hit_cell]];
+
+    if ((material->kind != MATERIAL_MIRROR && material->kind != MATERIAL_GLASS) || ray->bounces >= max_secondary_bounces ||
+        context->secondary_queue_count >= secondary_queue_capacity)
+        return;
+
+    RayCastSecondaryRay *secondary = &context->secondary_queue[context->secondary_queue_count++];
+    secondary->slot = x;
+    secondary->layer = layer;
+
+    // Glass carries on from inside its own cell //
+    RayCastRay *next = &secondary->ray;
+    next->pos_x = hit_pos_x;
+    next->pos_y = hit_pos_y;
+    next->dir_x = ray->dir_x;
+    next->dir_y = ray->dir_y;
+    next->depth = depth;
+    next->cell_x = hit_cell % level_size_x;
+    next->cell_y = hit_cell / level_size_x;
+    next->bounces = ray->bounces + 1;
+
+    if (material->kind == MATERIAL_MIRROR)
+    {
+        // Back into the cell the ray came from, the ray parameter still counts depth //
+        switch (hit_from_udlr)
+        {
+        case 1:
+        case 2:
+            next->cell_y += (hit_from_udlr == 1) ? -1 : 1;
+            next->dir_y = -next->dir_y;
+            break;
+        default:
+            next->cell_x += (hit_from_udlr == 3) ? -1 : 1;
+            next->dir_x = -next->dir_x;
+            break;
+        }
+    }
+}
+
+// Where the ray meets the door it just entered at the hit position, false if it only crosses //
+// the open part; the depth grows by however far inside the cell that is. See the float path. //
+static bool RayCast_HitDoorFixed(int hit_cell, RayCastFixed ray_dir_x, RayCastFixed ray_dir_y, RayCastFixed *hit_pos_x, RayCastFixed *hit_pos_y, int64_t *depth, int *hit_from_udlr, float *u_offset)
+{
+    *u_offset = 0.0F;
+
+    int open = RayCastDoors_GetOpen(doors, hit_cell);
+    if (open == 0)
+        return true;
+    if (open == RAYCAST_DOOR_OPEN)
+        return false;
+
+    bool along_x = (materials[level_cells[hit_cell]].kind == MATERIAL_DOOR_X);
+
+    RayCastFixed *along_pos = along_x ? hit_pos_x : hit_pos_y;
+    RayCastFixed *across_pos = along_x ? hit_pos_y : hit_pos_x;
+    RayCastFixed along_dir = along_x ? ray_dir_x : ray_dir_y;
+    RayCastFixed across_dir = along_x ? ray_dir_y : ray_dir_x;
+
+    int along_cell = along_x ? hit_cell % level_size_x : hit_cell / level_size_x;
+    int across_cell = along_x ? hit_cell / level_size_x : hit_cell % level_size_x;
+
+    RayCastFixed edge = RayCastFixed_FromInt(along_cell + 1) - (open * (RAYCAST_FIXED_ONE / RAYCAST_DOOR_OPEN));
+
+    if (*along_pos < edge)
+    {
+        if (along_x ? (*hit_from_udlr <= 2) : (*hit_from_udlr >= 3))
+            *u_offset = open * (1.0F / RAYCAST_DOOR_OPEN);
+        return true;
+    }
+
+    if (along_dir >= 0)
+        return false;
+
+    int64_t t = ((int64_t)(edge - *along_pos) * RAYCAST_FIXED_ONE) / along_dir;
+
+    RayCastFixed across = *across_pos + (RayCastFixed)RayCastFixed_Mul64(across_dir, t);
+    if (across < RayCastFixed_FromInt(across_cell) || across > RayCastFixed_FromInt(across_cell + 1))
+        return false;
+
+    *along_pos = edge;
+    *across_pos = across;
+    *depth += t;
+
+    *hit_from_udlr = along_x ? 4 : 2;
+    return true;
+}
+
+// Records into hit slot x the hits along the ray //
+static void RayCast_TraceRay(RayCastRenderContext *context, const RayCastCamera *camera, int x, const RayCastRay *ray)
+{
+    RayCastFixed ray_pos_x = ray->pos_x;
+    RayCastFixed ray_pos_y = ray->pos_y;
+
+    RayCastFixed ray_dir_x = ray->dir_x;
+    RayCastFixed ray_dir_y = ray->dir_y;
+
+    int center_pos_x = ray->cell_x;
+    int center_pos_y = ray->cell_y;
+
+    // Ray Parameter Per Cell Crossed, And To The Next Edge On Each Axis //
+
+    const int64_t t_never = INT64_MAX / 2;
+
+    int step_x = 0, step_y = 0;
+    int64_t t_delta_x = t_never, t_delta_y = t_never;
+    int64_t t_next_x = t_never, t_next_y = t_never;
+
+    if (ray_dir_x != 0)
+    {
+        t_delta_x = ((int64_t)RAYCAST_FIXED_ONE * RAYCAST_FIXED_ONE) / RayCastFixed_Abs(ray_dir_x);
+
+        if (ray_dir_x > 0)
+        {
+            step_x = 1;
+            t_next_x = RayCastFixed_Mul64(RayCastFixed_FromInt(center_pos_x + 1) - ray_pos_x, t_delta_x);
+        }
+        else
+        {
+            step_x = -1;
+            t_next_x = RayCastFixed_Mul64(ray_pos_x - RayCastFixed_FromInt(center_pos_x), t_delta_x);
+        }
+    }
+
+    if (ray_dir_y != 0)
+    {
+        t_delta_y = ((int64_t)RAYCAST_FIXED_ONE * RAYCAST_FIXED_ONE) / RayCastFixed_Abs(ray_dir_y);
+
+        if (ray_dir_y > 0)
+        {
+            step_y = 1;
+            t_next_y = RayCastFixed_Mul64(RayCastFixed_FromInt(center_pos_y + 1) - ray_pos_y, t_delta_y);
+        }
+        else
+        {
+            step_y = -1;
+            t_next_y = RayCastFixed_Mul64(ray_pos_y - RayCastFixed_FromInt(center_pos_y), t_delta_y);
+        }
+    }
+
+    // U = 1; D = 2; L = 3; R = 4;
+    int hit_from_udlr = 1;
+
+    int layer_count = 0;
+
+    // Rows Below This Are Already Covered By Nearer Walls //
+    int64_t window_bottom_y = (int64_t)screen_height * RAYCAST_FIXED_ONE;
+
+    const int64_t max_bar_height = (int64_t)screen_height * max_bar_screens * RAYCAST_FIXED_ONE;
+
+    while (true)
+    {
+        int64_t t;
+        RayCastFixed hit_pos_x, hit_pos_y;
+
+        if (t_next_x < t_next_y)
+        {
+            t = t_next_x;
+            t_next_x += t_delta_x;
+
+            center_pos_x += step_x;
+
+            hit_pos_x = RayCastFixed_FromInt((step_x > 0) ? center_pos_x : center_pos_x + 1);
+            hit_pos_y = ray_pos_y + (RayCastFixed)RayCastFixed_Mul64(ray_dir_y, t);
+
+            hit_from_udlr = (step_x > 0) ? 3 : 4;
+        }
+        else
+        {
+            t = t_next_y;
+            t_next_y += t_delta_y;
+
+            center_pos_y += step_y;
+
+            hit_pos_x = ray_pos_x + (RayCastFixed)RayCastFixed_Mul64(ray_dir_x, t);
+            hit_pos_y = RayCastFixed_FromInt((step_y > 0) ? center_pos_y : center_pos_y + 1);
+
+            hit_from_udlr = (step_y > 0) ? 1 : 2;
+        }
+
+        // Counted from the camera, past every face the ray came by //
+        int64_t depth = ray->depth + t;
+
+        if (RayCast_CheckIsOutside(center_pos_x, center_pos_y) || RayCast_CheckIsPastView(camera, center_pos_x, center_pos_y))
+        {
+            // Left The Level Or The View, Treat As A Wall That Hides Everything //
+            RayCast_RecordLayerFixed(context, x, layer_count, depth, hit_pos_x, hit_pos_y, hit_from_udlr, -1, boundary_material, level_max_height);
+            layer_count++;
+            break;
+        }
+        else if (level_cells[(center_pos_y * level_size_x) + center_pos_x] != 0)
+        {
+            RayCastFixed wall_height = RayCast_GetWallHeightFixed(center_pos_x, center_pos_y);
+
+            int hit_cell = (center_pos_y * level_size_x) + center_pos_x;
+
+            float u_offset = 0.0F;
+            if (RayCast_IsDoor(level_cells[hit_cell]) &&
+                !RayCast_HitDoorFixed(hit_cell, ray_dir_x, ray_dir_y, &hit_pos_x, &hit_pos_y, &depth, &hit_from_udlr, &u_offset))
+                continue;
+
+            RayCast_RecordLayerFixed(context, x, layer_count, depth, hit_pos_x, hit_pos_y, hit_from_udlr,
+                hit_cell, level_cells[hit_cell], RayCast_GetWallHeight(center_pos_x, center_pos_y));
+            if (u_offset != 0.0F)
+                context->hits.u[(layer_count * column_stride) + x] += u_offset;
+            RayCast_QueueSecondary(context, ray, x, layer_count, depth, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell);
+            layer_count++;
+
+            if (depth < z_cutoff_fixed || layer_count >= max_column_layers)
+                break;
+
+            int64_t bar_height = (camera->fixed.height_z_one * RAYCAST_FIXED_ONE) / depth;
+            if (bar_height > max_bar_height)
+                bar_height = max_bar_height;
+
+            int64_t wall_top_y = camera->fixed.middle_y + RayCastFixed_Mul64(bar_height, RAYCAST_FIXED_HALF - wall_height);
+            if (wall_top_y < window_bottom_y)
+                window_bottom_y = wall_top_y;
+
+            // Same early out as the float path //
+            int64_t highest_top_y = camera->fixed.middle_y;
+            if (level_max_height_fixed > RAYCAST_FIXED_HALF)
+                highest_top_y += RayCastFixed_Mul64(bar_height, RAYCAST_FIXED_HALF - level_max_height_fixed);
+
+            if (window_bottom_y <= highest_top_y)
+                break;
+        }
+    }
+
+    context->hits.layer_count[x] = (uint8_t)layer_count;
+}
+
+// Records into hit slot x the ray through screen position screen_x, which need not be whole //
+static void RayCast_CastRay(RayCastRenderContext *context, const RayCastCamera *camera, int x, RayCastFixed screen_x)
+{
+    RayCastRay ray;
+    ray.pos_x = camera->fixed.pos_x;
+    ray.pos_y = camera->fixed.pos_y;
+    ray.depth = 0;
+    ray.cell_x = RayCastFixed_Floor(ray.pos_x);
+    ray.cell_y = RayCastFixed_Floor(ray.pos_y);
+    ray.bounces = 0;
+
+    RayCast_GetRayDirFixed(camera, screen_x, &ray.dir_x, &ray.dir_y);
+
+    RayCast_TraceRay(context, camera, x, &ray);
+}
+
+static inline void RayCast_CastColumn(RayCastRenderContext *context, const RayCastCamera *camera, int x)
+{
+    RayCast_CastRay(context, camera, x, RayCastFixed_FromInt(x));
+}
+
+// Same face plane solve as the float path, see below //
+static void RayCast_InterpolateColumn(RayCastRenderContext *context, const RayCastCamera *camera, int x, int x_from)
+{
+    RayCastFixed ray_dir_x, ray_dir_y;
+    RayCast_GetRayDirFixed(camera, RayCastFixed_FromInt(x), &ray_dir_x, &ray_dir_y);
+
+    int hit_cell = context->hits.cell[x_from];
+    int hit_from_udlr = context->hits.face[x_from];
+
+    int cell_x = hit_cell % level_size_x;
+    int cell_y = hit_cell / level_size_x;
+
+    RayCastFixed hit_pos_x, hit_pos_y;
+    int64_t t;
+
+    switch (hit_from_udlr)
+    {
+    case 1:
+    case 2:
+        if (ray_dir_y == 0)
+        {
+            RayCast_CastColumn(context, camera, x);
+            return;
+        }
+
+        hit_pos_y = RayCastFixed_FromInt((hit_from_udlr == 1) ? cell_y : cell_y + 1);
+        t = ((int64_t)(hit_pos_y - camera->fixed.pos_y) * RAYCAST_FIXED_ONE) / ray_dir_y;
+        hit_pos_x = camera->fixed.pos_x + (RayCastFixed)RayCastFixed_Mul64(ray_dir_x, t);
+        break;
+    default:
+        if (ray_dir_x == 0)
+        {
+            RayCast_CastColumn(context, camera, x);
+            return;
+        }
+
+        hit_pos_x = RayCastFixed_FromInt((hit_from_udlr == 3) ? cell_x : cell_x + 1);
+        t = ((int64_t)(hit_pos_x - camera->fixed.pos_x) * RAYCAST_FIXED_ONE) / ray_dir_x;
+        hit_pos_y = camera->fixed.pos_y + (RayCastFixed)RayCastFixed_Mul64(ray_dir_y, t);
+        break;
+    }
+
+    RayCast_RecordLayerFixed(context, x, 0, t, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell, context->hits.material[x_from], context->hits.height[x_from]);
+
+    RayCastRay ray;
+    ray.dir_x = ray_dir_x;
+    ray.dir_y = ray_dir_y;
+    ray.bounces = 0;
+
+    RayCast_QueueSecondary(context, &ray, x, 0, t, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell);
+
+    context->hits.layer_count[x] = 1;
+}
+#else
+static float RayCast_RecordLayer(RayCastRenderContext *context, const RayCastRay *ray, int x, int layer, float hit_pos_x, float hit_pos_y, int hit_from_udlr, int hit_cell, uint8_t material, float wall_height)
+{
+    int index = (layer * column_stride) + x;
+
+    float ray_from_to_x = hit_pos_x - ray->pos_x;
+    float ray_from_to_y = hit_pos_y - ray->pos_y;
+
+    float z_from_player = (ray_from_to_x * ray->depth_dir_x) + (ray_from_to_y * ray->depth_dir_y);
+    z_from_player += ray->depth;
+
+    context->hits.depth[index] = z_from_player;
+    context->hits.material[index] = material;
+    context->hits.face[index] = (uint8_t)hit_from_udlr;
+    context->hits.cell[index] = hit_cell;
+    context->hits.secondary[index] = -1;
+    context->hits.height[index] = wall_height;
+
+    switch (hit_from_udlr)
+    {
+    case 1:
+    case 2:
+        context->hits.u[index] = fmodf(hit_pos_x, 1.0F);
+        break;
+    case 3:
+    case 4:
+        context->hits.u[index] = fmodf(hit_pos_y, 1.0F);
+        break;
+    }
+
+    return z_from_player;
+}
+
+// Queues the ray a mirror or glass hit spawns, traced once the pass that cast this one is done //
+static void RayCast_QueueSecondary(RayCastRenderContext *context, const RayCastRay *ray, int x, int layer, float depth, float hit_pos_x, float hit_pos_y, int hit_from_udlr, int hit_cell)
+{
+    const RayCastMaterial *material = &materials[level_cells[hit_cell]];
+
+    if ((material->kind != MATERIAL_MIRROR && material->kind != MATERIAL_GLASS) || ray->bounces >= max_secondary_bounces ||
+        context->secondary_queue_count >= secondary_queue_capacity)
+        return;
+
+    RayCastSecondaryRay *secondary = &context->secondary_queue[context->secondary_queue_count++];
+    secondary->slot = x;
+    secondary->layer = layer;
+
+    // Glass carries on from inside its own cell //
+    RayCastRay *next = &secondary->ray;
+    *next = *ray;
+    next->pos_x = hit_pos_x;
+    next->pos_y = hit_pos_y;
+    next->depth = depth;
+    next->cell_x = hit_cell % level_size_x;
+    next->cell_y = hit_cell / level_size_x;
+    next->bounces = ray->bounces + 1;
+
+    if (material->kind == MATERIAL_MIRROR)
+    {
+        // Back into the cell the ray came from; the camera's forward is mirrored too, //
+        // which keeps the depths those of the image behind the mirror                 //
+        switch (hit_from_udlr)
+        {
+        case 1:
+        case 2:
+            next->cell_y += (hit_from_udlr == 1) ? -1 : 1;
+            next->angle = RayCast_WrapAngle(-ray->angle);
+            next->dir_y = -next->dir_y;
+            next->depth_dir_y = -next->depth_dir_y;
+            break;
+        default:
+            next->cell_x += (hit_from_udlr == 3) ? -1 : 1;
+            next->angle = RayCast_WrapAngle((float)M_PI - ray->angle);
+            next->dir_x = -next->dir_x;
+            next->depth_dir_x = -next->depth_dir_x;
+            break;
+        }
+    }
+}
+
+static void RayCast_SetupPrimaryRay(const RayCastCamera *camera, float angle_ray, RayCastRay *ray)
+{
+    ray->pos_x = camera->pos_x;
+    ray->pos_y = camera->pos_y;
+    ray->angle = angle_ray;
+    ray->dir_x = cosf(angle_ray);
+    ray->dir_y = sinf(angle_ray);
+    ray->depth = 0.0F;
+    ray->depth_dir_x = camera->dir_x;
+    ray->depth_dir_y = camera->dir_y;
+    ray->cell_x = (int)ray->pos_x;
+    ray->cell_y = (int)ray->pos_y;
+    ray->bounces = 0;
+}
+
+// Where the ray meets the door it just entered at the hit position, false if it only crosses //
+// the open part. The panel fills the cell from its left or top edge as far as it is still    //
+// shut, its texture sliding along with it. A ray in the open part may reach the panel's      //
+// edge, which faces the way the panel slides: it is recorded as the cell's face on that      //
+// side, its texture and light running across the door like on that face.                     //
+static bool RayCast_HitDoor(int hit_cell, float ray_dir_x, float ray_dir_y, float *hit_pos_x, float *hit_pos_y, int *hit_from_udlr, float *u_offset)
+{
+    *u_offset = 0.0F;
+
+    int open = RayCastDoors_GetOpen(doors, hit_cell);
+    if (open == 0)
+        return true;
+    if (open == RAYCAST_DOOR_OPEN)
+        return false;
+
+    bool along_x = (materials[level_cells[hit_cell]].kind == MATERIAL_DOOR_X);
+
+    float *along_pos = along_x ? hit_pos_x : hit_pos_y;
+    float *across_pos = along_x ? hit_pos_y : hit_pos_x;
+    float along_dir = along_x ? ray_dir_x : ray_dir_y;
+    float across_dir = along_x ? ray_dir_y : ray_dir_x;
+
+    int along_cell = along_x ? hit_cell % level_size_x : hit_cell / level_size_x;
+    int across_cell = along_x ? hit_cell / level_size_x : hit_cell % level_size_x;
+
+    float open_share = open * (1.0F / RAYCAST_DOOR_OPEN);
+    float edge = (float)(along_cell + 1) - open_share;
+
+    // In through the panel's face, or the end it slides away from //
+    if (*along_pos < edge)
     {
-        float ray_pos_x = player_x;
-        float ray_pos_y = player_y;
+        if (along_x ? (*hit_from_udlr <= 2) : (*hit_from_udlr >= 3))
+            *u_offset = open_share;
+        return true;
+    }
+
+    if (along_dir >= 0.0F)
+        return false;
+
+    float across = *across_pos + (across_dir * ((edge - *along_pos) / along_dir));
+    if (across < (float)across_cell || across > (float)(across_cell + 1))
+        return false;
+
+    *along_pos = edge;
+    *across_pos = across;
+
+    // Coming back against the slide, onto the right or bottom face //
+    *hit_from_udlr = along_x ? 4 : 2;
+    return true;
+}
+
+// Records into hit slot x the hits along the ray //
+static void RayCast_TraceRay(RayCastRenderContext *context, const RayCastCamera *camera, int x, const RayCastRay *ray)
+{
+    float ray_pos_x = ray->pos_x;
+    float ray_pos_y = ray->pos_y;
+
+    float angle_ray = ray->angle;
 
-        float norm_offset_x = (x - half_screen_width) / half_screen_width;
+    float ray_dir_x = ray->dir_x;
+    float ray_dir_y = ray->dir_y;
 
-        float angle_offset = atanf(norm_offset_x * max_norm_offset_x);
-        float angle_ray = RayCast_WrapAngle(player_angle + angle_offset);
+    int center_pos_x = ray->cell_x;
+    int center_pos_y = ray->cell_y;
 
-        float ray_dir_x = cosf(angle_ray);
-        float ray_dir_y = sinf(angle_ray);
+    // U = 1; D = 2; L = 3; R = 4;
+    int hit_from_udlr = 1;
 
-        int center_pos_x = (int)ray_pos_x;
-        int center_pos_y = (int)ray_pos_y;
+    int layer_count = 0;
 
-        // U = 1; D = 2; L = 3; R = 4;
-        int hit_from_udlr = 1;
+    // Rows Below This Are Already Covered By Nearer Walls //
+    float window_bottom_y = (float)screen_height;
 
-        while (true)
+    while (true)
+    {
+        int edge_x_l = center_pos_x;
+        int edge_x_r = edge_x_l + 1;
+        int edge_y_u = center_pos_y;
+        int edge_y_d = edge_y_u + 1;
+
+        if (fabsf(ray_dir_x) < ray_unstable_threshold)
         {
-            int edge_x_l = center_pos_x;
-            int edge_x_r = edge_x_l + 1;
-            int edge_y_u = center_pos_y;
-            int edge_y_d = edge_y_u + 1;
+            // Parallels Vertically //
+            if (ray_dir_y > 0)
+            {
+                // Down //
+                ray_pos_y = (float)edge_y_d;
+                center_pos_y++;
 
-            if (fabsf(ray_dir_x) < ray_unstable_threshold)
+                hit_from_udlr = 1;
+            }
+            else
             {
-                // Parallels Vertically //
-                if (ray_dir_y > 0)
-                {
-                    // Down //
-                    ray_pos_y = (float)edge_y_d;
-                    center_pos_y++;
+                // Up //
+                ray_pos_y = (float)edge_y_u;
+                center_pos_y--;
 
-                    hit_from_udlr = 1;
-                }
-                else
-                {
-                    // Up //
-                    ray_pos_y = (float)edge_y_u;
-                    center_pos_y--;
+                hit_from_udlr = 2;
+            }
+        }
+        else if (fabsf(ray_dir_y) < ray_unstable_threshold)
+        {
+            // Parallels Horizontally //
+            if (ray_dir_x > 0)
+            {
+                // Right //
+                ray_pos_x = (float)edge_x_r;
+                center_pos_x++;
 
-                    hit_from_udlr = 2;
-                }
+                hit_from_udlr = 3;
+            }
+            else
+            {
+                // Left //
+                ray_pos_x = (float)edge_x_l;
+                center_pos_x--;
+
+                hit_from_udlr = 4;
             }
-            else if (fabsf(ray_dir_y) < ray_unstable_threshold)
+        }
+        else
+        {
+            // Normal Conditions //
+
+            float new_pos_x, new_pos_y;
+
+            float dist_to_edge_u, dist_to_edge_d, dist_to_edge_l, dist_to_edge_r;
+
+            if (angle_ray >= (float)M_PI * -0.75F && angle_ray < (float)M_PI * -0.25F)
             {
-                // Parallels Horizontally //
-                if (ray_dir_x > 0)
+                // Up //
+
+                dist_to_edge_u = ray_pos_y - edge_y_u;
+
+                new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
+
+                if (new_pos_x >= edge_x_r)
                 {
-                    // Right //
-                    ray_pos_x = (float)edge_x_r;
+                    dist_to_edge_r = edge_x_r - ray_pos_x;
+
+                    new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
+                    new_pos_x = (float)edge_x_r;
+
                     center_pos_x++;
 
                     hit_from_udlr = 3;
                 }
-                else
+                else if (new_pos_x < edge_x_l)
                 {
-                    // Left //
-                    ray_pos_x = (float)edge_x_l;
+                    dist_to_edge_l = ray_pos_x - edge_x_l;
+
+                    new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
+                    new_pos_x = (float)edge_x_l;
+
                     center_pos_x--;
 
                     hit_from_udlr = 4;
                 }
+                else
+                {
+                    new_pos_y = (float)edge_y_u;
+
+                    center_pos_y--;
+
+                    hit_from_udlr = 2;
+                }
             }
-            else
+            else if (angle_ray >= (float)M_PI * -0.25F && angle_ray < (float)M_PI * 0.25F)
             {
-                // Normal Conditions //
+                // Right //
+
+                dist_to_edge_r = edge_x_r - ray_pos_x;
+
+                new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
+
+                if (new_pos_y >= edge_y_d)
+                {
+                    dist_to_edge_d = edge_y_d - ray_pos_y;
+
+                    new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
+                    new_pos_y = (float)edge_y_d;
+
+                    center_pos_y++;
+
+                    hit_from_udlr = 1;
+                }
+                else if (new_pos_y < edge_y_u)
+                {
+                    dist_to_edge_u = ray_pos_y - edge_y_u;
+
+                    new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
+                    new_pos_y = (float)edge_y_u;
+
+                    center_pos_y--;
+
+                    hit_from_udlr = 2;
+                }
+                else
+                {
+                    new_pos_x = (float)edge_x_r;
+
+                    center_pos_x++;
+
+                    hit_from_udlr = 3;
+                }
+            }
+            else if (angle_ray >= (float)M_PI * 0.25F && angle_ray < (float)M_PI * 0.75F)
+            {
+                // Down //
+
+                dist_to_edge_d = edge_y_d - ray_pos_y;
+
+                new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
+
+                if (new_pos_x >= edge_x_r)
+                {
+                    dist_to_edge_r = edge_x_r - ray_pos_x;
+
+                    new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
+                    new_pos_x = (float)edge_x_r;
+
+                    center_pos_x++;
+
+                    hit_from_udlr = 3;
+                }
+                else if (new_pos_x < edge_x_l)
+                {
+                    dist_to_edge_l = ray_pos_x - edge_x_l;
+
+                    new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
+                    new_pos_x = (float)edge_x_l;
+
+                    center_pos_x--;
+
+                    hit_from_udlr = 4;
+                }
+                else
+                {
+                    new_pos_y = (float)edge_y_d;
+
+                    center_pos_y++;
+
+                    hit_from_udlr = 1;
+                }
+            }
+            else
+            {
+                // Left //
+
+                dist_to_edge_l = ray_pos_x - edge_x_l;
+
+                new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
+
+                if (new_pos_y >= edge_y_d)
+                {
+                    dist_to_edge_d = edge_y_d - ray_pos_y;
+
+                    new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
+                    new_pos_y = (float)edge_y_d;
+
+                    center_pos_y++;
+
+                    hit_from_udlr = 1;
+                }
+                else if (new_pos_y < edge_y_u)
+                {
+                    dist_to_edge_u = ray_pos_y - edge_y_u;
+
+                    new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
+                    new_pos_y = (float)edge_y_u;
+
+                    center_pos_y--;
+
+                    hit_from_udlr = 2;
+                }
+                else
+                {
+                    new_pos_x = (float)edge_x_l;
+
+                    center_pos_x--;
+
+                    hit_from_udlr = 4;
+                }
+            }
+
+            ray_pos_x = new_pos_x;
+            ray_pos_y = new_pos_y;
+        }
+
+        // The cell, not the hit point: leaving through x = 0 or y = 0 lands exactly on the edge //
+        if (RayCast_CheckIsOutside(center_pos_x, center_pos_y) || RayCast_CheckIsPastView(camera, center_pos_x, center_pos_y))
+        {
+            // Left The Level Or The View, Treat As A Wall That Hides Everything //
+            RayCast_RecordLayer(context, ray, x, layer_count, ray_pos_x, ray_pos_y, hit_from_udlr, -1, boundary_material, level_max_height);
+            layer_count++;
+            break;
+        }
+        else if (level_cells[(center_pos_y * level_size_x) + center_pos_x] != 0)
+        {
+            float wall_height = RayCast_GetWallHeight(center_pos_x, center_pos_y);
+
+            int hit_cell = (center_pos_y * level_size_x) + center_pos_x;
+
+            // Doors are hit inside their cell, the traversal carries on from its edge //
+            float hit_pos_x = ray_pos_x;
+            float hit_pos_y = ray_pos_y;
+
+            float u_offset = 0.0F;
+            if (RayCast_IsDoor(level_cells[hit_cell]) &&
+                !RayCast_HitDoor(hit_cell, ray_dir_x, ray_dir_y, &hit_pos_x, &hit_pos_y, &hit_from_udlr, &u_offset))
+                continue;
+
+            float z_from_player = RayCast_RecordLayer(context, ray, x, layer_count, hit_pos_x, hit_pos_y, hit_from_udlr,
+                hit_cell, level_cells[hit_cell], wall_height);
+            if (u_offset != 0.0F)
+                context->hits.u[(layer_count * column_stride) + x] += u_offset;
+            RayCast_QueueSecondary(context, ray, x, layer_count, z_from_player, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell);
+            layer_count++;
+
+            if (z_from_player < z_cutoff || layer_count >= max_column_layers)
+                break;
+
+            float bar_height = 1.0F / z_from_player * camera->height_z_one;
+
+            window_bottom_y = fminf(window_bottom_y, camera->middle_y + (bar_height * (0.5F - wall_height)));
+
+            // Walls further away only get lower on screen (or stay below the middle), //
+            // once the window is under the highest top they could reach, stop.       //
+            float highest_top_y = camera->middle_y;
+            if (level_max_height > 0.5F)
+                highest_top_y += bar_height * (0.5F - level_max_height);
+
+            if (window_bottom_y <= highest_top_y)
+                break;
+        }
+    }
+
+    context->hits.layer_count[x] = (uint8_t)layer_count;
+}
+
+// Records into hit slot x the ray through screen position screen_x, which need not be whole //
+static void RayCast_CastRay(RayCastRenderContext *context, const RayCastCamera *camera, int x, float screen_x)
+{
+    float norm_offset_x = (screen_x - camera->half_screen_width) / camera->half_screen_width;
+
+    float angle_offset = atanf(norm_offset_x * camera->max_norm_offset_x);
+
+    RayCastRay ray;
+    RayCast_SetupPrimaryRay(camera, RayCast_WrapAngle(camera->angle + angle_offset), &ray);
+
+    RayCast_TraceRay(context, camera, x, &ray);
+}
+
+static inline void RayCast_CastColumn(RayCastRenderContext *context, const RayCastCamera *camera, int x)
+{
+    RayCast_CastRay(context, camera, x, (float)x);
+}
+
+// Both rays hit the same face of the same cell. The triangle between the player and //
+// the two hit points is narrower than one cell, so no wall cell can fit inside it    //
+// and every ray in between hits that face too; it is solved against the face plane.  //
+// Only used when that face is as tall as the tallest wall, so it ends the ray, and  //
+// not on doors, whose panel need not be on the face plane.                          //
+static void RayCast_InterpolateColumn(RayCastRenderContext *context, const RayCastCamera *camera, int x, int x_from)
+{
+    float norm_offset_x = (x - camera->half_screen_width) / camera->half_screen_width;
+
+    float angle_offset = atanf(norm_offset_x * camera->max_norm_offset_x);
+
+    RayCastRay ray;
+    RayCast_SetupPrimaryRay(camera, RayCast_WrapAngle(camera->angle + angle_offset), &ray);
+
+    float ray_dir_x = ray.dir_x;
+    float ray_dir_y = ray.dir_y;
+
+    int hit_cell = context->hits.cell[x_from];
+    int hit_from_udlr = context->hits.face[x_from];
+
+    int cell_x = hit_cell % level_size_x;
+    int cell_y = hit_cell / level_size_x;
+
+    float hit_pos_x, hit_pos_y;
+
+    switch (hit_from_udlr)
+    {
+    case 1:
+    case 2:
+        hit_pos_y = (float)((hit_from_udlr == 1) ? cell_y : cell_y + 1);
+        hit_pos_x = camera->pos_x + (ray_dir_x * ((hit_pos_y - camera->pos_y) / ray_dir_y));
+        break;
+    default:
+        hit_pos_x = (float)((hit_from_udlr == 3) ? cell_x : cell_x + 1);
+        hit_pos_y = camera->pos_y + (ray_dir_y * ((hit_pos_x - camera->pos_x) / ray_dir_x));
+        break;
+    }
+
+    float z_from_player = RayCast_RecordLayer(context, &ray, x, 0, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell, context->hits.material[x_from], context->hits.height[x_from]);
+
+    RayCast_QueueSecondary(context, &ray, x, 0, z_from_player, hit_pos_x, hit_pos_y, hit_from_udlr, hit_cell);
+
+    context->hits.layer_count[x] = 1;
+}
+
+#endif
+
+static void RayCast_ResolveSpan(RayCastRenderContext *context, const RayCastCamera *camera, int x_begin, int x_end)
+{
+    if (x_end - x_begin <= 1)
+        return;
+
+    if (context->hits.layer_count[x_begin] == 1 && context->hits.layer_count[x_end] == 1 &&
+        context->hits.height[x_begin] >= level_max_height &&
+        context->hits.cell[x_begin] >= 0 &&
+        !RayCast_IsDoor(context->hits.material[x_begin]) &&
+        context->hits.cell[x_begin] == context->hits.cell[x_end] &&
+        context->hits.face[x_begin] == context->hits.face[x_end])
+    {
+        for (int x = x_begin + 1; x < x_end; x++)
+            RayCast_InterpolateColumn(context, camera, x, x_begin);
+
+        return;
+    }
+
+    int x_middle = (x_begin + x_end) / 2;
+
+    RayCast_CastColumn(context, camera, x_middle);
+    context->rays_traversed++;
+
+    RayCast_ResolveSpan(context, camera, x_begin, x_middle);
+    RayCast_ResolveSpan(context, camera, x_middle, x_end);
+}
+
+static void RayCast_SetupCamera(RayCastCamera *camera, float pos_x, float pos_y, float angle)
+{
+    float max_norm_offset_x = tanf(half_fov);
+
+    camera->pos_x = pos_x;
+    camera->pos_y = pos_y;
+    camera->angle = angle;
+    camera->cell_x = (int)floorf(pos_x);
+    camera->cell_y = (int)floorf(pos_y);
+    camera->dir_x = cosf(angle);
+    camera->dir_y = sinf(angle);
+    camera->max_norm_offset_x = max_norm_offset_x;
+    camera->half_screen_width = screen_width / 2.0F;
+    camera->height_z_one = (float)screen_width / (max_norm_offset_x * 2.0F);
+    camera->middle_y = screen_height / 2.0F;
+}
+
+#if RAYCAST_FIXED_POINT
+static void RayCast_SetupCameraFixed(RayCastCamera *camera, RayCastFixed pos_x, RayCastFixed pos_y, RayCastAngle angle)
+{
+    RayCastFixed plane_length = RayCastFixed_Div(RayCastFixed_Sin(half_fov_angle), RayCastFixed_Cos(half_fov_angle));
+
+    camera->fixed.pos_x = pos_x;
+    camera->fixed.pos_y = pos_y;
+
+    // The fixed rays start from these cells //
+    camera->cell_x = RayCastFixed_Floor(pos_x);
+    camera->cell_y = RayCastFixed_Floor(pos_y);
+    camera->fixed.dir_x = RayCastFixed_Cos(angle);
+    camera->fixed.dir_y = RayCastFixed_Sin(angle);
+    camera->fixed.plane_x = -RayCastFixed_Mul(camera->fixed.dir_y, plane_length);
+    camera->fixed.plane_y = RayCastFixed_Mul(camera->fixed.dir_x, plane_length);
+    camera->fixed.height_z_one = ((int64_t)screen_width * RAYCAST_FIXED_ONE * RAYCAST_FIXED_ONE) / (2 * (int64_t)plane_length);
+    camera->fixed.middle_y = ((int64_t)screen_height * RAYCAST_FIXED_ONE) / 2;
+
+    // Project with the same field of view the rays were spread over //
+    camera->height_z_one = RayCastFixed_ToFloat(camera->fixed.height_z_one);
+}
+#endif
+
+// Traces the queued rays and whatever they queue in turn, breadth first, so a short budget //
+// drops the deepest bounces. A level with more rays than the budget has left traces every  //
+// stride-th one; the others borrow the image of a traced neighbor on the same face, or     //
+// show just the face.                                                                      //
+static void RayCast_TraceSecondaries(RayCastRenderContext *context, const RayCastCamera *camera)
+{
+    int level_begin = 0;
+
+    while (level_begin < context->secondary_queue_count)
+    {
+        int level_end = context->secondary_queue_count;
+
+        int budget_left = max_secondary_rays - context->secondary_rays;
+        if (budget_left <= 0)
+        {
+            context->secondary_skipped += level_end - level_begin;
+            break;
+        }
+
+        int stride = (level_end - level_begin + budget_left - 1) / budget_left;
+
+        for (int i = level_begin; i < level_end; i += stride)
+        {
+            const RayCastSecondaryRay *secondary = &context->secondary_queue[i];
+
+            int slot = secondary_slot_base + context->secondary_rays;
+            context->secondary_rays++;
+
+            // May queue more, they make up the next level //
+            RayCast_TraceRay(context, camera, slot, &secondary->ray);
+
+            context->hits.secondary[(secondary->layer * column_stride) + secondary->slot] = slot;
+        }
+
+        for (int i = level_begin; i < level_end; i++)
+        {
+            int offset = (i - level_begin) % stride;
+            if (offset == 0)
+                continue;
+
+            context->secondary_skipped++;
+
+            const RayCastSecondaryRay *secondary = &context->secondary_queue[i];
+            int index = (secondary->layer * column_stride) + secondary->slot;
+
+            // Nearer neighbor first //
+            int neighbors[2] = { i - offset, i - offset + stride };
+            if (offset * 2 > stride)
+            {
+                neighbors[0] = i - offset + stride;
+                neighbors[1] = i - offset;
+            }
+
+            for (int n = 0; n < 2; n++)
+            {
+                if (neighbors[n] >= level_end)
+                    continue;
+
+                const RayCastSecondaryRay *traced = &context->secondary_queue[neighbors[n]];
+                int traced_index = (traced->layer * column_stride) + traced->slot;
+
+                if (context->hits.cell[traced_index] == context->hits.cell[index] &&
+                    context->hits.face[traced_index] == context->hits.face[index])
+                {
+                    context->hits.secondary[index] = context->hits.secondary[traced_index];
+                    break;
+                }
+            }
+        }
+
+        level_begin = level_end;
+    }
+
+    context->secondary_queue_count = 0;
+}
+
+static bool RayCast_CastView(RayCastRenderContext *context, const RayCastCamera *camera)
+{
+    if (!RayCast_BeginFrameHits(context))
+        return false;
+
+    context->rays_traversed = 0;
+
+    if (adaptive_cast_enabled)
+    {
+        // Trace Span Boundaries, Subdivide Only Where They Disagree //
+
+        int x_last = screen_width - 1;
+
+        RayCast_CastColumn(context, camera, 0);
+        context->rays_traversed++;
+
+        for (int x_begin = 0; x_begin < x_last; x_begin += adaptive_span_size)
+        {
+            int x_end = x_begin + adaptive_span_size;
+            if (x_end > x_last)
+                x_end = x_last;
+
+            RayCast_CastColumn(context, camera, x_end);
+            context->rays_traversed++;
+
+            RayCast_ResolveSpan(context, camera, x_begin, x_end);
+        }
+    }
+    else
+    {
+        for (int x = 0; x < screen_width; x++)
+            RayCast_CastColumn(context, camera, x);
+
+        context->rays_traversed = screen_width;
+    }
+
+    RayCast_TraceSecondaries(context, camera);
+
+    if (fog_enabled)
+        RayCast_ComputeFog(context);
+
+    return true;
+}
+
+static void RayCast_MarkMaterials(const RayCastRenderContext *context, int slot_begin, int slot_end, bool *material_used)
+{
+    for (int x = slot_begin; x < slot_end; x++)
+    {
+        int layer_count = context->hits.layer_count[x];
+
+        for (int layer = 0; layer < layer_count; layer++)
+            material_used[context->hits.material[(layer * column_stride) + x]] = true;
+    }
+}
+
+// Only materials the view hit are requested, so the rest can stay evicted. Sub-column //
+// rays are cast after this and may hit anything, so with anti-aliasing all are.       //
+static void RayCast_ResolveMaterials(const RayCastRenderContext *context)
+{
+    bool material_used[MATERIAL_COUNT] = { false };
+
+    if (antialias_enabled)
+    {
+        for (int i = 0; i < MATERIAL_COUNT; i++)
+            material_used[i] = (material_texture_names[i] != NULL);
+    }
+    else
+    {
+        RayCast_MarkMaterials(context, 0, screen_width, material_used);
+        RayCast_MarkMaterials(context, secondary_slot_base, secondary_slot_base + context->secondary_rays, material_used);
+    }
+
+    for (int i = 0; i < MATERIAL_COUNT; i++)
+    {
+        if (material_used[i])
+            frame_materials[i] = TextureCacheSDL_Acquire(texture_cache, i);
+    }
+}
+
+// Per-view choices made once before filling any column //
+typedef struct
+{
+    const RayCastSpanRenderers *span_renderers;
+    bool lit;
+}
+RayCastFillState;
+
+static void RayCast_PrepareFill(RayCastFillState *state)
+{
+    // Feature switches are resolved once here, not per pixel //
+    state->lit = lighting_enabled && light_map != NULL;
+    state->span_renderers = RayCastSpans_Select(fog_enabled, state->lit, screen_channels);
+}
+
+// A row a wall only partly covers, blended with the row beside it that shows what is behind //
+typedef struct
+{
+    int row;
+    int neighbor_row;
+    int neighbor_weight; // Out of 256 //
+}
+RayCastEdgeRow;
+
+static inline void RayCast_BlendPixel(uint8_t *ptr_pixel, const uint8_t *ptr_other, int other_weight)
+{
+    for (int c = 0; c < screen_channels; c++)
+        ptr_pixel[c] = (uint8_t)(((ptr_pixel[c] * (256 - other_weight)) + (ptr_other[c] * other_weight)) >> 8);
+}
+
+// Fills the pixel column from hit slot x, false if it was left as it was. Reads only the //
+// context, the camera and shared read-only state, so views can be filled concurrently.  //
+static bool RayCast_FillColumn(const RayCastRenderContext *context, const RayCastCamera *camera, const RayCastFillState *state, int x, uint8_t *ptr_pixel_column, int pitch)
+{
+    float middle_y = camera->middle_y;
+    float height_z_one = camera->height_z_one;
+
+    const RayCastSpanRenderers *span_renderers = state->span_renderers;
+
+    float light_table[LIGHTMAP_SIZE];
+
+    RayCastEdgeRow edge_rows[2 * MAX_COLUMN_LAYERS];
+    int edge_row_count = 0;
+
+    RayCastSpan span;
+    span.pitch = pitch;
+
+    if (context->hits.depth[x] < z_cutoff)
+        return false;
+
+    // Front To Back, Bottom Up: Rows At And Below y_cursor Are Done //
+
+    int y_cursor = screen_height;
+
+    int layer_count = context->hits.layer_count[x];
+
+    for (int layer = 0; layer < layer_count; layer++)
+    {
+        int index = (layer * column_stride) + x;
+
+        float current_z = context->hits.depth[index];
+
+        float bar_height = 1.0F / current_z * height_z_one;
+        float bar_height_half = bar_height / 2.0F;
+
+        float top_y = middle_y + (bar_height * (0.5F - context->hits.height[index]));
+        float bottom_y = middle_y + bar_height_half;
+
+        int start_y = (int)top_y;
+        int end_y = (int)bottom_y;
+        int range_y = end_y - start_y;
+
+        float brightness = 1.0F;
+        if (fog_enabled)
+        {
+            brightness = context->hits.fog[index];
+
+            // Everything From Here On Is Fogged Out //
+            if (brightness <= 0.0F)
+                break;
+        }
+
+        int pixel_y_start = start_y;
+        if (pixel_y_start < 0)
+            pixel_y_start = 0;
+
+        int pixel_y_end = end_y;
+        if (pixel_y_end >= y_cursor)
+            pixel_y_end = y_cursor;
+
+        // Floor Between This Wall And The Nearer One //
+
+        if (pixel_y_end < y_cursor)
+        {
+            span.ptr_pixels = ptr_pixel_column + (pixel_y_end * pitch);
+            span.y_begin = pixel_y_end;
+            span.y_end = y_cursor;
+            span_renderers->background(&span);
+
+            // The floor row under the wall is partly wall //
+            if (antialias_enabled && pixel_y_end > 0 && pixel_y_end > pixel_y_start)
+            {
+                edge_rows[edge_row_count].row = pixel_y_end;
+                edge_rows[edge_row_count].neighbor_row = pixel_y_end - 1;
+                edge_rows[edge_row_count].neighbor_weight = (int)((bottom_y - end_y) * 256.0F);
+                edge_row_count++;
+            }
+
+            y_cursor = pixel_y_end;
+        }
+
+        if (pixel_y_start >= pixel_y_end)
+            continue;
+
+        // Wall //
+
+        SDL_Surface *wall_texture = frame_materials[context->hits.material[index]];
+
+        span.ptr_pixels = ptr_pixel_column + (pixel_y_start * pitch);
+        span.y_begin = pixel_y_start;
+        span.y_end = pixel_y_end;
+        span.wall_start_y = start_y;
+        span.wall_range_y = range_y;
+        span.brightness = brightness;
+
+        if (state->lit)
+        {
+            // One Lookup Per Pixel: Lightmap Column, Dynamic Light And Fog Folded Together //
+
+            int hit_cell = context->hits.cell[index];
+            int face = context->hits.face[index] - 1;
+
+            const uint8_t *light_column = RayCastLightMap_GetFaceColumn(light_map, hit_cell, face, context->hits.u[index]);
+            float dynamic_light = RayCastLightMap_SampleDynamic(light_map, hit_cell, face);
+
+            for (int i = 0; i < LIGHTMAP_SIZE; i++)
+                light_table[i] = fminf((light_column[i] * (1.0F / 255.0F)) + dynamic_light, 1.0F) * brightness;
+
+            span.light_table = light_table;
+        }
+
+        if (wall_texture == NULL)
+            span_renderers->untextured(&span);
+        else
+        {
+            int wall_tex_width = wall_texture->w;
+            int wall_tex_channels = SDL_BYTESPERPIXEL(wall_texture->format);
+
+            int texture_x = (int)(context->hits.u[index] * (float)wall_tex_width);
+            if (texture_x < 0)
+                texture_x = 0;
+            if (texture_x >= wall_tex_width)
+                texture_x = wall_tex_width - 1;
+
+            span.ptr_texels = (const uint8_t *)wall_texture->pixels + (texture_x * wall_tex_channels);
+            span.texture_pitch = wall_texture->pitch;
+            span.texture_height = wall_texture->h;
+            span.light_scale = (uint32_t)(LIGHTMAP_SIZE << 16) / (uint32_t)wall_texture->h;
+
+            span_renderers->textured[wall_tex_channels == 4](&span);
+        }
+
+        // Mirror Or Glass: What The Secondary Ray Saw, Over The Face //
+
+        int secondary_slot = context->hits.secondary[index];
+        if (secondary_slot >= 0)
+        {
+            uint8_t secondary_column[SCREEN_HEIGHT * CHANNELS];
+
+            // Its hits are projected as seen from the camera, so the rows line up //
+            if (RayCast_FillColumn(context, camera, state, secondary_slot, secondary_column, screen_channels))
+            {
+                int secondary_weight = materials[context->hits.material[index]].secondary_weight;
+
+                for (int y = pixel_y_start; y < pixel_y_end; y++)
+                    RayCast_BlendPixel(ptr_pixel_column + (y * pitch), secondary_column + (y * screen_channels), secondary_weight);
+            }
+        }
+
+        // The top wall row is partly whatever ends up above it //
+        if (antialias_enabled && pixel_y_start == start_y && start_y > 0)
+        {
+            edge_rows[edge_row_count].row = start_y;
+            edge_rows[edge_row_count].neighbor_row = start_y - 1;
+            edge_rows[edge_row_count].neighbor_weight = (int)((top_y - start_y) * 256.0F);
+            edge_row_count++;
+        }
+
+        y_cursor = pixel_y_start;
+    }
+
+    // Ceiling //
+
+    span.ptr_pixels = ptr_pixel_column;
+    span.y_begin = 0;
+    span.y_end = y_cursor;
+    span_renderers->background(&span);
+
+    // Every neighbor row is final now //
+    for (int i = 0; i < edge_row_count; i++)
+    {
+        RayCast_BlendPixel(ptr_pixel_column + (edge_rows[i].row * pitch),
+            ptr_pixel_column + (edge_rows[i].neighbor_row * pitch), edge_rows[i].neighbor_weight);
+    }
+
+    return true;
+}
+
+static void RayCast_FillView(const RayCastRenderContext *context, const RayCastCamera *camera, uint8_t *pixel_buffer, int pitch)
+{
+    RayCastFillState state;
+    RayCast_PrepareFill(&state);
+
+    for (int x = 0; x < screen_width; x++)
+    {
+        uint8_t *ptr_pixel = pixel_buffer + (x * screen_channels);
+
+        if (RayCast_FillColumn(context, camera, &state, x, ptr_pixel, pitch))
+            continue;
+
+        // Right against a wall, cleared so no earlier frame shows through //
+        for (int y = 0; y < screen_height; y++)
+        {
+            memset(ptr_pixel, 0, (size_t)screen_channels);
+            ptr_pixel += pitch;
+        }
+    }
+}
+
+// Front hits of two neighboring columns that cannot belong to one smooth surface //
+static inline bool RayCast_IsDiscontinuity(const RayCastRenderContext *context, int a, int b)
+{
+    if (context->hits.layer_count[a] != context->hits.layer_count[b] ||
+        context->hits.face[a] != context->hits.face[b] ||
+        context->hits.height[a] != context->hits.height[b])
+        return true;
+
+    float depth_a = context->hits.depth[a];
+    float depth_b = context->hits.depth[b];
+
+    return fabsf(depth_a - depth_b) > aa_depth_threshold * fminf(depth_a, depth_b);
+}
+
+// Sub-column rays only go where neighbors disagree, so the cost follows the edge count. //
+// Each one is cast into a spare hit slot, filled into a scratch column and averaged in.  //
+static void RayCast_AntiAliasView(RayCastRenderContext *context, const RayCastCamera *camera, uint8_t *pixel_buffer, int pitch)
+{
+    context->aa_rays = 0;
+
+    if (!antialias_enabled)
+        return;
+
+    uint8_t sample_columns[AA_SUBSAMPLES][SCREEN_HEIGHT * CHANNELS];
+
+    const int sample_pitch = screen_channels;
+
+    RayCastFillState state;
+    RayCast_PrepareFill(&state);
+
+    for (int x = 0; x < screen_width; x++)
+    {
+        bool edge =
+            (x > 0 && RayCast_IsDiscontinuity(context, x - 1, x)) ||
+            (x < screen_width - 1 && RayCast_IsDiscontinuity(context, x, x + 1));
+
+        if (!edge)
+            continue;
+
+        int sample_count = 0;
+
+        for (int i = 0; i < AA_SUBSAMPLES; i++)
+        {
+            int slot = screen_width + sample_count;
+
+            // Samples at -1/3 and +1/3 of a pixel, the column's own ray is the middle one //
+            float offset = ((float)(i + 1) / (AA_SUBSAMPLES + 1)) - 0.5F;
+#if RAYCAST_FIXED_POINT
+            RayCast_CastRay(context, camera, slot, RayCastFixed_FromInt(x) + (RayCastFixed)(offset * RAYCAST_FIXED_ONE));
+#else
+            RayCast_CastRay(context, camera, slot, x + offset);
+#endif
+
+            // Out of what the view left of the budget //
+            int secondary_begin = secondary_slot_base + context->secondary_rays;
+
+            RayCast_TraceSecondaries(context, camera);
+
+            // The view's fog pass has already run //
+            RayCast_ComputeSlotFog(context, slot);
+
+            for (int secondary_slot = secondary_begin; secondary_slot < secondary_slot_base + context->secondary_rays; secondary_slot++)
+                RayCast_ComputeSlotFog(context, secondary_slot);
+
+            context->aa_rays++;
+
+            // Right against a wall, nothing to blend in //
+            if (RayCast_FillColumn(context, camera, &state, slot, sample_columns[sample_count], sample_pitch))
+                sample_count++;
+        }
+
+        uint8_t *ptr_pixel = pixel_buffer + (x * screen_channels);
+
+        for (int y = 0; y < screen_height; y++)
+        {
+            for (int c = 0; c < screen_channels; c++)
+            {
+                int sum = ptr_pixel[c];
+                for (int i = 0; i < sample_count; i++)
+                    sum += sample_columns[i][(y * sample_pitch) + c];
+
+                ptr_pixel[c] = (uint8_t)(sum / (sample_count + 1));
+            }
+
+            ptr_pixel += pitch;
+        }
+    }
+}
+
+static void RayCast_DoRayCastAndRender(void)
+{
+    RayCastCamera camera;
+    RayCast_SetupCamera(&camera, player_x, player_y, player_angle);
+#if RAYCAST_FIXED_POINT
+    RayCast_SetupCameraFixed(&camera, player_fixed.x, player_fixed.y, player_fixed.angle);
+#endif
+
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_CAST);
+
+    bool cast = RayCast_CastView(main_context, &camera);
+
+    RayCastPerf_End(perf_counters, PERF_STAGE_CAST);
+
+    if (!cast)
+        return;
+
+    frame_stats.columns = screen_width;
+    frame_stats.rays_traversed = main_context->rays_traversed;
+
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_FILL);
+
+    RayCast_ResolveMaterials(main_context);
+
+    uint8_t *pixel_buffer = NULL;
+    int pitch;
+
+    bool locked = false;
+
+    if (surface_present || frame_capture != NULL)
+    {
+        pixel_buffer = frame_pixels;
+        pitch = frame_pitch;
+    }
+    else
+        locked = SDL_LockTexture(texture, NULL, (void **)&pixel_buffer, &pitch);
+
+    if (pixel_buffer == NULL)
+    {
+        RayCastPerf_End(perf_counters, PERF_STAGE_FILL);
+        return;
+    }
+
+    // memset((void *)pixel_buffer, 0, screen_width * screen_height * screen_channels);
+
+    RayCast_FillView(main_context, &camera, pixel_buffer, pitch);
+
+    RayCast_AntiAliasView(main_context, &camera, pixel_buffer, pitch);
+
+    frame_stats.aa_rays = main_context->aa_rays;
+    frame_stats.secondary_rays = main_context->secondary_rays;
+    frame_stats.secondary_skipped = main_context->secondary_skipped;
+
+    // Only copies into a free ring slot, conversion and IO happen on the writer thread //
+    if (frame_capture != NULL)
+        FrameCaptureSDL_Submit(frame_capture, frame_pixels, frame_pitch);
+
+    if (locked)
+        SDL_UnlockTexture(texture);
+    else if (!surface_present)
+        SDL_UpdateTexture(texture, NULL, frame_pixels, frame_pitch);
+
+    RayCastPerf_End(perf_counters, PERF_STAGE_FILL);
+}
+
+static void RayCast_PresentSurface(void)
+{
+    SDL_Surface *window_surface = SDL_GetWindowSurface(window);
+    if (window_surface == NULL)
+        return;
+
+    // Largest whole multiple that fits, centered //
+    int scale = SDL_min(window_surface->w / screen_width, window_surface->h / screen_height);
+
+    SDL_Rect dst_rect;
+    dst_rect.w = screen_width * scale;
+    dst_rect.h = screen_height * scale;
+    dst_rect.x = (window_surface->w - dst_rect.w) / 2;
+    dst_rect.y = (window_surface->h - dst_rect.h) / 2;
+
+    // A new surface after a resize has undefined contents around the frame //
+    if (window_surface->w != present_surface_width || window_surface->h != present_surface_height)
+    {
+        SDL_FillSurfaceRect(window_surface, NULL, 0);
+
+        present_surface_width = window_surface->w;
+        present_surface_height = window_surface->h;
+    }
+
+    if (scale >= 1 && RayCastUpscale_IsSupported(screen_pixel_format, window_surface->format))
+    {
+        if (SDL_MUSTLOCK(window_surface))
+            SDL_LockSurface(window_surface);
+
+        uint8_t *ptr_dst = (uint8_t *)window_surface->pixels + ((size_t)dst_rect.y * window_surface->pitch) + ((size_t)dst_rect.x * 4);
+
+        RayCastUpscale_Blit(frame_pixels, frame_pitch, screen_pixel_format, screen_width, screen_height,
+            ptr_dst, window_surface->pitch, window_surface->format, scale);
+
+        if (SDL_MUSTLOCK(window_surface))
+            SDL_UnlockSurface(window_surface);
+    }
+    else
+    {
+        // Unusual surface formats, or a window smaller than one frame //
+        if (scale < 1)
+        {
+            dst_rect.x = 0;
+            dst_rect.y = 0;
+            dst_rect.w = window_surface->w;
+            dst_rect.h = window_surface->h;
+        }
+
+        SDL_BlitSurfaceScaled(frame_surface, NULL, window_surface, &dst_rect, SDL_SCALEMODE_NEAREST);
+    }
+
+    SDL_UpdateWindowSurface(window);
+}
+
+#if RAYCAST_FIXED_POINT
+static void RayCast_VecClampLengthFixed(RayCastFixed *x, RayCastFixed *y, RayCastFixed max_length)
+{
+    RayCastFixed vec_length = RayCastFixed_Length(*x, *y);
+
+    if (vec_length <= player_stop_threshold_fixed)
+        return;
+
+    if (vec_length >= max_length)
+    {
+        *x = (RayCastFixed)(((int64_t)*x * max_length) / vec_length);
+        *y = (RayCastFixed)(((int64_t)*y * max_length) / vec_length);
+    }
+}
+
+static void RayCast_SyncPlayerFromFixed(void)
+{
+    player_x = RayCastFixed_ToFloat(player_fixed.x);
+    player_y = RayCastFixed_ToFloat(player_fixed.y);
+    player_vel_x = RayCastFixed_ToFloat(player_fixed.vel_x);
+    player_vel_y = RayCastFixed_ToFloat(player_fixed.vel_y);
+    player_angle = RayCastAngle_ToRadians(player_fixed.angle);
+}
+
+static void RayCast_MouseMotion(SDL_Event *event)
+{
+    // Input Is Quantized To Angle Units Once, Everything After Is Integer //
+    float angle_units = event->motion.xrel * mouse_sensitivity * (RAYCAST_ANGLE_TURN / (2.0F * (float)M_PI));
+
+    player_fixed.angle = RayCastAngle_Wrap(player_fixed.angle + (RayCastAngle)lroundf(angle_units));
+}
+
+static void RayCast_PlayerMovement(void)
+{
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LEFT))
+        player_fixed.angle -= player_turn_speed_angle;
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_RIGHT))
+        player_fixed.angle += player_turn_speed_angle;
+    player_fixed.angle = RayCastAngle_Wrap(player_fixed.angle);
+
+    RayCastAngle player_angle_right = player_fixed.angle + RAYCAST_ANGLE_QUARTER;
+
+    RayCastFixed player_accel_forward_x = RayCastFixed_Cos(player_fixed.angle);
+    RayCastFixed player_accel_forward_y = RayCastFixed_Sin(player_fixed.angle);
+
+    RayCastFixed player_accel_right_x = RayCastFixed_Cos(player_angle_right);
+    RayCastFixed player_accel_right_y = RayCastFixed_Sin(player_angle_right);
+
+    RayCastFixed player_accel_x = 0;
+    RayCastFixed player_accel_y = 0;
+
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_A))
+    {
+        player_accel_x -= player_accel_right_x;
+        player_accel_y -= player_accel_right_y;
+    }
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_D))
+    {
+        player_accel_x += player_accel_right_x;
+        player_accel_y += player_accel_right_y;
+    }
+
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_S))
+    {
+        player_accel_x -= player_accel_forward_x;
+        player_accel_y -= player_accel_forward_y;
+    }
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_W))
+    {
+        player_accel_x += player_accel_forward_x;
+        player_accel_y += player_accel_forward_y;
+    }
+
+    RayCastFixed player_max_vel;
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LSHIFT))
+        player_max_vel = player_vel_sprint_fixed;
+    else
+        player_max_vel = player_vel_walk_fixed;
+
+    RayCast_VecClampLengthFixed(&player_accel_x, &player_accel_y, player_accel_fixed);
+
+    player_fixed.vel_x += player_accel_x;
+    player_fixed.vel_y += player_accel_y;
+
+    if (RayCastFixed_Length(player_accel_x, player_accel_y) < player_stop_threshold_fixed)
+    {
+        player_fixed.vel_x = RayCastFixed_Mul(player_fixed.vel_x, player_fraction_fixed);
+        player_fixed.vel_y = RayCastFixed_Mul(player_fixed.vel_y, player_fraction_fixed);
+
+        if (RayCastFixed_Length(player_fixed.vel_x, player_fixed.vel_y) < player_stop_threshold_fixed)
+            player_fixed.vel_x = player_fixed.vel_y = 0;
+    }
+
+    RayCast_VecClampLengthFixed(&player_fixed.vel_x, &player_fixed.vel_y, player_max_vel);
+
+    player_fixed.x += player_fixed.vel_x;
+    player_fixed.y += player_fixed.vel_y;
+}
+#else
+static void RayCast_MouseMotion(SDL_Event *event)
+{
+    player_angle += event->motion.xrel * mouse_sensitivity;
+    player_angle = RayCast_WrapAngle(player_angle);
+}
+
+static void RayCast_PlayerMovement(void)
+{
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LEFT))
+        player_angle -= player_turn_speed_per_tick;
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_RIGHT))
+        player_angle += player_turn_speed_per_tick;
+    player_angle = RayCast_WrapAngle(player_angle);
+
+    float player_angle_right = player_angle + (float)M_PI_2;
+
+    float player_accel_forward_x = cosf(player_angle);
+    float player_accel_forward_y = sinf(player_angle);
+
+    float player_accel_right_x = cosf(player_angle_right);
+    float player_accel_right_y = sinf(player_angle_right);
+
+    float player_accel_x = 0.0F;
+    float player_accel_y = 0.0F;
+
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_A))
+    {
+        player_accel_x -= player_accel_right_x;
+        player_accel_y -= player_accel_right_y;
+    }
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_D))
+    {
+        player_accel_x += player_accel_right_x;
+        player_accel_y += player_accel_right_y;
+    }
+    
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_S))
+    {
+        player_accel_x -= player_accel_forward_x;
+        player_accel_y -= player_accel_forward_y;
+    }
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_W))
+    {
+        player_accel_x += player_accel_forward_x;
+        player_accel_y += player_accel_forward_y;
+    }
+
+    float player_max_vel;
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LSHIFT))
+        player_max_vel = player_vel_sprint_per_tick;
+    else
+        player_max_vel = player_vel_walk_per_tick;
+
+    RayCast_VecClampLength(&player_accel_x, &player_accel_y, player_accel_per_tick);
+
+    player_vel_x += player_accel_x;
+    player_vel_y += player_accel_y;
+
+    if (RayCast_Vec2Len(player_accel_x, player_accel_y) < 0.0001F)
+    {
+        player_vel_x *= player_fraction;
+        player_vel_y *= player_fraction;
+
+        if (RayCast_Vec2Len(player_vel_x, player_vel_y) < 0.0001F)
+            player_vel_x = player_vel_y = 0.0F;
+    }
+
+    RayCast_VecClampLength(&player_vel_x, &player_vel_y, player_max_vel);
+
+    player_x += player_vel_x;
+    player_y += player_vel_y;
+}
+
+#endif
+
+static const uint64_t level_edit_hash_basis = 0xCBF29CE484222325ULL;
+
+static uint64_t RayCast_HashLevelEdit(uint64_t hash, const RayCastLevelEdit *edit, uint64_t tick)
+{
+    uint64_t fields[3] =
+    {
+        ((uint64_t)edit->kind << 32) | (uint32_t)edit->cell,
+        ((uint64_t)edit->material << 16) | ((uint64_t)edit->height << 8) | (uint64_t)edit->open,
+        tick
+    };
+
+    const uint8_t *bytes = (const uint8_t *)fields;
+    for (size_t i = 0; i < sizeof(fields); i++)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+
+    return hash;
+}
+
+// Of the first count edits, which must all have been applied at some point //
+static uint64_t RayCast_GetAppliedEditHash(int count)
+{
+    return (count > 0) ? level_edits[count - 1].hash : level_edit_hash_basis;
+}
+
+static uint64_t RayCast_GetQueuedEditHash(int first, int last)
+{
+    uint64_t hash = level_edit_hash_basis;
+    for (int i = first; i < last; i++)
+        hash = RayCast_HashLevelEdit(hash, &level_edits[i], 0);
+
+    return hash;
+}
+
+// The snapshot must be a point along this run's edit history. A history rolled back past an //
+// edit may still hold the edit's tick and hash, they only match a snapshot that applied it  //
+// at that tick.                                                                             //
+static bool RayCast_IsOnLevelHistory(const RayCastSnapshot *snapshot)
+{
+    if (snapshot->level_edit_count > (uint32_t)level_edit_count || snapshot->level_edit_applied > snapshot->level_edit_count ||
+        snapshot->level_edit_count - snapshot->level_edit_applied > MAX_LEVEL_EDITS)
+        return false;
+
+    int edit_count = (int)snapshot->level_edit_count;
+    int edit_applied = (int)snapshot->level_edit_applied;
+
+    return
+        RayCast_GetAppliedEditHash(edit_applied) == snapshot->level_applied_hash &&
+        RayCast_GetQueuedEditHash(edit_applied, edit_count) == snapshot->level_queued_hash;
+}
+
+// True when the cell itself changed, not just where its door is headed //
+static bool RayCast_ApplyLevelEdit(const RayCastLevelEdit *edit)
+{
+    // Checked now, the cell may have become a door earlier in the batch //
+    if (edit->kind == LEVEL_EDIT_DOOR)
+    {
+        if (RayCast_IsDoor(level_cells[edit->cell]) && !RayCastDoors_SetTarget(doors, edit->cell, edit->open))
+            SDL_Log("%s Failed to allocate memory for a door", program_log_tag);
+        return false;
+    }
+
+    uint8_t old_material = level_cells[edit->cell];
+    uint8_t old_height = level_heights[edit->cell];
+    uint8_t height = (edit->material != 0) ? edit->height : 0;
+
+    if (edit->material == old_material && height == old_height)
+        return false;
+
+    if (old_material != 0)
+        level_height_counts[old_height]--;
+    if (edit->material != 0)
+        level_height_counts[height]++;
+
+    level_cells[edit->cell] = edit->material;
+    level_heights[edit->cell] = height;
+
+    // Whatever the cell is now, a door there starts out shut //
+    RayCastDoors_Reset(doors, edit->cell);
+
+    return true;
+}
+
+// As RayCast_UpdateLevel moves them each tick; they all come to rest within a few ticks //
+static void RayCast_StepDoors(uint64_t ticks)
+{
+    for (uint64_t i = 0; i < ticks; i++)
+    {
+        if (RayCastDoors_Step(doors, door_step_per_tick) == 0)
+            break;
+    }
+}
+
+// Rebuilds the cells and doors from the source level by replaying the edits applied before //
+// the snapshot, batch by batch with the door steps between, then updates what is derived   //
+// from the cells around those that came out different.                                     //
+static void RayCast_RestoreLevel(const RayCastSnapshot *snapshot)
+{
+    int edit_count = (int)snapshot->level_edit_count;
+    int edit_applied = (int)snapshot->level_edit_applied;
+
+    size_t cell_count = (size_t)level_size_x * (size_t)level_size_y;
+
+    memcpy(level_restore_cells, level_cells, cell_count);
+    memcpy(level_restore_heights, level_heights, cell_count);
+
+    memcpy(level_cells, level_source_cells, cell_count);
+    memcpy(level_heights, level_source_heights, cell_count);
+
+    RayCastDoors_Clear(doors);
+
+    uint64_t tick = (edit_applied > 0) ? level_edits[0].tick : 0;
+
+    for (int i = 0; i < edit_applied; i++)
+    {
+        if (level_edits[i].tick != tick)
+        {
+            RayCast_StepDoors(level_edits[i].tick - tick);
+            tick = level_edits[i].tick;
+        }
+
+        RayCast_ApplyLevelEdit(&level_edits[i]);
+    }
+
+    if (edit_applied > 0)
+        RayCast_StepDoors(snapshot->tick - tick);
+
+    RayCast_CountHeights();
+
+    // Only cells some edit touched can differ from the source, before the replay or after //
+    int touched_count = (edit_applied > level_edit_applied) ? edit_applied : level_edit_applied;
+    int changed_count = 0;
+
+    for (int i = 0; i < touched_count; i++)
+    {
+        int cell = level_edits[i].cell;
+
+        if (level_edits[i].kind == LEVEL_EDIT_CELL &&
+            (level_cells[cell] != level_restore_cells[cell] || level_heights[cell] != level_restore_heights[cell]))
+        {
+            level_changed_cells[changed_count++] = cell;
+
+            // Listed once //
+            level_restore_cells[cell] = level_cells[cell];
+            level_restore_heights[cell] = level_heights[cell];
+        }
+    }
+
+    level_edit_count = edit_count;
+    level_edit_applied = edit_applied;
+
+    if (changed_count > 0)
+    {
+        RayCastPVS_UpdateCells(pvs, level_changed_cells, changed_count);
+        RayCastLightMap_UpdateCells(light_map, level_changed_cells, changed_count);
+    }
+
+    level_revision++;
+}
+
+void RayCast_SaveSnapshot(RayCastSnapshot *snapshot)
+{
+#if RAYCAST_FIXED_POINT
+    RayCastSnapshot_Init(snapshot, RAYCAST_SNAPSHOT_FIXED_POINT);
+
+    snapshot->player_fixed_x = player_fixed.x;
+    snapshot->player_fixed_y = player_fixed.y;
+    snapshot->player_fixed_vel_x = player_fixed.vel_x;
+    snapshot->player_fixed_vel_y = player_fixed.vel_y;
+    snapshot->player_fixed_angle = player_fixed.angle;
+#else
+    RayCastSnapshot_Init(snapshot, 0);
+#endif
+
+    snapshot->tick = simulation_tick;
+
+    snapshot->level_edit_count = (uint32_t)level_edit_count;
+    snapshot->level_edit_applied = (uint32_t)level_edit_applied;
+    snapshot->level_applied_hash = RayCast_GetAppliedEditHash(level_edit_applied);
+    snapshot->level_queued_hash = RayCast_GetQueuedEditHash(level_edit_applied, level_edit_count);
+
+    snapshot->player_x = player_x;
+    snapshot->player_y = player_y;
+    snapshot->player_vel_x = player_vel_x;
+    snapshot->player_vel_y = player_vel_y;
+    snapshot->player_angle = player_angle;
+
+    snapshot->key_states = key_states;
+
+    snapshot->fog_enabled = fog_enabled;
+    snapshot->adaptive_cast_enabled = adaptive_cast_enabled;
+    snapshot->lighting_enabled = lighting_enabled;
+    snapshot->lantern_enabled = lantern_enabled;
+    snapshot->antialias_enabled = antialias_enabled;
+}
+
+bool RayCast_RestoreSnapshot(const RayCastSnapshot *snapshot)
+{
+    if (!RayCastSnapshot_IsValid(snapshot))
+        return false;
+
+    if (!RayCast_IsOnLevelHistory(snapshot))
+    {
+        SDL_Log("%s Snapshot is from a different run of level edits", program_log_tag);
+        return false;
+    }
+
+#if RAYCAST_FIXED_POINT
+    // The float fields would resimulate differently, only a fixed-point snapshot will do //
+    if ((snapshot->flags & RAYCAST_SNAPSHOT_FIXED_POINT) == 0)
+    {
+        SDL_Log("%s Snapshot is from the floating-point build", program_log_tag);
+        return false;
+    }
+
+    if (snapshot->player_fixed_x < 0 || snapshot->player_fixed_x >= RayCastFixed_FromInt(level_size_x) ||
+        snapshot->player_fixed_y < 0 || snapshot->player_fixed_y >= RayCastFixed_FromInt(level_size_y))
+        return false;
+
+    player_fixed.x = snapshot->player_fixed_x;
+    player_fixed.y = snapshot->player_fixed_y;
+    player_fixed.vel_x = snapshot->player_fixed_vel_x;
+    player_fixed.vel_y = snapshot->player_fixed_vel_y;
+    player_fixed.angle = RayCastAngle_Wrap(snapshot->player_fixed_angle);
+
+    RayCast_SyncPlayerFromFixed();
+#else
+    if ((snapshot->flags & RAYCAST_SNAPSHOT_FIXED_POINT) != 0)
+    {
+        SDL_Log("%s Snapshot is from the fixed-point build", program_log_tag);
+        return false;
+    }
+
+    // Also rejects NaN from a damaged file //
+    if (!(snapshot->player_x >= 0.0F && snapshot->player_x < (float)level_size_x &&
+          snapshot->player_y >= 0.0F && snapshot->player_y < (float)level_size_y &&
+          isfinite(snapshot->player_vel_x) && isfinite(snapshot->player_vel_y) &&
+          isfinite(snapshot->player_angle)))
+        return false;
+
+    player_x = snapshot->player_x;
+    player_y = snapshot->player_y;
+    player_vel_x = snapshot->player_vel_x;
+    player_vel_y = snapshot->player_vel_y;
+    player_angle = snapshot->player_angle;
+#endif
+
+    RayCast_RestoreLevel(snapshot);
+
+    simulation_tick = snapshot->tick;
+
+    key_states = snapshot->key_states;
+
+    fog_enabled = (snapshot->fog_enabled != 0);
+    adaptive_cast_enabled = (snapshot->adaptive_cast_enabled != 0);
+    lighting_enabled = (snapshot->lighting_enabled != 0);
+    lantern_enabled = (snapshot->lantern_enabled != 0);
+    antialias_enabled = (snapshot->antialias_enabled != 0);
+
+    // The lantern follows the player, move it now rather than on the next tick //
+    if (lantern_enabled)
+    {
+        RayCastLight lantern = { player_x, player_y, 0.5F, lantern_radius, lantern_intensity };
+        RayCastLightMap_SetDynamicLight(light_map, lantern_light_id, &lantern);
+    }
+    else
+        RayCastLightMap_ClearDynamicLight(light_map, lantern_light_id);
+
+    settings_revision++;
+    frame_dirty = true;
+
+    return true;
+}
+
+// Steps back through the in-memory history; the ticks after the restored one are dropped //
+bool RayCast_Rewind(int ticks)
+{
+    if (snapshot_ring == NULL || RayCastSnapshotRing_GetCount(snapshot_ring) == 0 || ticks < 0)
+        return false;
+
+    int age = ticks;
+    if (age >= RayCastSnapshotRing_GetCount(snapshot_ring))
+        age = RayCastSnapshotRing_GetCount(snapshot_ring) - 1;
+
+    if (!RayCast_RestoreSnapshot(RayCastSnapshotRing_Get(snapshot_ring, age)))
+        return false;
+
+    RayCastSnapshotRing_Drop(snapshot_ring, age);
+
+    return true;
+}
+
+// Back to the state right after initialization, level edits undone; window and textures stay //
+bool RayCast_Restart(void)
+{
+    if (!RayCast_RestoreSnapshot(&start_snapshot))
+        return false;
+
+    if (snapshot_ring != NULL)
+        RayCastSnapshotRing_Clear(snapshot_ring);
+
+    return true;
+}
+
+// Hotkeys roll back the world, not the keyboard: keys held right now stay held //
+static void RayCast_HandleSnapshotKey(SDL_Scancode scancode)
+{
+    KeyStatesSDL live_key_states = key_states;
+    RayCastSnapshot snapshot;
+    bool restored = false;
+
+    switch (scancode)
+    {
+    case SDL_SCANCODE_F6:
+        RayCast_SaveSnapshot(&snapshot);
+        if (RayCastSnapshot_Save(&snapshot, snapshot_path))
+            SDL_Log("%s Saved tick %llu to %s", program_log_tag, (unsigned long long)snapshot.tick, snapshot_path);
+        return;
+    case SDL_SCANCODE_F7:
+        restored = RayCastSnapshot_Load(&snapshot, snapshot_path) && RayCast_RestoreSnapshot(&snapshot);
+        // A different timeline, the history no longer leads here //
+        if (restored && snapshot_ring != NULL)
+            RayCastSnapshotRing_Clear(snapshot_ring);
+        break;
+    case SDL_SCANCODE_F8:
+        restored = RayCast_Restart();
+        break;
+    case SDL_SCANCODE_BACKSPACE:
+        restored = RayCast_Rewind(rewind_ticks);
+        break;
+    default:
+        return;
+    }
+
+    if (restored)
+        key_states = live_key_states;
+}
+
+// .y4m is converted to YUV 4:2:0, any other name gets raw BGR24 frames //
+static void RayCast_StartCapture(const char *path)
+{
+    size_t path_length = strlen(path);
+
+    FrameCaptureFormat format = FRAME_CAPTURE_FORMAT_RAW;
+    if (path_length >= 4 && SDL_strcasecmp(path + path_length - 4, ".y4m") == 0)
+        format = FRAME_CAPTURE_FORMAT_Y4M;
+
+    frame_capture = FrameCaptureSDL_Create(path, format, screen_width, screen_height, screen_pixel_format, capture_frame_rate, capture_slot_count);
+    if (frame_capture == NULL)
+        SDL_Log("%s Failed to start capture", program_log_tag);
+}
+
+static void RayCast_ToggleCapture(void)
+{
+    if (frame_capture != NULL)
+    {
+        FrameCaptureSDL_Destroy(frame_capture);
+        frame_capture = NULL;
+        return;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "capture_%03d.y4m", capture_index++);
+
+    RayCast_StartCapture(path);
+
+    // The ring needs a first full frame to repeat from //
+    frame_dirty = true;
+}
+
+// Counters are opened on first use and kept, so the CSV stays one continuous run //
+static void RayCast_TogglePerfOverlay(void)
+{
+    if (perf_counters == NULL)
+    {
+        perf_counters = RayCastPerf_Create(perf_stage_names, PERF_STAGE_COUNT, NULL);
+        if (perf_counters == NULL)
+        {
+            SDL_Log("%s Hardware counters are not available", program_log_tag);
+            return;
+        }
+    }
+
+    perf_overlay_enabled = !perf_overlay_enabled;
+
+    if (perf_overlay_enabled && surface_present)
+        SDL_Log("%s The counter overlay needs the renderer present path", program_log_tag);
+
+    present_dirty = true;
+}
+
+// Opens or shuts a door one cell ahead, through the same queue as any other edit //
+static void RayCast_ToggleDoorAhead(void)
+{
+#if RAYCAST_FIXED_POINT
+    int cell_x = RayCastFixed_Floor(player_fixed.x + RayCastFixed_Cos(player_fixed.angle));
+    int cell_y = RayCastFixed_Floor(player_fixed.y + RayCastFixed_Sin(player_fixed.angle));
+#else
+    int cell_x = (int)floorf(player_x + cosf(player_angle));
+    int cell_y = (int)floorf(player_y + sinf(player_angle));
+#endif
+
+    if (RayCast_CheckIsOutside(cell_x, cell_y))
+        return;
+
+    int cell = (cell_y * level_size_x) + cell_x;
+
+    if (RayCast_IsDoor(level_cells[cell]))
+        RayCast_SetDoor(cell_x, cell_y, !RayCastDoors_IsOpening(doors, cell));
+}
+
+static void RayCast_ToggleSettings(SDL_Scancode scancode)
+{
+    switch (scancode)
+    {
+    case SDL_SCANCODE_F:
+        fog_enabled = !fog_enabled;
+        break;
+    case SDL_SCANCODE_F2:
+        adaptive_cast_enabled = !adaptive_cast_enabled;
+        SDL_Log("%s Adaptive casting %s", program_log_tag, adaptive_cast_enabled ? "on" : "off");
+        break;
+    case SDL_SCANCODE_F3:
+        stats_log_enabled = !stats_log_enabled;
+        return;
+    case SDL_SCANCODE_F4:
+        lighting_enabled = !lighting_enabled;
+        break;
+    case SDL_SCANCODE_F5:
+        RayCast_ToggleCapture();
+        return;
+    case SDL_SCANCODE_F9:
+        RayCast_TogglePerfOverlay();
+        return;
+    case SDL_SCANCODE_F10:
+        antialias_enabled = !antialias_enabled;
+        SDL_Log("%s Edge anti-aliasing %s", program_log_tag, antialias_enabled ? "on" : "off");
+        break;
+    case SDL_SCANCODE_F6:
+    case SDL_SCANCODE_F7:
+    case SDL_SCANCODE_F8:
+    case SDL_SCANCODE_BACKSPACE:
+        RayCast_HandleSnapshotKey(scancode);
+        return;
+    case SDL_SCANCODE_E:
+        RayCast_ToggleDoorAhead();
+        return;
+    case SDL_SCANCODE_L:
+        lantern_enabled = !lantern_enabled;
+        if (!lantern_enabled)
+            RayCastLightMap_ClearDynamicLight(light_map, lantern_light_id);
+        return;
+    default:
+        return;
+    }
+
+    settings_revision++;
+}
+
+static void RayCast_DispatchEvents(void)
+{
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+        case SDL_EVENT_QUIT:
+            quit = true;
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            RayCast_MouseMotion(&event);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            KeyStatesSDL_UpdateState(&key_states, event.key.scancode, true);
+            if (!event.key.repeat)
+                RayCast_ToggleSettings(event.key.scancode);
+            break;
+        case SDL_EVENT_WINDOW_SHOWN:
+        case SDL_EVENT_WINDOW_EXPOSED:
+        case SDL_EVENT_WINDOW_RESTORED:
+        case SDL_EVENT_WINDOW_RESIZED:
+        case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            // The framebuffer is still valid, only the window contents are gone //
+            present_dirty = true;
+            break;
+        case SDL_EVENT_KEY_UP:
+            KeyStatesSDL_UpdateState(&key_states, event.key.scancode, false);
+            break;
+            /*
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            break;
+            */
+        }
+    }
+}
 
-                float new_pos_x, new_pos_y;
+static void RayCast_LogStats(void)
+{
+    if (!stats_log_enabled)
+        return;
 
-                float dist_to_edge_u, dist_to_edge_d, dist_to_edge_l, dist_to_edge_r;
+    stats_log_accum.columns += frame_stats.columns;
+    stats_log_accum.rays_traversed += frame_stats.rays_traversed;
+    stats_log_accum.aa_rays += frame_stats.aa_rays;
+    stats_log_accum.secondary_rays += frame_stats.secondary_rays;
+    stats_log_accum.secondary_skipped += frame_stats.secondary_skipped;
+    stats_log_frames++;
 
-                if (angle_ray >= (float)M_PI * -0.75F && angle_ray < (float)M_PI * -0.25F)
-                {
-                    // Up //
+    uint64_t current_tick = SDL_GetTicks();
+    if (current_tick - stats_log_last_tick < 1000)
+        return;
 
-                    dist_to_edge_u = ray_pos_y - edge_y_u;
+    double present_ms = (stats_present_count > 0) ? (double)stats_present_ns / stats_present_count / 1000000.0 : 0.0;
+
+    SDL_Log("%s %d frames, rays traversed %.1f / %.1f columns per frame, %.1f anti-aliasing rays, %.1f secondary rays (%.1f over budget), present %.3f ms (%s)",
+        program_log_tag, stats_log_frames,
+        (float)stats_log_accum.rays_traversed / stats_log_frames,
+        (float)stats_log_accum.columns / stats_log_frames,
+        (float)stats_log_accum.aa_rays / stats_log_frames,
+        (float)stats_log_accum.secondary_rays / stats_log_frames,
+        (float)stats_log_accum.secondary_skipped / stats_log_frames,
+        present_ms, surface_present ? "window surface" : "renderer");
+
+    memset(&stats_log_accum, 0, sizeof(stats_log_accum));
+    stats_log_frames = 0;
+    stats_present_ns = 0;
+    stats_present_count = 0;
+    stats_log_last_tick = current_tick;
+}
 
-                    new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
+void RayCast_GetFrameStats(RayCastFrameStats *stats)
+{
+    if (stats != NULL)
+        *stats = frame_stats;
+}
 
-                    if (new_pos_x >= edge_x_r)
-                    {
-                        dist_to_edge_r = edge_x_r - ray_pos_x;
+// NULL once MAX_LEVEL_EDITS are queued, or out of memory //
+static RayCastLevelEdit *RayCast_QueueLevelEdit(void)
+{
+    if (level_edit_count - level_edit_applied >= MAX_LEVEL_EDITS)
+        return NULL;
 
-                        new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
-                        new_pos_x = (float)edge_x_r;
+    if (level_edit_count == level_edit_capacity)
+    {
+        int edit_capacity = (level_edit_capacity > 0) ? level_edit_capacity * 2 : MAX_LEVEL_EDITS;
 
-                        center_pos_x++;
+        RayCastLevelEdit *edits = (RayCastLevelEdit *)realloc(level_edits, sizeof(RayCastLevelEdit) * (size_t)edit_capacity);
+        if (edits == NULL)
+        {
+            SDL_Log("%s Failed to allocate memory for level edits", program_log_tag);
+            return NULL;
+        }
 
-                        hit_from_udlr = 3;
-                    }
-                    else if (new_pos_x < edge_x_l)
-                    {
-                        dist_to_edge_l = ray_pos_x - edge_x_l;
+        level_edits = edits;
+        level_edit_capacity = edit_capacity;
+    }
 
-                        new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
-                        new_pos_x = (float)edge_x_l;
+    RayCastLevelEdit *edit = &level_edits[level_edit_count++];
+    edit->tick = 0;
+    edit->hash = 0;
 
-                        center_pos_x--;
+    return edit;
+}
 
-                        hit_from_udlr = 4;
-                    }
-                    else
-                    {
-                        new_pos_y = (float)edge_y_u;
+bool RayCast_SetCell(int x, int y, uint8_t material, uint8_t height)
+{
+    if (!initialized || RayCast_CheckIsOutside(x, y) || material >= MATERIAL_COUNT)
+        return false;
 
-                        center_pos_y--;
+    RayCastLevelEdit *edit = RayCast_QueueLevelEdit();
+    if (edit == NULL)
+        return false;
 
-                        hit_from_udlr = 2;
-                    }
-                }
-                else if (angle_ray >= (float)M_PI * -0.25F && angle_ray < (float)M_PI * 0.25F)
-                {
-                    // Right //
+    edit->kind = LEVEL_EDIT_CELL;
+    edit->cell = (y * level_size_x) + x;
+    edit->material = material;
+    edit->height = height;
+    edit->open = false;
 
-                    dist_to_edge_r = edge_x_r - ray_pos_x;
+    return true;
+}
 
-                    new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
+bool RayCast_ClearCell(int x, int y)
+{
+    return RayCast_SetCell(x, y, 0, 0);
+}
 
-                    if (new_pos_y >= edge_y_d)
-                    {
-                        dist_to_edge_d = edge_y_d - ray_pos_y;
+bool RayCast_SetDoor(int x, int y, bool open)
+{
+    if (!initialized || RayCast_CheckIsOutside(x, y))
+        return false;
 
-                        new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
-                        new_pos_y = (float)edge_y_d;
+    RayCastLevelEdit *edit = RayCast_QueueLevelEdit();
+    if (edit == NULL)
+        return false;
 
-                        center_pos_y++;
+    edit->kind = LEVEL_EDIT_DOOR;
+    edit->cell = (y * level_size_x) + x;
+    edit->material = 0;
+    edit->height = 0;
+    edit->open = open;
 
-                        hit_from_udlr = 1;
-                    }
-                    else if (new_pos_y < edge_y_u)
-                    {
-                        dist_to_edge_u = ray_pos_y - edge_y_u;
+    return true;
+}
 
-                        new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
-                        new_pos_y = (float)edge_y_u;
+// One batch: the cells change, then what is derived from them, around the edits only //
+static void RayCast_ApplyLevelEdits(void)
+{
+    int edited_cells[MAX_LEVEL_EDITS];
+    int edited_count = 0;
 
-                        center_pos_y--;
+    for (int i = level_edit_applied; i < level_edit_count; i++)
+    {
+        RayCastLevelEdit *edit = &level_edits[i];
 
-                        hit_from_udlr = 2;
-                    }
-                    else
-                    {
-                        new_pos_x = (float)edge_x_r;
+        // Stamped for replaying, snapshots of this history check the hash //
+        edit->tick = simulation_tick;
+        edit->hash = RayCast_HashLevelEdit(RayCast_GetAppliedEditHash(i), edit, edit->tick);
 
-                        center_pos_x++;
+        if (RayCast_ApplyLevelEdit(edit))
+            edited_cells[edited_count++] = edit->cell;
+    }
 
-                        hit_from_udlr = 3;
-                    }
-                }
-                else if (angle_ray >= (float)M_PI * 0.25F && angle_ray < (float)M_PI * 0.75F)
-                {
-                    // Down //
+    level_edit_applied = level_edit_count;
 
-                    dist_to_edge_d = edge_y_d - ray_pos_y;
+    if (edited_count == 0)
+        return;
 
-                    new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
+    RayCast_UpdateMaxHeight();
 
-                    if (new_pos_x >= edge_x_r)
-                    {
-                        dist_to_edge_r = edge_x_r - ray_pos_x;
+    // The PVS first, the lightmap clips dynamic lights with it //
+    RayCastPVS_UpdateCells(pvs, edited_cells, edited_count);
+    RayCastLightMap_UpdateCells(light_map, edited_cells, edited_count);
 
-                        new_pos_y = ray_pos_y + ((ray_dir_y / ray_dir_x) * dist_to_edge_r);
-                        new_pos_x = (float)edge_x_r;
+    level_revision++;
+}
 
-                        center_pos_x++;
+// Once per tick: queued edits, moving doors, then a few of the PVS sets edits left stale //
+static void RayCast_UpdateLevel(void)
+{
+    if (level_edit_applied < level_edit_count)
+        RayCast_ApplyLevelEdits();
 
-                        hit_from_udlr = 3;
-                    }
-                    else if (new_pos_x < edge_x_l)
-                    {
-                        dist_to_edge_l = ray_pos_x - edge_x_l;
+    if (RayCastDoors_Step(doors, door_step_per_tick) > 0)
+        level_revision++;
 
-                        new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
-                        new_pos_x = (float)edge_x_l;
+    // Stale sets answer visible meanwhile, at worst a dynamic light reaches a little too far //
+    if (RayCastPVS_Rebake(pvs, pvs_rebake_per_tick) > 0)
+        RayCastLightMap_RefreshDynamicLights(light_map);
+}
 
-                        center_pos_x--;
+// Gameplay line of sight: every wall cell blocks whatever its height, doors until fully open //
+bool RayCast_HasLineOfSight(float from_x, float from_y, float to_x, float to_y)
+{
+    // Also rejects NaN //
+    if (!(from_x >= 0.0F && from_x < (float)level_size_x && from_y >= 0.0F && from_y < (float)level_size_y &&
+          to_x >= 0.0F && to_x < (float)level_size_x && to_y >= 0.0F && to_y < (float)level_size_y))
+        return false;
 
-                        hit_from_udlr = 4;
-                    }
-                    else
-                    {
-                        new_pos_y = (float)edge_y_d;
+    int cell_x = (int)from_x;
+    int cell_y = (int)from_y;
 
-                        center_pos_y++;
+    int to_cell_x = (int)to_x;
+    int to_cell_y = (int)to_y;
 
-                        hit_from_udlr = 1;
-                    }
-                }
-                else
-                {
-                    // Left //
+    // Most rejections end here, without walking the grid //
+    if (!RayCastPVS_IsVisible(RayCast_RequirePVS(), (cell_y * level_size_x) + cell_x, (to_cell_y * level_size_x) + to_cell_x))
+        return false;
 
-                    dist_to_edge_l = ray_pos_x - edge_x_l;
+    float delta_x = to_x - from_x;
+    float delta_y = to_y - from_y;
 
-                    new_pos_y = ray_pos_y + ((ray_dir_y / (-ray_dir_x)) * dist_to_edge_l);
+    int step_x = (delta_x > 0.0F) ? 1 : -1;
+    int step_y = (delta_y > 0.0F) ? 1 : -1;
 
-                    if (new_pos_y >= edge_y_d)
-                    {
-                        dist_to_edge_d = edge_y_d - ray_pos_y;
+    float t_delta_x = (delta_x != 0.0F) ? fabsf(1.0F / delta_x) : INFINITY;
+    float t_delta_y = (delta_y != 0.0F) ? fabsf(1.0F / delta_y) : INFINITY;
 
-                        new_pos_x = ray_pos_x + ((ray_dir_x / ray_dir_y) * dist_to_edge_d);
-                        new_pos_y = (float)edge_y_d;
+    // An axis the line does not move along is never stepped; from a whole coordinate the product is NaN //
+    float t_max_x = INFINITY;
+    float t_max_y = INFINITY;
+    if (delta_x != 0.0F)
+        t_max_x = (delta_x > 0.0F) ? ((cell_x + 1) - from_x) * t_delta_x : (from_x - cell_x) * t_delta_x;
+    if (delta_y != 0.0F)
+        t_max_y = (delta_y > 0.0F) ? ((cell_y + 1) - from_y) * t_delta_y : (from_y - cell_y) * t_delta_y;
 
-                        center_pos_y++;
+    while (cell_x != to_cell_x || cell_y != to_cell_y)
+    {
+        if (t_max_x < t_max_y)
+        {
+            if (t_max_x >= 1.0F)
+                break;
 
-                        hit_from_udlr = 1;
-                    }
-                    else if (new_pos_y < edge_y_u)
-                    {
-                        dist_to_edge_u = ray_pos_y - edge_y_u;
+            cell_x += step_x;
+            t_max_x += t_delta_x;
+        }
+        else
+        {
+            if (t_max_y >= 1.0F)
+                break;
 
-                        new_pos_x = ray_pos_x + ((ray_dir_x / (-ray_dir_y)) * dist_to_edge_u);
-                        new_pos_y = (float)edge_y_u;
+            cell_y += step_y;
+            t_max_y += t_delta_y;
+        }
 
-                        center_pos_y--;
+        if (RayCast_CheckIsWall(cell_x, cell_y))
+            return false;
+    }
 
-                        hit_from_udlr = 2;
-                    }
-                    else
-                    {
-                        new_pos_x = (float)edge_x_l;
+    return true;
+}
 
-                        center_pos_x--;
+static RayCastViewState RayCast_CaptureViewState(void)
+{
+    RayCastViewState view_state;
 
-                        hit_from_udlr = 4;
-                    }
-                }
+    view_state.player_x = player_x;
+    view_state.player_y = player_y;
+    view_state.player_angle = player_angle;
 
-                ray_pos_x = new_pos_x;
-                ray_pos_y = new_pos_y;
-            }
+    view_state.settings_revision = settings_revision;
+    view_state.level_revision = level_revision;
+    view_state.lighting_revision = RayCastLightMap_GetRevision(light_map);
 
-            if (ray_pos_x < 0 || ray_pos_x >= level_size_x ||
-                ray_pos_y < 0 || ray_pos_y >= level_size_y)
-                break;
-            else if (level_data[center_pos_y][center_pos_x] != 0)
-                break;
-        }
+    return view_state;
+}
 
-        float ray_from_to_x = ray_pos_x - player_x;
-        float ray_from_to_y = ray_pos_y - player_y;
+static bool RayCast_IsViewStateEqual(const RayCastViewState *a, const RayCastViewState *b)
+{
+    return
+        a->player_x == b->player_x &&
+        a->player_y == b->player_y &&
+        a->player_angle == b->player_angle &&
+        a->settings_revision == b->settings_revision &&
+        a->level_revision == b->level_revision &&
+        a->lighting_revision == b->lighting_revision;
+}
 
-        float z_from_player = (ray_from_to_x * player_dir_x) + (ray_from_to_y * player_dir_y);
+bool RayCast_IsIdle(void)
+{
+    if (!initialized)
+        return false;
 
-        z_list[x] = z_from_player;
+    // A capture needs every tick, even unchanged ones //
+    if (frame_capture != NULL)
+        return false;
 
-        switch (hit_from_udlr)
-        {
-        case 1:
-        case 2:
-            texture_x_list[x] = fmodf(ray_pos_x, 1.0F);
-            break;
-        case 3:
-        case 4:
-            texture_x_list[x] = fmodf(ray_pos_y, 1.0F);
-            break;
-        }
-    }
+    // A finished load does not wake the wait, keep polling until its texture is swapped in //
+    if (TextureCacheSDL_GetPendingCount(texture_cache) > 0)
+        return false;
 
-    // Rendering Routine //
+    return frame_skipped && player_vel_x == 0.0F && player_vel_y == 0.0F;
+}
 
-    int wall_tex_width, wall_tex_height;
-    int wall_tex_pitch;
-    int wall_tex_channels;
-    uint8_t *ptr_wall_tex_pixels = NULL;
-    if (wall_texture != NULL)
-    {
-        wall_tex_width = wall_texture->w;
-        wall_tex_height = wall_texture->h;
+bool RayCast_Tick(void)
+{
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_EVENTS);
 
-        wall_tex_pitch = wall_texture->pitch;
+    RayCast_DispatchEvents();
 
-        wall_tex_channels = wall_tex_pitch / wall_tex_width;
+    RayCastPerf_End(perf_counters, PERF_STAGE_EVENTS);
 
-        ptr_wall_tex_pixels = (uint8_t *)wall_texture->pixels;
-    }
+    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_ESCAPE))
+        quit = true;
 
-    uint8_t *pixel_buffer = NULL;
-    int pitch;
+    if (quit)
+        return false;
 
-    SDL_LockTexture(texture, NULL, (void **)&pixel_buffer, &pitch);
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_LEVEL);
 
-    // memset((void *)pixel_buffer, 0, screen_width * screen_height * screen_channels);
+    RayCast_UpdateLevel();
 
-    float middle_y = screen_height / 2.0F;
+    RayCastPerf_End(perf_counters, PERF_STAGE_LEVEL);
 
-    for (int x = 0; x < screen_width; x++)
-    {
-        int y = 0;
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_MOVEMENT);
 
-        // int pixel_buffer_offset = ((pixel_y_start * screen_width) + x) * screen_channels;
-        int pixel_buffer_offset = x * screen_channels;
-        int increment_per_row = (screen_width - 1) * screen_channels;
+    RayCast_PlayerMovement();
 
-        uint8_t *ptr_pixel_buffer = pixel_buffer + pixel_buffer_offset;
+    RayCast_PlayerCollisionDetection();
 
-        float current_z = z_list[x];
+#if RAYCAST_FIXED_POINT
+    RayCast_SyncPlayerFromFixed();
+#endif
 
-        if (current_z < z_cutoff)
-            continue;
+    if (lantern_enabled)
+    {
+        RayCastLight lantern = { player_x, player_y, 0.5F, lantern_radius, lantern_intensity };
+        RayCastLightMap_SetDynamicLight(light_map, lantern_light_id, &lantern);
+    }
 
-        float bar_height = 1.0F / current_z * height_z_one;
-        float bar_height_half = bar_height / 2.0F;
+    RayCastPerf_End(perf_counters, PERF_STAGE_MOVEMENT);
 
-        int start_y = (int)(middle_y - bar_height_half);
-        int end_y = (int)(middle_y + bar_height_half);
-        int range_y = end_y - start_y;
+    simulation_tick++;
 
-        float brightness = fmaxf(fade_distance - current_z, 0.0) / fade_distance;
-        if (brightness <= 0.0F)
-        {
-            while (y < screen_height)
-            {
-                *ptr_pixel_buffer++ = 0;
-                *ptr_pixel_buffer++ = 0;
-                *ptr_pixel_buffer++ = 0;
+    // Well under a microsecond, so every tick is kept for rollback //
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_SNAPSHOT);
 
-                ptr_pixel_buffer += increment_per_row;
+    if (snapshot_ring != NULL)
+        RayCast_SaveSnapshot(RayCastSnapshotRing_Push(snapshot_ring));
 
-                y++;
-            }
+    RayCastPerf_End(perf_counters, PERF_STAGE_SNAPSHOT);
 
-            continue;
-        }
+    RayCastPerf_Begin(perf_counters, PERF_STAGE_TEXTURES);
 
-        brightness = fminf(fmaxf(0.0F, brightness), 1.0F);
+    if (TextureCacheSDL_Update(texture_cache))
+        frame_dirty = true;
 
-        int pixel_y_start = start_y;
-        if (pixel_y_start < 0)
-            pixel_y_start = 0;
+    RayCastPerf_End(perf_counters, PERF_STAGE_TEXTURES);
 
-        int pixel_y_end = end_y;
-        if (pixel_y_end >= screen_height)
-            pixel_y_end = screen_height;
+    RayCastViewState view_state = RayCast_CaptureViewState();
+    if (!RayCast_IsViewStateEqual(&view_state, &rendered_view_state))
+        frame_dirty = true;
 
-        while (y < pixel_y_start)
-        {
-            *ptr_pixel_buffer++ = 0;
-            *ptr_pixel_buffer++ = 0;
-            *ptr_pixel_buffer++ = 0;
+    frame_skipped = !frame_dirty;
 
-            ptr_pixel_buffer += increment_per_row;
+    if (frame_dirty)
+    {
+        RayCast_DoRayCastAndRender();
 
-            y++;
-        }
+        RayCast_LogStats();
 
-        if (wall_texture == NULL)
-        {
-            // Default White Wall Without Texture //
+        rendered_view_state = view_state;
 
-            uint8_t brightness_byte = (uint8_t)(brightness * 255.0F);
+        frame_dirty = false;
+        present_dirty = true;
+    }
+    else if (frame_capture != NULL)
+        FrameCaptureSDL_SubmitRepeat(frame_capture);
 
-            while (y < pixel_y_end)
-            {
-                *ptr_pixel_buffer++ = brightness_byte;
-                *ptr_pixel_buffer++ = brightness_byte;
-                *ptr_pixel_buffer++ = brightness_byte;
+    // The previous frame stays on screen, nothing to present //
+    if (present_dirty)
+    {
+        uint64_t present_start = SDL_GetTicksNS();
 
-                ptr_pixel_buffer += increment_per_row;
+        RayCastPerf_Begin(perf_counters, PERF_STAGE_PRESENT);
 
-                y++;
-            }
-        }
+        if (surface_present)
+            RayCast_PresentSurface();
         else
         {
-            // Wall With Texture Loaded //
-
-            int texture_x = (int)(texture_x_list[x] * (float)wall_tex_width);
-            if (texture_x < 0)
-                texture_x = 0;
-            if (texture_x >= wall_tex_width)
-                texture_x = wall_tex_width - 1;
-
-            while (y < pixel_y_end)
-            {
-                int texture_y = (int)(((float)(y - start_y) / (float)range_y) * wall_tex_height);
-                if (texture_y < 0)
-                    texture_y = 0;
-                if (texture_y >= wall_tex_height)
-                    texture_y = wall_tex_height - 1;
+            SDL_RenderTexture(renderer, texture, NULL, NULL);
 
-                uint8_t *ptr_wall_tex = ptr_wall_tex_pixels + ((texture_y * wall_tex_pitch) + (texture_x * wall_tex_channels));
+            if (perf_overlay_enabled)
+                RayCastPerf_DrawOverlay(perf_counters, renderer);
 
-                *ptr_pixel_buffer++ = (uint8_t)((*ptr_wall_tex++) * brightness);
-                *ptr_pixel_buffer++ = (uint8_t)((*ptr_wall_tex++) * brightness);
-                *ptr_pixel_buffer++ = (uint8_t)((*ptr_wall_tex++) * brightness);
-
-                ptr_pixel_buffer += increment_per_row;
-
-                y++;
-            }
+            SDL_RenderPresent(renderer);
         }
 
-        while (y < screen_height)
-        {
-            *ptr_pixel_buffer++ = 0;
-            *ptr_pixel_buffer++ = 0;
-            *ptr_pixel_buffer++ = 0;
+        RayCastPerf_End(perf_counters, PERF_STAGE_PRESENT);
 
-            ptr_pixel_buffer += increment_per_row;
+        stats_present_ns += SDL_GetTicksNS() - present_start;
+        stats_present_count++;
 
-            y++;
-        }
+        present_dirty = false;
     }
 
-    SDL_UnlockTexture(texture);
+    // New averages go up on the next present //
+    if (RayCastPerf_EndFrame(perf_counters, simulation_tick) && perf_overlay_enabled)
+        present_dirty = true;
+
+    return true;
 }
 
-static void RayCast_MouseMotion(SDL_Event *event)
+void RayCast_GetFrameLayout(int *width, int *height, int *bytes_per_pixel)
 {
-    player_angle += event->motion.xrel * mouse_sensitivity;
-    player_angle = RayCast_WrapAngle(player_angle);
+    *width = screen_width;
+    *height = screen_height;
+    *bytes_per_pixel = screen_channels;
 }
 
-static void RayCast_PlayerMovement(void)
+// Main thread, before each batch of RayCast_RenderPose calls. Every material is //
+// acquired since any view may need it. False while textures are still loading.  //
+// Level edits advance here as they would once per tick.                         //
+bool RayCast_PrepareBatch(void)
 {
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LEFT))
-        player_angle -= player_turn_speed_per_tick;
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_RIGHT))
-        player_angle += player_turn_speed_per_tick;
-    player_angle = RayCast_WrapAngle(player_angle);
-
-    float player_angle_right = player_angle + (float)M_PI_2;
-
-    float player_accel_forward_x = cosf(player_angle);
-    float player_accel_forward_y = sinf(player_angle);
-
-    float player_accel_right_x = cosf(player_angle_right);
-    float player_accel_right_y = sinf(player_angle_right);
-
-    float player_accel_x = 0.0F;
-    float player_accel_y = 0.0F;
-
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_A))
-    {
-        player_accel_x -= player_accel_right_x;
-        player_accel_y -= player_accel_right_y;
-    }
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_D))
-    {
-        player_accel_x += player_accel_right_x;
-        player_accel_y += player_accel_right_y;
-    }
-    
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_S))
-    {
-        player_accel_x -= player_accel_forward_x;
-        player_accel_y -= player_accel_forward_y;
-    }
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_W))
-    {
-        player_accel_x += player_accel_forward_x;
-        player_accel_y += player_accel_forward_y;
-    }
-
-    float player_max_vel;
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_LSHIFT))
-        player_max_vel = player_vel_sprint_per_tick;
-    else
-        player_max_vel = player_vel_walk_per_tick;
-
-    RayCast_VecClampLength(&player_accel_x, &player_accel_y, player_accel_per_tick);
+    RayCast_UpdateLevel();
 
-    player_vel_x += player_accel_x;
-    player_vel_y += player_accel_y;
+    TextureCacheSDL_Update(texture_cache);
 
-    if (RayCast_Vec2Len(player_accel_x, player_accel_y) < 0.0001F)
+    for (int i = 0; i < MATERIAL_COUNT; i++)
     {
-        player_vel_x *= player_fraction;
-        player_vel_y *= player_fraction;
-
-        if (RayCast_Vec2Len(player_vel_x, player_vel_y) < 0.0001F)
-            player_vel_x = player_vel_y = 0.0F;
+        if (material_texture_names[i] != NULL)
+            frame_materials[i] = TextureCacheSDL_Acquire(texture_cache, i);
     }
 
-    RayCast_VecClampLength(&player_vel_x, &player_vel_y, player_max_vel);
-
-    player_x += player_vel_x;
-    player_y += player_vel_y;
-}
-
-static void RayCast_DispatchEvents(void)
-{
-    SDL_Event event;
-
-    while (SDL_PollEvent(&event))
-    {
-        switch (event.type)
-        {
-        case SDL_EVENT_QUIT:
-            quit = true;
-            break;
-        case SDL_EVENT_MOUSE_MOTION:
-            RayCast_MouseMotion(&event);
-            break;
-        case SDL_EVENT_KEY_DOWN:
-            KeyStatesSDL_UpdateState(&key_states, event.key.scancode, true);
-            break;
-        case SDL_EVENT_KEY_UP:
-            KeyStatesSDL_UpdateState(&key_states, event.key.scancode, false);
-            break;
-            /*
-        case SDL_EVENT_MOUSE_BUTTON_DOWN:
-            break;
-        case SDL_EVENT_MOUSE_BUTTON_UP:
-            break;
-            */
-        }
-    }
+    return (TextureCacheSDL_GetPendingCount(texture_cache) == 0);
 }
 
-bool RayCast_Tick(void)
+// Safe to call from several threads at once, each with its own context. //
+// Returns the rays traversed, anti-aliasing and secondary ones included, or -1 if the pose is not inside the level. //
+int RayCast_RenderPose(RayCastRenderContext *context, const RayCastPose *pose, uint8_t *pixels, int pitch)
 {
-    RayCast_DispatchEvents();
-
-    if (KeyStatesSDL_IsKeyDown(&key_states, SDL_SCANCODE_ESCAPE))
-        quit = true;
-
-    if (quit)
-        return false;
-
-    RayCast_PlayerMovement();
-
-    RayCast_PlayerCollisionDetection();
-
-    RayCast_DoRayCastAndRender();
-
-    SDL_RenderTexture(renderer, texture, NULL, NULL);
-
-    SDL_RenderPresent(renderer);
-
-    return true;
+    // Also rejects NaN //
+    if (!(pose->pos_x >= 0.0F && pose->pos_x < (float)level_size_x &&
+          pose->pos_y >= 0.0F && pose->pos_y < (float)level_size_y &&
+          isfinite(pose->angle)))
+        return -1;
+
+    RayCastCamera camera;
+    RayCast_SetupCamera(&camera, pose->pos_x, pose->pos_y, pose->angle);
+#if RAYCAST_FIXED_POINT
+    // Quantized once at the boundary, like mouse input //
+    RayCast_SetupCameraFixed(&camera,
+        (RayCastFixed)lroundf(pose->pos_x * RAYCAST_FIXED_ONE),
+        (RayCastFixed)lroundf(pose->pos_y * RAYCAST_FIXED_ONE),
+        RayCastAngle_Wrap((RayCastAngle)lroundf(fmodf(pose->angle, 2.0F * (float)M_PI) * (RAYCAST_ANGLE_TURN / (2.0F * (float)M_PI)))));
+#endif
+
+    if (!RayCast_CastView(context, &camera))
+        return -1;
+
+    RayCast_FillView(context, &camera, pixels, pitch);
+
+    RayCast_AntiAliasView(context, &camera, pixels, pitch);
+
+    return context->rays_traversed + context->aa_rays + context->secondary_rays;
 }
@@ -1,14 +1,88 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastLevel.h"
+#include "RayCastSnapshot.h"
+
+typedef struct
+{
+    int columns;
+    int rays_traversed;
+    int aa_rays; // Extra sub-column rays at edges, on top of rays_traversed //
+
+    // Spawned by mirror and glass faces, on top of the above. Skipped ones were over //
+    // the budget and show a neighbor's image or just the face.                      //
+    int secondary_rays;
+    int secondary_skipped;
+}
+RayCastFrameStats;
+
+typedef struct
+{
+    float pos_x, pos_y;
+    float angle;
+}
+RayCastPose;
+
+// Per-thread scratch for RayCast_RenderPose //
+typedef struct RayCastRenderContext RayCastRenderContext;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+    // Before initializing; NULL goes back to the built-in level. Cells are materials, heights //
+    // are in sixteenths of a cell; both are copied when initializing, edits change the copy.  //
+    extern bool RayCast_SetLevel(const RayCastLevelView *level, int start_x, int start_y);
+
+    // Rays give up this many cells from the camera on either axis, 0 for no limit //
+    extern void RayCast_SetViewDistance(int cells);
+
     extern bool RayCast_Initialize(void);
+    extern bool RayCast_InitializeHeadless(void);
     extern void RayCast_Deinitialize(void);
 
     extern bool RayCast_Tick(void);
 
+    extern bool RayCast_IsIdle(void);
+
+    extern void RayCast_GetFrameStats(RayCastFrameStats *stats);
+
+    extern bool RayCast_HasLineOfSight(float from_x, float from_y, float to_x, float to_y);
+
+    // Level Edits //
+
+    // Queued, then applied together at the start of the next tick; only what is derived from //
+    // the cells around each edit is updated. False outside the level, for unknown materials  //
+    // or once this tick's queue is full.                                                      //
+    extern bool RayCast_SetCell(int x, int y, uint8_t material, uint8_t height);
+    extern bool RayCast_ClearCell(int x, int y);
+
+    // Door cells slide open or shut over the ticks that follow, other cells ignore it //
+    extern bool RayCast_SetDoor(int x, int y, bool open);
+
+    // Snapshots, of the player, settings and level edits. Restoring replays the level up to the //
+    // snapshot; one from a run of edits this one has not been through is refused.               //
+
+    extern void RayCast_SaveSnapshot(RayCastSnapshot *snapshot);
+    extern bool RayCast_RestoreSnapshot(const RayCastSnapshot *snapshot);
+
+    extern bool RayCast_Rewind(int ticks);
+    extern bool RayCast_Restart(void);
+
+    // Headless Rendering //
+
+    extern RayCastRenderContext *RayCast_CreateRenderContext(void);
+    extern void RayCast_DestroyRenderContext(RayCastRenderContext *context);
+
+    // Frames are rows of width * bytes_per_pixel, B, G, R(, X) in memory //
+    extern void RayCast_GetFrameLayout(int *width, int *height, int *bytes_per_pixel);
+
+    extern bool RayCast_PrepareBatch(void);
+    extern int RayCast_RenderPose(RayCastRenderContext *context, const RayCastPose *pose, uint8_t *pixels, int pitch);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,98 @@
+#include "RayCastFixed.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Quarter wave, one entry per 16 angle units, plus the end point //
+#define SIN_TABLE_STEPS     1024
+#define SIN_TABLE_SHIFT     4
+
+// PI / 2 in 2.30 //
+#define HALF_PI_Q30         1686629713LL
+#define ONE_Q30             (1LL << 30)
+
+static RayCastFixed sin_table[SIN_TABLE_STEPS + 1];
+
+void RayCastFixed_InitTables(void)
+{
+    // Taylor series evaluated in 2.30 integers; the libm sinf() differs across hosts. //
+    // Seven terms leave the error well under one 16.16 step on [0, PI / 2].          //
+    for (int i = 0; i <= SIN_TABLE_STEPS; i++)
+    {
+        int64_t x = (HALF_PI_Q30 * i) / SIN_TABLE_STEPS;
+        int64_t x_squared = (x * x) / ONE_Q30;
+
+        int64_t term = x;
+        int64_t sum = x;
+
+        for (int n = 1; n <= 6; n++)
+        {
+            term = (term * x_squared) / ONE_Q30;
+            term = -term / ((2 * n) * ((2 * n) + 1));
+
+            sum += term;
+        }
+
+        int64_t value = (sum + (1LL << 13)) / (1LL << 14);
+        if (value > RAYCAST_FIXED_ONE)
+            value = RAYCAST_FIXED_ONE;
+        if (value < 0)
+            value = 0;
+
+        sin_table[i] = (RayCastFixed)value;
+    }
+}
+
+RayCastFixed RayCastFixed_Sin(RayCastAngle angle)
+{
+    angle = RayCastAngle_Wrap(angle);
+
+    int quadrant = angle / RAYCAST_ANGLE_QUARTER;
+    int offset = angle % RAYCAST_ANGLE_QUARTER;
+
+    // Second And Fourth Quadrants Run The Table Backwards //
+    if (quadrant & 1)
+        offset = RAYCAST_ANGLE_QUARTER - offset;
+
+    int index = offset >> SIN_TABLE_SHIFT;
+    int fraction = offset & ((1 << SIN_TABLE_SHIFT) - 1);
+
+    RayCastFixed value = sin_table[index];
+    if (fraction != 0)
+        value += ((sin_table[index + 1] - value) * fraction) >> SIN_TABLE_SHIFT;
+
+    return (quadrant >= 2) ? -value : value;
+}
+
+RayCastFixed RayCastFixed_Cos(RayCastAngle angle)
+{
+    return RayCastFixed_Sin(angle + RAYCAST_ANGLE_QUARTER);
+}
+
+uint32_t RayCastFixed_Sqrt64(uint64_t value)
+{
+    // Bit-By-Bit Integer Square Root, Rounded Down //
+
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 16.16 Fixed Point //
+// Integer operations only, so every host and compiler produces the same bits. //
+// Right shifts of negative values are assumed arithmetic, as on every         //
+// compiler this project builds with.                                          //
+
+#define RAYCAST_FIXED_SHIFT         16
+#define RAYCAST_FIXED_ONE           (1 << RAYCAST_FIXED_SHIFT)
+#define RAYCAST_FIXED_HALF          (RAYCAST_FIXED_ONE / 2)
+#define RAYCAST_FIXED_FRACTION_MASK (RAYCAST_FIXED_ONE - 1)
+
+// Binary Angle: A Full Turn Is RAYCAST_ANGLE_TURN Units And Wraps With A Mask //
+
+#define RAYCAST_ANGLE_TURN          (1 << 16)
+#define RAYCAST_ANGLE_MASK          (RAYCAST_ANGLE_TURN - 1)
+#define RAYCAST_ANGLE_HALF          (RAYCAST_ANGLE_TURN / 2)
+#define RAYCAST_ANGLE_QUARTER       (RAYCAST_ANGLE_TURN / 4)
+
+typedef int32_t RayCastFixed;
+typedef int32_t RayCastAngle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern void RayCastFixed_InitTables(void);
+
+    extern RayCastFixed RayCastFixed_Sin(RayCastAngle angle);
+    extern RayCastFixed RayCastFixed_Cos(RayCastAngle angle);
+
+    extern uint32_t RayCastFixed_Sqrt64(uint64_t value);
+
+    static inline RayCastFixed RayCastFixed_FromInt(int value)
+    {
+        return (RayCastFixed)(value * RAYCAST_FIXED_ONE);
+    }
+
+    static inline int RayCastFixed_Floor(RayCastFixed value)
+    {
+        return (int)(value >> RAYCAST_FIXED_SHIFT);
+    }
+
+    static inline float RayCastFixed_ToFloat(int64_t value)
+    {
+        return (float)value * (1.0F / RAYCAST_FIXED_ONE);
+    }
+
+    static inline RayCastFixed RayCastFixed_Abs(RayCastFixed value)
+    {
+        return (value < 0) ? -value : value;
+    }
+
+    static inline RayCastFixed RayCastFixed_Mul(RayCastFixed a, RayCastFixed b)
+    {
+        return (RayCastFixed)(((int64_t)a * b) >> RAYCAST_FIXED_SHIFT);
+    }
+
+    // Wide variant for ray distances, which can exceed the 16.16 range near grazing angles //
+    static inline int64_t RayCastFixed_Mul64(int64_t a, int64_t b)
+    {
+        return (a * b) >> RAYCAST_FIXED_SHIFT;
+    }
+
+    static inline RayCastFixed RayCastFixed_Div(RayCastFixed a, RayCastFixed b)
+    {
+        return (RayCastFixed)(((int64_t)a * RAYCAST_FIXED_ONE) / b);
+    }
+
+    static inline RayCastFixed RayCastFixed_Length(RayCastFixed x, RayCastFixed y)
+    {
+        // 32.32 squared length, its root is back in 16.16 //
+        return (RayCastFixed)RayCastFixed_Sqrt64((uint64_t)(((int64_t)x * x) + ((int64_t)y * y)));
+    }
+
+    static inline RayCastAngle RayCastAngle_Wrap(RayCastAngle angle)
+    {
+        return angle & RAYCAST_ANGLE_MASK;
+    }
+
+    // Radians in (-PI, PI], matching what the float path keeps in player_angle //
+    static inline float RayCastAngle_ToRadians(RayCastAngle angle)
+    {
+        int32_t signed_angle = RayCastAngle_Wrap(angle);
+        if (signed_angle > RAYCAST_ANGLE_HALF)
+            signed_angle -= RAYCAST_ANGLE_TURN;
+
+        return (float)signed_angle * (6.28318530717958647692F / RAYCAST_ANGLE_TURN);
+    }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// U = 1; D = 2; L = 3; R = 4; as hit_from_udlr, minus one //
+#define RAYCAST_FACE_U      0
+#define RAYCAST_FACE_D      1
+#define RAYCAST_FACE_L      2
+#define RAYCAST_FACE_R      3
+#define RAYCAST_FACE_COUNT  4
+
+typedef struct
+{
+    int size_x, size_y;
+
+    // Row-major, size_x * size_y //
+    const uint8_t *cells;
+    const uint8_t *heights;
+
+    // Indexed by cell value, nonzero for walls that sight may pass, e.g. doors that open; //
+    // NULL when every wall blocks it                                                      //
+    const uint8_t *see_through;
+
+    float height_unit;
+}
+RayCastLevelView;
+
+static inline bool RayCastLevel_IsWall(const RayCastLevelView *level, int x, int y)
+{
+    if (x < 0 || x >= level->size_x || y < 0 || y >= level->size_y)
+        return true;
+
+    return (level->cells[(y * level->size_x) + x] != 0);
+}
+
+static inline bool RayCastLevel_BlocksSight(const RayCastLevelView *level, int x, int y)
+{
+    if (!RayCastLevel_IsWall(level, x, y))
+        return false;
+
+    return (level->see_through == NULL || level->see_through[level->cells[(y * level->size_x) + x]] == 0);
+}
+
+static inline float RayCastLevel_GetHeight(const RayCastLevelView *level, int x, int y)
+{
+    return level->heights[(y * level->size_x) + x] * level->height_unit;
+}
+
+// The empty cell a face looks into //
+static inline void RayCastLevel_GetFaceNeighbor(int x, int y, int face, int *neighbor_x, int *neighbor_y)
+{
+    *neighbor_x = x;
+    *neighbor_y = y;
+
+    switch (face)
+    {
+    case RAYCAST_FACE_U:
+        (*neighbor_y)--;
+        break;
+    case RAYCAST_FACE_D:
+        (*neighbor_y)++;
+        break;
+    case RAYCAST_FACE_L:
+        (*neighbor_x)--;
+        break;
+    case RAYCAST_FACE_R:
+        (*neighbor_x)++;
+        break;
+    }
+}
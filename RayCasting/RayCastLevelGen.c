@@ -0,0 +1,386 @@
+#include "RayCastLevelGen.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+#include <SDL3/SDL.h>
+
+// Matches the engine, walls are this many sixteenths tall //
+#define LEVELGEN_HEIGHT_UNIT    16
+
+// Streets between city blocks //
+#define LEVELGEN_STREET_WIDTH   2
+
+static const uint8_t wall_material = 1;
+
+static const char *const kind_names[RAYCAST_LEVELGEN_KIND_COUNT] =
+{
+    "maze",
+    "pillars",
+    "corridors",
+    "city"
+};
+
+static const char program_log_tag[] = "[RayCastLevelGen.c]";
+
+// SplitMix64: integer only, so a seed means the same level everywhere //
+typedef struct
+{
+    uint64_t state;
+}
+RayCastLevelGenRng;
+
+static uint64_t RayCastLevelGen_Next(RayCastLevelGenRng *rng)
+{
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static uint32_t RayCastLevelGen_NextBelow(RayCastLevelGenRng *rng, uint32_t bound)
+{
+    return (uint32_t)(((RayCastLevelGen_Next(rng) >> 32) * bound) >> 32);
+}
+
+// Probabilities are turned into 32-bit thresholds once, draws are compared as integers //
+static uint64_t RayCastLevelGen_GetThreshold(float probability)
+{
+    if (!(probability > 0.0F))
+        return 0;
+
+    if (probability >= 1.0F)
+        return 1ULL << 32;
+
+    return (uint64_t)((double)probability * 4294967296.0);
+}
+
+static inline bool RayCastLevelGen_Chance(RayCastLevelGenRng *rng, uint64_t threshold)
+{
+    return (RayCastLevelGen_Next(rng) >> 32) < threshold;
+}
+
+static inline void RayCastLevelGen_SetCell(RayCastGeneratedLevel *level, int x, int y, uint8_t material)
+{
+    level->cells[((size_t)y * level->view.size_x) + x] = material;
+}
+
+// Sidewinder on the odd cells: each row is cut into runs, and every run opens //
+// north from one random cell. One row of state, so the largest sizes are fine. //
+static void RayCastLevelGen_Maze(RayCastGeneratedLevel *level, const RayCastLevelGenParams *params, RayCastLevelGenRng *rng)
+{
+    const int nodes_x = (level->view.size_x - 1) / 2;
+    const int nodes_y = (level->view.size_y - 1) / 2;
+
+    const uint64_t close_threshold = RayCastLevelGen_GetThreshold(1.0F / params->run_length);
+    const uint64_t remove_threshold = RayCastLevelGen_GetThreshold(1.0F - params->density);
+
+    memset(level->cells, wall_material, (size_t)level->view.size_x * level->view.size_y);
+
+    for (int node_y = 0; node_y < nodes_y; node_y++)
+    {
+        int y = (2 * node_y) + 1;
+        int run_start = 0;
+
+        for (int node_x = 0; node_x < nodes_x; node_x++)
+        {
+            int x = (2 * node_x) + 1;
+
+            RayCastLevelGen_SetCell(level, x, y, 0);
+
+            // The first row has nothing to open into, it is one long run //
+            bool last_in_row = (node_x == nodes_x - 1);
+            bool close_run = (node_y > 0) && (last_in_row || RayCastLevelGen_Chance(rng, close_threshold));
+
+            if (close_run)
+            {
+                int door_x = run_start + (int)RayCastLevelGen_NextBelow(rng, (uint32_t)(node_x - run_start + 1));
+
+                RayCastLevelGen_SetCell(level, (2 * door_x) + 1, y - 1, 0);
+
+                run_start = node_x + 1;
+            }
+            else if (!last_in_row)
+                RayCastLevelGen_SetCell(level, x + 1, y, 0);
+        }
+    }
+
+    // Braid: knock out walls between passages, each one adds a loop and longer sightlines //
+    if (remove_threshold == 0)
+        return;
+
+    for (int y = 1; y < 2 * nodes_y; y++)
+    {
+        for (int x = 1; x < 2 * nodes_x; x++)
+        {
+            // Exactly one even coordinate: a wall between two passage cells //
+            if (((x ^ y) & 1) == 0)
+                continue;
+
+            if (RayCastLevelGen_Chance(rng, remove_threshold))
+                RayCastLevelGen_SetCell(level, x, y, 0);
+        }
+    }
+}
+
+static void RayCastLevelGen_Pillars(RayCastGeneratedLevel *level, const RayCastLevelGenParams *params, RayCastLevelGenRng *rng)
+{
+    const uint64_t pillar_threshold = RayCastLevelGen_GetThreshold(params->density);
+
+    for (int y = 0; y < level->view.size_y; y++)
+    {
+        for (int x = 0; x < level->view.size_x; x++)
+        {
+            size_t cell = ((size_t)y * level->view.size_x) + x;
+
+            if (RayCastLevelGen_Chance(rng, pillar_threshold))
+            {
+                // A quarter to two cells tall, the short ones are seen over //
+                level->cells[cell] = wall_material;
+                level->heights[cell] = (uint8_t)(4 + RayCastLevelGen_NextBelow(rng, 29));
+            }
+            else
+                level->cells[cell] = 0;
+        }
+    }
+}
+
+// Corridors run along x on the odd rows, cut by a cross wall every run_length cells //
+static void RayCastLevelGen_Corridors(RayCastGeneratedLevel *level, const RayCastLevelGenParams *params, RayCastLevelGenRng *rng)
+{
+    const int size_x = level->view.size_x;
+    const int size_y = level->view.size_y;
+
+    const uint64_t wall_threshold = RayCastLevelGen_GetThreshold(params->density);
+
+    for (int y = 0; y < size_y; y++)
+    {
+        if ((y & 1) == 0)
+        {
+            for (int x = 0; x < size_x; x++)
+                RayCastLevelGen_SetCell(level, x, y, RayCastLevelGen_Chance(rng, wall_threshold) ? wall_material : 0);
+        }
+        else
+        {
+            memset(&level->cells[(size_t)y * size_x], 0, (size_t)size_x);
+
+            int phase = (int)RayCastLevelGen_NextBelow(rng, (uint32_t)params->run_length);
+
+            for (int x = phase; x < size_x; x += params->run_length)
+            {
+                if (x == 0)
+                    continue;
+
+                // Doors on either side of the cross wall keep both halves reachable //
+                RayCastLevelGen_SetCell(level, x, y, wall_material);
+                RayCastLevelGen_SetCell(level, x - 1, y - 1, 0);
+
+                if (y + 1 < size_y && x + 1 < size_x)
+                    RayCastLevelGen_SetCell(level, x + 1, y + 1, 0);
+            }
+        }
+    }
+}
+
+// Blocks of run_length cells between streets, each built up or left as a plaza //
+static void RayCastLevelGen_City(RayCastGeneratedLevel *level, const RayCastLevelGenParams *params)
+{
+    const int size_x = level->view.size_x;
+    const int size_y = level->view.size_y;
+
+    const int period = params->run_length + LEVELGEN_STREET_WIDTH;
+    const int blocks_x = (size_x + period - 1) / period;
+
+    const uint64_t built_threshold = RayCastLevelGen_GetThreshold(params->density);
+
+    for (int y = 0; y < size_y; y++)
+    {
+        int block_y = y / period;
+        bool street_row = (y % period) >= params->run_length;
+
+        for (int block_x = 0; block_x < blocks_x; block_x++)
+        {
+            // Every row of a block draws the same numbers, no per-block state is kept //
+            RayCastLevelGenRng block_rng;
+            block_rng.state = params->seed ^ ((uint64_t)((block_y * blocks_x) + block_x) * 0xD6E8FEB86659FD93ULL);
+
+            bool built = !street_row && RayCastLevelGen_Chance(&block_rng, built_threshold);
+            uint8_t height = (uint8_t)(LEVELGEN_HEIGHT_UNIT * (1 + RayCastLevelGen_NextBelow(&block_rng, 4)));
+
+            int x_begin = block_x * period;
+            int x_end = x_begin + period;
+            if (x_end > size_x)
+                x_end = size_x;
+
+            for (int x = x_begin; x < x_end; x++)
+            {
+                size_t cell = ((size_t)y * size_x) + x;
+
+                if (built && (x - x_begin) < params->run_length)
+                {
+                    level->cells[cell] = wall_material;
+                    level->heights[cell] = height;
+                }
+                else
+                    level->cells[cell] = 0;
+            }
+        }
+    }
+}
+
+// Walks square rings out from the middle; a level with no room gets one cleared //
+static void RayCastLevelGen_PlaceStart(RayCastGeneratedLevel *level)
+{
+    const int size_x = level->view.size_x;
+    const int size_y = level->view.size_y;
+
+    const int middle_x = size_x / 2;
+    const int middle_y = size_y / 2;
+
+    const int max_ring = (size_x > size_y) ? size_x : size_y;
+
+    for (int ring = 0; ring < max_ring; ring++)
+    {
+        for (int y = middle_y - ring; y <= middle_y + ring; y++)
+        {
+            if (y < 0 || y >= size_y)
+                continue;
+
+            // Only the ring's edge, the inside was searched already //
+            int x_step = (y == middle_y - ring || y == middle_y + ring) ? 1 : (2 * ring);
+
+            for (int x = middle_x - ring; x <= middle_x + ring; x += x_step)
+            {
+                if (x < 0 || x >= size_x)
+                    continue;
+
+                if (level->cells[((size_t)y * size_x) + x] == 0)
+                {
+                    level->start_x = x;
+                    level->start_y = y;
+                    return;
+                }
+            }
+        }
+    }
+
+    RayCastLevelGen_SetCell(level, middle_x, middle_y, 0);
+
+    level->start_x = middle_x;
+    level->start_y = middle_y;
+}
+
+RayCastGeneratedLevel *RayCastLevelGen_Create(const RayCastLevelGenParams *params)
+{
+    if (params->kind < 0 || params->kind >= RAYCAST_LEVELGEN_KIND_COUNT ||
+        params->size_x < RAYCAST_LEVELGEN_MIN_SIZE || params->size_x > RAYCAST_LEVELGEN_MAX_SIZE ||
+        params->size_y < RAYCAST_LEVELGEN_MIN_SIZE || params->size_y > RAYCAST_LEVELGEN_MAX_SIZE ||
+        params->run_length < 1 || !isfinite(params->density))
+    {
+        SDL_Log("%s Invalid level parameters", program_log_tag);
+        return NULL;
+    }
+
+    uint64_t start_time = SDL_GetTicksNS();
+
+    size_t cell_count = (size_t)params->size_x * params->size_y;
+
+    RayCastGeneratedLevel *level = (RayCastGeneratedLevel *)malloc(sizeof(RayCastGeneratedLevel));
+    if (level == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for level", program_log_tag);
+        return NULL;
+    }
+    memset(level, 0, sizeof(RayCastGeneratedLevel));
+
+    level->cells = (uint8_t *)malloc(cell_count);
+    level->heights = (uint8_t *)malloc(cell_count);
+    if (level->cells == NULL || level->heights == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for %dx%d level", program_log_tag, params->size_x, params->size_y);
+        goto Error;
+    }
+
+    memset(level->heights, LEVELGEN_HEIGHT_UNIT, cell_count);
+
+    level->view.size_x = params->size_x;
+    level->view.size_y = params->size_y;
+    level->view.cells = level->cells;
+    level->view.heights = level->heights;
+    level->view.see_through = NULL;
+    level->view.height_unit = 1.0F / LEVELGEN_HEIGHT_UNIT;
+
+    RayCastLevelGenRng rng;
+    rng.state = params->seed;
+
+    switch (params->kind)
+    {
+    case RAYCAST_LEVELGEN_MAZE:
+        RayCastLevelGen_Maze(level, params, &rng);
+        break;
+    case RAYCAST_LEVELGEN_PILLARS:
+        RayCastLevelGen_Pillars(level, params, &rng);
+        break;
+    case RAYCAST_LEVELGEN_CORRIDORS:
+        RayCastLevelGen_Corridors(level, params, &rng);
+        break;
+    default:
+        RayCastLevelGen_City(level, params);
+        break;
+    }
+
+    RayCastLevelGen_PlaceStart(level);
+
+    level->wall_count = 0;
+    for (size_t i = 0; i < cell_count; i++)
+        level->wall_count += (level->cells[i] != 0);
+
+    SDL_Log("%s Generated %s %dx%d, seed %llu: %.1f%% walls in %.2f ms", program_log_tag,
+        kind_names[params->kind], params->size_x, params->size_y, (unsigned long long)params->seed,
+        100.0 * (double)level->wall_count / (double)cell_count, (SDL_GetTicksNS() - start_time) / 1000000.0);
+
+    return level;
+
+Error:
+    RayCastLevelGen_Destroy(level);
+
+    return NULL;
+}
+
+void RayCastLevelGen_Destroy(RayCastGeneratedLevel *level)
+{
+    if (level == NULL)
+        return;
+
+    free(level->cells);
+    free(level->heights);
+    free(level);
+}
+
+const char *RayCastLevelGen_GetKindName(RayCastLevelGenKind kind)
+{
+    if (kind < 0 || kind >= RAYCAST_LEVELGEN_KIND_COUNT)
+        return "unknown";
+
+    return kind_names[kind];
+}
+
+bool RayCastLevelGen_FindKind(const char *name, RayCastLevelGenKind *kind)
+{
+    for (int i = 0; i < RAYCAST_LEVELGEN_KIND_COUNT; i++)
+    {
+        if (SDL_strcasecmp(name, kind_names[i]) == 0)
+        {
+            *kind = (RayCastLevelGenKind)i;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastLevel.h"
+
+#define RAYCAST_LEVELGEN_MIN_SIZE   8
+#define RAYCAST_LEVELGEN_MAX_SIZE   16384
+
+typedef enum
+{
+    RAYCAST_LEVELGEN_MAZE,          // density: share of passage walls left standing, 1 is a perfect maze; run_length: mean straight run //
+    RAYCAST_LEVELGEN_PILLARS,       // density: share of cells holding a pillar of random height; run_length: unused //
+    RAYCAST_LEVELGEN_CORRIDORS,     // density: share of corridor wall cells standing; run_length: corridor length between cross walls //
+    RAYCAST_LEVELGEN_CITY,          // density: share of blocks built up; run_length: block size, streets are two cells wide //
+    RAYCAST_LEVELGEN_KIND_COUNT
+}
+RayCastLevelGenKind;
+
+typedef struct
+{
+    RayCastLevelGenKind kind;
+    int size_x, size_y;
+
+    uint64_t seed;
+
+    float density;
+    int run_length;
+}
+RayCastLevelGenParams;
+
+// The same parameters give the same cells on every host and build //
+typedef struct
+{
+    RayCastLevelView view;
+
+    uint8_t *cells;
+    uint8_t *heights;
+
+    // Empty, as near the middle as the level allows //
+    int start_x, start_y;
+
+    size_t wall_count;
+}
+RayCastGeneratedLevel;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern RayCastGeneratedLevel *RayCastLevelGen_Create(const RayCastLevelGenParams *params);
+    extern void RayCastLevelGen_Destroy(RayCastGeneratedLevel *level);
+
+    extern const char *RayCastLevelGen_GetKindName(RayCastLevelGenKind kind);
+    extern bool RayCastLevelGen_FindKind(const char *name, RayCastLevelGenKind *kind);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,877 @@
+#include "RayCastLightMap.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+#include <SDL3/SDL.h>
+
+#define LIGHTMAP_TEXELS_PER_FACE    (LIGHTMAP_SIZE * LIGHTMAP_SIZE)
+
+#define LIGHTMAP_BAKE_CHUNK         16
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t level_hash;
+    uint32_t face_count;
+    uint32_t lightmap_size;
+}
+RayCastLightMapFileHeader;
+
+struct RayCastLightMap
+{
+    RayCastLevelView level;
+
+    const RayCastLight *lights;
+    int light_count;
+
+    const RayCastPVS *pvs;
+
+    // cell * RAYCAST_FACE_COUNT + face -> face index, -1 for faces nobody can see //
+    int32_t *face_offsets;
+    int32_t *face_keys; // -1 for a face an edit took back //
+    int face_count;
+    int face_capacity;
+
+    // Per face, column-major so one u is LIGHTMAP_SIZE contiguous texels //
+    uint8_t *texels;
+
+    // Edits Only, Faces Given Back And Reused, And The Faces One Batch Rebakes //
+    int32_t *free_faces;
+    int free_face_count;
+    int free_face_capacity;
+
+    int32_t *rebake_faces;
+    int rebake_face_count;
+    int rebake_face_capacity;
+
+    // One flag per static and per dynamic light, cleared by each batch //
+    bool *light_queued;
+    bool *dynamic_touched;
+
+    SDL_AtomicInt next_face;
+
+    float *dynamic_grid;
+    RayCastLight *dynamic_lights;
+    bool *dynamic_active;
+    int max_dynamic_lights;
+
+    uint32_t revision;
+
+    // The level edge and faces without texels, at the ambient level baked faces start from //
+    uint8_t ambient_column[LIGHTMAP_SIZE];
+};
+
+static const char lightmap_magic[4] = { 'R', 'C', 'L', 'M' };
+static const uint32_t lightmap_version = 1;
+
+static const float lightmap_ambient = 0.3F;
+static const float lightmap_normal_offset = 0.01F;
+
+static const uint8_t unlit_column[LIGHTMAP_SIZE] =
+{
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255
+};
+
+static const char program_log_tag[] = "[RayCastLightMap.c]";
+
+static uint64_t RayCastLightMap_HashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t RayCastLightMap_HashInputs(const RayCastLightMap *light_map)
+{
+    const RayCastLevelView *level = &light_map->level;
+
+    size_t cell_count = (size_t)level->size_x * (size_t)level->size_y;
+
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    hash = RayCastLightMap_HashBytes(hash, &level->size_x, sizeof(level->size_x));
+    hash = RayCastLightMap_HashBytes(hash, &level->size_y, sizeof(level->size_y));
+    hash = RayCastLightMap_HashBytes(hash, level->cells, cell_count);
+    hash = RayCastLightMap_HashBytes(hash, level->heights, cell_count);
+    hash = RayCastLightMap_HashBytes(hash, &level->height_unit, sizeof(level->height_unit));
+
+    hash = RayCastLightMap_HashBytes(hash, &light_map->light_count, sizeof(light_map->light_count));
+    hash = RayCastLightMap_HashBytes(hash, light_map->lights, sizeof(RayCastLight) * light_map->light_count);
+
+    hash = RayCastLightMap_HashBytes(hash, &lightmap_ambient, sizeof(lightmap_ambient));
+
+    return hash;
+}
+
+static bool RayCastLightMap_IsOccluded(const RayCastLevelView *level, float from_x, float from_y, float from_z, const RayCastLight *light)
+{
+    float delta_x = light->x - from_x;
+    float delta_y = light->y - from_y;
+
+    int cell_x = (int)floorf(from_x);
+    int cell_y = (int)floorf(from_y);
+
+    int step_x = (delta_x > 0.0F) ? 1 : -1;
+    int step_y = (delta_y > 0.0F) ? 1 : -1;
+
+    float t_delta_x = (delta_x != 0.0F) ? fabsf(1.0F / delta_x) : INFINITY;
+    float t_delta_y = (delta_y != 0.0F) ? fabsf(1.0F / delta_y) : INFINITY;
+
+    float t_max_x = (delta_x > 0.0F) ? ((cell_x + 1) - from_x) * t_delta_x : (from_x - cell_x) * t_delta_x;
+    float t_max_y = (delta_y > 0.0F) ? ((cell_y + 1) - from_y) * t_delta_y : (from_y - cell_y) * t_delta_y;
+
+    while (true)
+    {
+        float t;
+
+        if (t_max_x < t_max_y)
+        {
+            cell_x += step_x;
+            t = t_max_x;
+            t_max_x += t_delta_x;
+        }
+        else
+        {
+            cell_y += step_y;
+            t = t_max_y;
+            t_max_y += t_delta_y;
+        }
+
+        if (t >= 1.0F)
+            return false;
+
+        if (cell_x < 0 || cell_x >= level->size_x || cell_y < 0 || cell_y >= level->size_y)
+            return true;
+
+        if (RayCastLevel_IsWall(level, cell_x, cell_y))
+        {
+            // The Segment Can Pass Over Short Walls //
+            float segment_z = from_z + ((light->z - from_z) * t);
+
+            if (RayCastLevel_GetHeight(level, cell_x, cell_y) > segment_z)
+                return true;
+        }
+    }
+}
+
+static void RayCastLightMap_BakeFace(RayCastLightMap *light_map, int face_index)
+{
+    const RayCastLevelView *level = &light_map->level;
+
+    int face_key = light_map->face_keys[face_index];
+    int cell = face_key / RAYCAST_FACE_COUNT;
+    int face = face_key % RAYCAST_FACE_COUNT;
+
+    int cell_x = cell % level->size_x;
+    int cell_y = cell / level->size_x;
+
+    float wall_height = RayCastLevel_GetHeight(level, cell_x, cell_y);
+
+    float normal_x = 0.0F, normal_y = 0.0F;
+    float origin_x = (float)cell_x, origin_y = (float)cell_y;
+    float along_x = 0.0F, along_y = 0.0F;
+
+    switch (face)
+    {
+    case RAYCAST_FACE_U:
+        normal_y = -1.0F;
+        along_x = 1.0F;
+        break;
+    case RAYCAST_FACE_D:
+        normal_y = 1.0F;
+        origin_y += 1.0F;
+        along_x = 1.0F;
+        break;
+    case RAYCAST_FACE_L:
+        normal_x = -1.0F;
+        along_y = 1.0F;
+        break;
+    case RAYCAST_FACE_R:
+        normal_x = 1.0F;
+        origin_x += 1.0F;
+        along_y = 1.0F;
+        break;
+    }
+
+    uint8_t *ptr_texel = light_map->texels + ((size_t)face_index * LIGHTMAP_TEXELS_PER_FACE);
+
+    for (int texel_u = 0; texel_u < LIGHTMAP_SIZE; texel_u++)
+    {
+        float u = (texel_u + 0.5F) / LIGHTMAP_SIZE;
+
+        float point_x = origin_x + (along_x * u) + (normal_x * lightmap_normal_offset);
+        float point_y = origin_y + (along_y * u) + (normal_y * lightmap_normal_offset);
+
+        for (int texel_v = 0; texel_v < LIGHTMAP_SIZE; texel_v++)
+        {
+            float v = (texel_v + 0.5F) / LIGHTMAP_SIZE;
+
+            float point_z = wall_height * (1.0F - v);
+
+            float light_sum = lightmap_ambient;
+
+            for (int i = 0; i < light_map->light_count; i++)
+            {
+                const RayCastLight *light = &light_map->lights[i];
+
+                float to_light_x = light->x - point_x;
+                float to_light_y = light->y - point_y;
+                float to_light_z = light->z - point_z;
+
+                float distance = sqrtf((to_light_x * to_light_x) + (to_light_y * to_light_y) + (to_light_z * to_light_z));
+                if (distance >= light->radius || distance <= 0.0F)
+                    continue;
+
+                float n_dot_l = ((normal_x * to_light_x) + (normal_y * to_light_y)) / distance;
+                if (n_dot_l <= 0.0F)
+                    continue;
+
+                if (RayCastLightMap_IsOccluded(level, point_x, point_y, point_z, light))
+                    continue;
+
+                float falloff = 1.0F - (distance / light->radius);
+
+                light_sum += light->intensity * n_dot_l * falloff * falloff;
+            }
+
+            light_sum = fminf(fmaxf(light_sum, 0.0F), 1.0F);
+
+            *ptr_texel++ = (uint8_t)((light_sum * 255.0F) + 0.5F);
+        }
+    }
+}
+
+static int SDLCALL RayCastLightMap_BakeWorker(void *data)
+{
+    RayCastLightMap *light_map = (RayCastLightMap *)data;
+
+    while (true)
+    {
+        int first_face = SDL_AddAtomicInt(&light_map->next_face, LIGHTMAP_BAKE_CHUNK);
+        if (first_face >= light_map->face_count)
+            break;
+
+        int last_face = first_face + LIGHTMAP_BAKE_CHUNK;
+        if (last_face > light_map->face_count)
+            last_face = light_map->face_count;
+
+        for (int face_index = first_face; face_index < last_face; face_index++)
+            RayCastLightMap_BakeFace(light_map, face_index);
+    }
+
+    return 0;
+}
+
+static void RayCastLightMap_Bake(RayCastLightMap *light_map)
+{
+    SDL_SetAtomicInt(&light_map->next_face, 0);
+
+    int worker_count = SDL_GetNumLogicalCPUCores();
+    int max_useful_workers = (light_map->face_count + LIGHTMAP_BAKE_CHUNK - 1) / LIGHTMAP_BAKE_CHUNK;
+    if (worker_count > max_useful_workers)
+        worker_count = max_useful_workers;
+    if (worker_count < 1)
+        worker_count = 1;
+
+    // The calling thread is one of the workers //
+    SDL_Thread **threads = (SDL_Thread **)calloc((size_t)worker_count, sizeof(SDL_Thread *));
+
+    if (threads != NULL)
+    {
+        for (int i = 1; i < worker_count; i++)
+            threads[i] = SDL_CreateThread(RayCastLightMap_BakeWorker, "LightMapBake", (void *)light_map);
+    }
+
+    RayCastLightMap_BakeWorker((void *)light_map);
+
+    if (threads != NULL)
+    {
+        for (int i = 1; i < worker_count; i++)
+        {
+            if (threads[i] != NULL)
+                SDL_WaitThread(threads[i], NULL);
+        }
+
+        free(threads);
+    }
+}
+
+static void RayCastLightMap_GetCachePath(uint64_t level_hash, char *path, size_t path_size)
+{
+    snprintf(path, path_size, "lightmap_%016llx.bin", (unsigned long long)level_hash);
+}
+
+static bool RayCastLightMap_LoadCache(RayCastLightMap *light_map, uint64_t level_hash)
+{
+    char path[64];
+    RayCastLightMap_GetCachePath(level_hash, path, sizeof(path));
+
+    SDL_IOStream *stream = SDL_IOFromFile(path, "rb");
+    if (stream == NULL)
+        return false;
+
+    RayCastLightMapFileHeader header;
+    size_t texel_bytes = (size_t)light_map->face_count * LIGHTMAP_TEXELS_PER_FACE;
+
+    bool valid =
+        SDL_ReadIO(stream, &header, sizeof(header)) == sizeof(header) &&
+        memcmp(header.magic, lightmap_magic, sizeof(lightmap_magic)) == 0 &&
+        header.version == lightmap_version &&
+        header.level_hash == level_hash &&
+        header.face_count == (uint32_t)light_map->face_count &&
+        header.lightmap_size == LIGHTMAP_SIZE &&
+        SDL_ReadIO(stream, light_map->texels, texel_bytes) == texel_bytes;
+
+    SDL_CloseIO(stream);
+
+    return valid;
+}
+
+static void RayCastLightMap_SaveCache(RayCastLightMap *light_map, uint64_t level_hash)
+{
+    char path[64];
+    RayCastLightMap_GetCachePath(level_hash, path, sizeof(path));
+
+    SDL_IOStream *stream = SDL_IOFromFile(path, "wb");
+    if (stream == NULL)
+    {
+        SDL_Log("%s Failed to write lightmap cache \"%s\": %s", program_log_tag, path, SDL_GetError());
+        return;
+    }
+
+    RayCastLightMapFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, lightmap_magic, sizeof(lightmap_magic));
+    header.version = lightmap_version;
+    header.level_hash = level_hash;
+    header.face_count = (uint32_t)light_map->face_count;
+    header.lightmap_size = LIGHTMAP_SIZE;
+
+    size_t texel_bytes = (size_t)light_map->face_count * LIGHTMAP_TEXELS_PER_FACE;
+
+    if (SDL_WriteIO(stream, &header, sizeof(header)) != sizeof(header) ||
+        SDL_WriteIO(stream, light_map->texels, texel_bytes) != texel_bytes)
+        SDL_Log("%s Failed to write lightmap cache \"%s\": %s", program_log_tag, path, SDL_GetError());
+
+    SDL_CloseIO(stream);
+}
+
+RayCastLightMap *RayCastLightMap_Create(const RayCastLevelView *level, const RayCastLight *lights, int light_count, int max_dynamic_lights, const RayCastPVS *pvs)
+{
+    if (level == NULL)
+        return NULL;
+
+    RayCastLightMap *light_map = (RayCastLightMap *)calloc(1, sizeof(RayCastLightMap));
+    if (light_map == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for lightmap", program_log_tag);
+        return NULL;
+    }
+
+    light_map->level = *level;
+    light_map->lights = lights;
+    light_map->light_count = (lights != NULL) ? light_count : 0;
+    light_map->max_dynamic_lights = max_dynamic_lights;
+    light_map->pvs = pvs;
+
+    memset(light_map->ambient_column, (int)((lightmap_ambient * 255.0F) + 0.5F), sizeof(light_map->ambient_column));
+
+    size_t cell_count = (size_t)level->size_x * (size_t)level->size_y;
+
+    light_map->face_offsets = (int32_t *)malloc(sizeof(int32_t) * cell_count * RAYCAST_FACE_COUNT);
+    light_map->dynamic_grid = (float *)calloc(cell_count, sizeof(float));
+    light_map->dynamic_lights = (RayCastLight *)calloc((size_t)max_dynamic_lights + 1, sizeof(RayCastLight));
+    light_map->dynamic_active = (bool *)calloc((size_t)max_dynamic_lights + 1, sizeof(bool));
+    light_map->light_queued = (bool *)calloc((size_t)light_map->light_count + 1, sizeof(bool));
+    light_map->dynamic_touched = (bool *)calloc((size_t)max_dynamic_lights + 1, sizeof(bool));
+    if (light_map->face_offsets == NULL || light_map->dynamic_grid == NULL ||
+        light_map->dynamic_lights == NULL || light_map->dynamic_active == NULL ||
+        light_map->light_queued == NULL || light_map->dynamic_touched == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for lightmap tables", program_log_tag);
+        goto Error;
+    }
+
+    // Only Faces Looking Into Empty Cells Get Texels //
+
+    for (int cell_y = 0; cell_y < level->size_y; cell_y++)
+    {
+        for (int cell_x = 0; cell_x < level->size_x; cell_x++)
+        {
+            int cell = (cell_y * level->size_x) + cell_x;
+
+            for (int face = 0; face < RAYCAST_FACE_COUNT; face++)
+            {
+                int neighbor_x, neighbor_y;
+                RayCastLevel_GetFaceNeighbor(cell_x, cell_y, face, &neighbor_x, &neighbor_y);
+
+                bool exposed = RayCastLevel_IsWall(level, cell_x, cell_y) && !RayCastLevel_IsWall(level, neighbor_x, neighbor_y);
+
+                light_map->face_offsets[(cell * RAYCAST_FACE_COUNT) + face] = exposed ? light_map->face_count++ : -1;
+            }
+        }
+    }
+
+    light_map->face_capacity = light_map->face_count + 1;
+    light_map->face_keys = (int32_t *)malloc(sizeof(int32_t) * (size_t)light_map->face_capacity);
+    light_map->texels = (uint8_t *)malloc((size_t)light_map->face_capacity * LIGHTMAP_TEXELS_PER_FACE);
+    if (light_map->face_keys == NULL || light_map->texels == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for lightmap texels", program_log_tag);
+        goto Error;
+    }
+
+    for (size_t i = 0; i < cell_count * RAYCAST_FACE_COUNT; i++)
+    {
+        if (light_map->face_offsets[i] >= 0)
+            light_map->face_keys[light_map->face_offsets[i]] = (int32_t)i;
+    }
+
+    // Re-Bake Only When The Level Or Its Lights Changed //
+
+    uint64_t level_hash = RayCastLightMap_HashInputs(light_map);
+
+    if (RayCastLightMap_LoadCache(light_map, level_hash))
+        SDL_Log("%s Loaded cached lightmap for level %016llx (%d faces)", program_log_tag, (unsigned long long)level_hash, light_map->face_count);
+    else
+    {
+        uint64_t bake_start = SDL_GetPerformanceCounter();
+
+        RayCastLightMap_Bake(light_map);
+
+        double bake_ms = (double)(SDL_GetPerformanceCounter() - bake_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+        SDL_Log("%s Baked lightmap for level %016llx: %d faces in %.2f ms", program_log_tag, (unsigned long long)level_hash, light_map->face_count, bake_ms);
+
+        RayCastLightMap_SaveCache(light_map, level_hash);
+    }
+
+    return light_map;
+
+Error:
+    RayCastLightMap_Destroy(light_map);
+
+    return NULL;
+}
+
+void RayCastLightMap_Destroy(RayCastLightMap *light_map)
+{
+    if (light_map == NULL)
+        return;
+
+    if (light_map->face_offsets != NULL)
+        free(light_map->face_offsets);
+    if (light_map->face_keys != NULL)
+        free(light_map->face_keys);
+    if (light_map->texels != NULL)
+        free(light_map->texels);
+    if (light_map->dynamic_grid != NULL)
+        free(light_map->dynamic_grid);
+    if (light_map->dynamic_lights != NULL)
+        free(light_map->dynamic_lights);
+    if (light_map->dynamic_active != NULL)
+        free(light_map->dynamic_active);
+    if (light_map->light_queued != NULL)
+        free(light_map->light_queued);
+    if (light_map->dynamic_touched != NULL)
+        free(light_map->dynamic_touched);
+    if (light_map->free_faces != NULL)
+        free(light_map->free_faces);
+    if (light_map->rebake_faces != NULL)
+        free(light_map->rebake_faces);
+
+    free(light_map);
+}
+
+const uint8_t *RayCastLightMap_GetFaceColumn(const RayCastLightMap *light_map, int cell, int face, float u)
+{
+    if (light_map == NULL)
+        return unlit_column;
+
+    if (cell < 0 || face < 0 || face >= RAYCAST_FACE_COUNT)
+        return light_map->ambient_column;
+
+    int face_index = light_map->face_offsets[(cell * RAYCAST_FACE_COUNT) + face];
+    if (face_index < 0)
+        return light_map->ambient_column;
+
+    int texel_u = (int)(u * LIGHTMAP_SIZE);
+    if (texel_u < 0)
+        texel_u = 0;
+    if (texel_u >= LIGHTMAP_SIZE)
+        texel_u = LIGHTMAP_SIZE - 1;
+
+    return light_map->texels + ((size_t)face_index * LIGHTMAP_TEXELS_PER_FACE) + (texel_u * LIGHTMAP_SIZE);
+}
+
+// Re-Accumulates The Grid Cells Inside A Light's Reach, True If Any Changed //
+static bool RayCastLightMap_UpdateDynamicGrid(RayCastLightMap *light_map, const RayCastLight *light)
+{
+    const RayCastLevelView *level = &light_map->level;
+
+    int min_x = (int)floorf(light->x - light->radius);
+    int max_x = (int)floorf(light->x + light->radius);
+    int min_y = (int)floorf(light->y - light->radius);
+    int max_y = (int)floorf(light->y + light->radius);
+
+    if (min_x < 0)
+        min_x = 0;
+    if (min_y < 0)
+        min_y = 0;
+    if (max_x >= level->size_x)
+        max_x = level->size_x - 1;
+    if (max_y >= level->size_y)
+        max_y = level->size_y - 1;
+
+    bool changed = false;
+
+    for (int cell_y = min_y; cell_y <= max_y; cell_y++)
+    {
+        for (int cell_x = min_x; cell_x <= max_x; cell_x++)
+        {
+            float center_x = cell_x + 0.5F;
+            float center_y = cell_y + 0.5F;
+
+            int cell = (cell_y * level->size_x) + cell_x;
+
+            float light_sum = 0.0F;
+
+            for (int i = 0; i < light_map->max_dynamic_lights; i++)
+            {
+                if (!light_map->dynamic_active[i])
+                    continue;
+
+                const RayCastLight *dynamic_light = &light_map->dynamic_lights[i];
+
+                float distance = sqrtf(((dynamic_light->x - center_x) * (dynamic_light->x - center_x)) +
+                                       ((dynamic_light->y - center_y) * (dynamic_light->y - center_y)));
+                if (distance >= dynamic_light->radius)
+                    continue;
+
+                // Lights behind full-height walls stay there //
+                int light_x = (int)floorf(dynamic_light->x);
+                int light_y = (int)floorf(dynamic_light->y);
+
+                if (light_x >= 0 && light_x < level->size_x && light_y >= 0 && light_y < level->size_y &&
+                    !RayCastPVS_IsVisible(light_map->pvs, (light_y * level->size_x) + light_x, cell))
+                    continue;
+
+                float falloff = 1.0F - (distance / dynamic_light->radius);
+
+                light_sum += dynamic_light->intensity * falloff * falloff;
+            }
+
+            changed |= (light_map->dynamic_grid[cell] != light_sum);
+
+            light_map->dynamic_grid[cell] = light_sum;
+        }
+    }
+
+    return changed;
+}
+
+void RayCastLightMap_SetDynamicLight(RayCastLightMap *light_map, int light_id, const RayCastLight *light)
+{
+    if (light_map == NULL || light == NULL || light_id < 0 || light_id >= light_map->max_dynamic_lights)
+        return;
+
+    RayCastLight old_light = light_map->dynamic_lights[light_id];
+    bool was_active = light_map->dynamic_active[light_id];
+
+    if (was_active && memcmp(&old_light, light, sizeof(RayCastLight)) == 0)
+        return;
+
+    light_map->dynamic_lights[light_id] = *light;
+    light_map->dynamic_active[light_id] = true;
+
+    if (was_active)
+        RayCastLightMap_UpdateDynamicGrid(light_map, &old_light);
+    RayCastLightMap_UpdateDynamicGrid(light_map, light);
+
+    light_map->revision++;
+}
+
+void RayCastLightMap_ClearDynamicLight(RayCastLightMap *light_map, int light_id)
+{
+    if (light_map == NULL || light_id < 0 || light_id >= light_map->max_dynamic_lights)
+        return;
+
+    if (!light_map->dynamic_active[light_id])
+        return;
+
+    light_map->dynamic_active[light_id] = false;
+
+    RayCastLightMap_UpdateDynamicGrid(light_map, &light_map->dynamic_lights[light_id]);
+
+    light_map->revision++;
+}
+
+float RayCastLightMap_SampleDynamic(const RayCastLightMap *light_map, int cell, int face)
+{
+    if (light_map == NULL || cell < 0)
+        return 0.0F;
+
+    const RayCastLevelView *level = &light_map->level;
+
+    int neighbor_x, neighbor_y;
+    RayCastLevel_GetFaceNeighbor(cell % level->size_x, cell / level->size_x, face, &neighbor_x, &neighbor_y);
+
+    if (neighbor_x < 0 || neighbor_x >= level->size_x || neighbor_y < 0 || neighbor_y >= level->size_y)
+        return 0.0F;
+
+    return light_map->dynamic_grid[(neighbor_y * level->size_x) + neighbor_x];
+}
+
+uint32_t RayCastLightMap_GetRevision(const RayCastLightMap *light_map)
+{
+    if (light_map == NULL)
+        return 0;
+
+    return light_map->revision;
+}
+
+static bool RayCastLightMap_PushFace(int32_t **faces, int *count, int *capacity, int face_index)
+{
+    if (*count == *capacity)
+    {
+        int new_capacity = (*capacity > 0) ? *capacity * 2 : 256;
+
+        int32_t *new_faces = (int32_t *)realloc(*faces, sizeof(int32_t) * (size_t)new_capacity);
+        if (new_faces == NULL)
+            return false;
+
+        *faces = new_faces;
+        *capacity = new_capacity;
+    }
+
+    (*faces)[(*count)++] = face_index;
+
+    return true;
+}
+
+// A face given back earlier, or a new one past the last; -1 when out of memory //
+static int RayCastLightMap_AllocFace(RayCastLightMap *light_map)
+{
+    if (light_map->free_face_count > 0)
+        return light_map->free_faces[--light_map->free_face_count];
+
+    if (light_map->face_count == light_map->face_capacity)
+    {
+        int face_capacity = light_map->face_capacity * 2;
+
+        int32_t *face_keys = (int32_t *)realloc(light_map->face_keys, sizeof(int32_t) * (size_t)face_capacity);
+        if (face_keys == NULL)
+            return -1;
+        light_map->face_keys = face_keys;
+
+        uint8_t *texels = (uint8_t *)realloc(light_map->texels, (size_t)face_capacity * LIGHTMAP_TEXELS_PER_FACE);
+        if (texels == NULL)
+            return -1;
+        light_map->texels = texels;
+
+        light_map->face_capacity = face_capacity;
+    }
+
+    return light_map->face_count++;
+}
+
+// Gives the face texels if it now looks into an empty cell and takes them back if it //
+// no longer does; returns its face index, -1 for none                               //
+static int RayCastLightMap_UpdateFace(RayCastLightMap *light_map, int cell_x, int cell_y, int face)
+{
+    const RayCastLevelView *level = &light_map->level;
+
+    int neighbor_x, neighbor_y;
+    RayCastLevel_GetFaceNeighbor(cell_x, cell_y, face, &neighbor_x, &neighbor_y);
+
+    bool exposed = RayCastLevel_IsWall(level, cell_x, cell_y) && !RayCastLevel_IsWall(level, neighbor_x, neighbor_y);
+
+    int face_key = (((cell_y * level->size_x) + cell_x) * RAYCAST_FACE_COUNT) + face;
+    int face_index = light_map->face_offsets[face_key];
+
+    if (exposed && face_index < 0)
+    {
+        face_index = RayCastLightMap_AllocFace(light_map);
+        if (face_index < 0)
+            return -1;
+
+        light_map->face_offsets[face_key] = face_index;
+        light_map->face_keys[face_index] = face_key;
+    }
+    else if (!exposed && face_index >= 0)
+    {
+        // Kept for reuse if it cannot be listed, at worst the texels are lost //
+        RayCastLightMap_PushFace(&light_map->free_faces, &light_map->free_face_count, &light_map->free_face_capacity, face_index);
+
+        light_map->face_offsets[face_key] = -1;
+        light_map->face_keys[face_index] = -1;
+        face_index = -1;
+    }
+
+    return face_index;
+}
+
+static void RayCastLightMap_QueueRebake(RayCastLightMap *light_map, int face_index)
+{
+    if (face_index >= 0)
+        RayCastLightMap_PushFace(&light_map->rebake_faces, &light_map->rebake_face_count, &light_map->rebake_face_capacity, face_index);
+}
+
+static int RayCastLightMap_CompareFaces(const void *a, const void *b)
+{
+    int32_t face_a = *(const int32_t *)a;
+    int32_t face_b = *(const int32_t *)b;
+
+    return (face_a > face_b) - (face_a < face_b);
+}
+
+static bool RayCastLightMap_IsCellInReach(const RayCastLight *light, int cell_x, int cell_y)
+{
+    float nearest_x = fminf(fmaxf(light->x, (float)cell_x), (float)(cell_x + 1));
+    float nearest_y = fminf(fmaxf(light->y, (float)cell_y), (float)(cell_y + 1));
+
+    float delta_x = light->x - nearest_x;
+    float delta_y = light->y - nearest_y;
+
+    return ((delta_x * delta_x) + (delta_y * delta_y)) < (light->radius * light->radius);
+}
+
+// Every face a light reaches, any of them may have been in or out of the edit's shadow //
+static void RayCastLightMap_QueueLightFaces(RayCastLightMap *light_map, const RayCastLight *light)
+{
+    const RayCastLevelView *level = &light_map->level;
+
+    int min_x = (int)floorf(light->x - light->radius);
+    int max_x = (int)floorf(light->x + light->radius);
+    int min_y = (int)floorf(light->y - light->radius);
+    int max_y = (int)floorf(light->y + light->radius);
+
+    if (min_x < 0)
+        min_x = 0;
+    if (min_y < 0)
+        min_y = 0;
+    if (max_x >= level->size_x)
+        max_x = level->size_x - 1;
+    if (max_y >= level->size_y)
+        max_y = level->size_y - 1;
+
+    for (int cell_y = min_y; cell_y <= max_y; cell_y++)
+    {
+        for (int cell_x = min_x; cell_x <= max_x; cell_x++)
+        {
+            int cell = (cell_y * level->size_x) + cell_x;
+
+            for (int face = 0; face < RAYCAST_FACE_COUNT; face++)
+                RayCastLightMap_QueueRebake(light_map, light_map->face_offsets[(cell * RAYCAST_FACE_COUNT) + face]);
+        }
+    }
+}
+
+void RayCastLightMap_UpdateCells(RayCastLightMap *light_map, const int *cells, int count)
+{
+    if (light_map == NULL || count <= 0)
+        return;
+
+    const RayCastLevelView *level = &light_map->level;
+
+    light_map->rebake_face_count = 0;
+
+    bool *light_queued = light_map->light_queued;
+    bool *dynamic_touched = light_map->dynamic_touched;
+
+    memset(light_queued, 0, sizeof(bool) * (size_t)light_map->light_count);
+    memset(dynamic_touched, 0, sizeof(bool) * (size_t)light_map->max_dynamic_lights);
+
+    for (int i = 0; i < count; i++)
+    {
+        int cell = cells[i];
+        if (cell < 0 || cell >= level->size_x * level->size_y)
+            continue;
+
+        int cell_x = cell % level->size_x;
+        int cell_y = cell / level->size_x;
+
+        // The cell's own faces, its height may have changed too, and the faces looking at it //
+        for (int face = 0; face < RAYCAST_FACE_COUNT; face++)
+        {
+            RayCastLightMap_QueueRebake(light_map, RayCastLightMap_UpdateFace(light_map, cell_x, cell_y, face));
+
+            int neighbor_x, neighbor_y;
+            RayCastLevel_GetFaceNeighbor(cell_x, cell_y, face, &neighbor_x, &neighbor_y);
+
+            // U and D, L and R are pairs, the other of the pair faces back //
+            if (neighbor_x >= 0 && neighbor_x < level->size_x && neighbor_y >= 0 && neighbor_y < level->size_y)
+                RayCastLightMap_QueueRebake(light_map, RayCastLightMap_UpdateFace(light_map, neighbor_x, neighbor_y, face ^ 1));
+        }
+
+        for (int l = 0; l < light_map->light_count; l++)
+        {
+            if (!light_queued[l] && RayCastLightMap_IsCellInReach(&light_map->lights[l], cell_x, cell_y))
+            {
+                light_queued[l] = true;
+                RayCastLightMap_QueueLightFaces(light_map, &light_map->lights[l]);
+            }
+        }
+
+        for (int l = 0; l < light_map->max_dynamic_lights; l++)
+        {
+            if (light_map->dynamic_active[l] && RayCastLightMap_IsCellInReach(&light_map->dynamic_lights[l], cell_x, cell_y))
+                dynamic_touched[l] = true;
+        }
+    }
+
+    // Each face once, however many edits or lights queued it //
+    qsort(light_map->rebake_faces, (size_t)light_map->rebake_face_count, sizeof(int32_t), RayCastLightMap_CompareFaces);
+
+    for (int i = 0; i < light_map->rebake_face_count; i++)
+    {
+        if (i > 0 && light_map->rebake_faces[i] == light_map->rebake_faces[i - 1])
+            continue;
+
+        // Queued, then taken back by a later edit of the batch //
+        if (light_map->face_keys[light_map->rebake_faces[i]] < 0)
+            continue;
+
+        RayCastLightMap_BakeFace(light_map, light_map->rebake_faces[i]);
+    }
+
+    // After the PVS saw the edits, dynamic lights now reach through or stop at them //
+    for (int l = 0; l < light_map->max_dynamic_lights; l++)
+    {
+        if (dynamic_touched[l])
+            RayCastLightMap_UpdateDynamicGrid(light_map, &light_map->dynamic_lights[l]);
+    }
+
+    light_map->revision++;
+}
+
+void RayCastLightMap_RefreshDynamicLights(RayCastLightMap *light_map)
+{
+    if (light_map == NULL)
+        return;
+
+    bool changed = false;
+
+    for (int l = 0; l < light_map->max_dynamic_lights; l++)
+    {
+        if (light_map->dynamic_active[l])
+            changed |= RayCastLightMap_UpdateDynamicGrid(light_map, &light_map->dynamic_lights[l]);
+    }
+
+    if (changed)
+        light_map->revision++;
+}
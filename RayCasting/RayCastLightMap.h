@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastLevel.h"
+#include "RayCastPVS.h"
+
+#define LIGHTMAP_SIZE   16
+
+typedef struct
+{
+    float x, y, z;
+    float radius;
+    float intensity;
+}
+RayCastLight;
+
+typedef struct RayCastLightMap RayCastLightMap;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // pvs may be NULL, dynamic lights then reach every cell in their radius //
+    extern RayCastLightMap *RayCastLightMap_Create(const RayCastLevelView *level, const RayCastLight *lights, int light_count, int max_dynamic_lights, const RayCastPVS *pvs);
+    extern void RayCastLightMap_Destroy(RayCastLightMap *light_map);
+
+    extern const uint8_t *RayCastLightMap_GetFaceColumn(const RayCastLightMap *light_map, int cell, int face, float u);
+
+    extern void RayCastLightMap_SetDynamicLight(RayCastLightMap *light_map, int light_id, const RayCastLight *light);
+    extern void RayCastLightMap_ClearDynamicLight(RayCastLightMap *light_map, int light_id);
+    extern float RayCastLightMap_SampleDynamic(const RayCastLightMap *light_map, int cell, int face);
+
+    // The level's cells changed in place at these indices; call after the PVS has seen them. //
+    // Faces around them are handed out or taken back, those the static lights reach there    //
+    // are rebaked. A light whose radius does not reach an edit keeps its texels.             //
+    extern void RayCastLightMap_UpdateCells(RayCastLightMap *light_map, const int *cells, int count);
+
+    // Dynamic lights again, for when the PVS they are clipped by was rebaked //
+    extern void RayCastLightMap_RefreshDynamicLights(RayCastLightMap *light_map);
+
+    extern uint32_t RayCastLightMap_GetRevision(const RayCastLightMap *light_map);
+
+#ifdef __cplusplus
+}
+#endif
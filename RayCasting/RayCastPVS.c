@@ -0,0 +1,1138 @@
+#include "RayCastPVS.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <memory.h>
+#include <math.h>
+
+#include <SDL3/SDL.h>
+
+// Cells further than this from the source on either axis are not baked and count as visible //
+#define PVS_RADIUS          32
+#define PVS_WINDOW_SIZE     ((2 * PVS_RADIUS) + 1)
+
+#define PVS_BAKE_CHUNK      64
+
+// A quadrant splits its view at most once per cell and bends it at most twice //
+#define PVS_MAX_VIEWS       (((PVS_RADIUS + 1) * (PVS_RADIUS + 1)) + 1)
+#define PVS_MAX_BUMPS       (2 * (PVS_RADIUS + 1) * (PVS_RADIUS + 1))
+
+// Visible cells of one empty cell as runs along the rows of their bounding rectangle. In   //
+// bytes: min_x and min_y (16 bits each), width, height, a 16-bit offset to every eighth    //
+// row, then for each row a run count and that many start, length pairs counted from min_x. //
+#define PVS_SET_HEADER_SIZE 6
+#define PVS_ROWS_PER_SKIP   8
+#define PVS_MAX_SET_SIZE    (PVS_SET_HEADER_SIZE + (2 * ((PVS_WINDOW_SIZE + PVS_ROWS_PER_SKIP - 1) / PVS_ROWS_PER_SKIP)) + (PVS_WINDOW_SIZE * (PVS_WINDOW_SIZE + 2)))
+
+// Levels wider or taller than this do not fit the set header //
+#define PVS_MAX_SIZE        65535
+
+// The entry of a cell opened up by an edit, stale until its first rebake //
+#define PVS_NO_SET          UINT32_MAX
+
+// Through two lattice points, in quadrant coordinates where the source cell spans [0, 1] on both axes //
+typedef struct
+{
+    int near_x, near_y;
+    int far_x, far_y;
+}
+RayCastPVSLine;
+
+// A corner a view's line was bent around, chained to the ones before it //
+typedef struct
+{
+    int x, y;
+    int parent;
+}
+RayCastPVSBump;
+
+// Lines from the source cell between shallow and steep are still unobstructed //
+typedef struct
+{
+    RayCastPVSLine shallow, steep;
+    int shallow_bump, steep_bump;
+}
+RayCastPVSView;
+
+// Per baking thread, too large for the stack //
+typedef struct
+{
+    uint8_t window[PVS_WINDOW_SIZE * PVS_WINDOW_SIZE];
+
+    RayCastPVSView views[PVS_MAX_VIEWS];
+    int view_count;
+
+    RayCastPVSBump bumps[PVS_MAX_BUMPS];
+    int bump_count;
+
+    uint8_t set[PVS_MAX_SET_SIZE];
+}
+RayCastPVSScratch;
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t level_hash;
+    int32_t size_x, size_y;
+    uint32_t entry_count;
+    uint32_t set_size;
+}
+RayCastPVSFileHeader;
+
+struct RayCastPVS
+{
+    RayCastLevelView level;
+
+    // Only walls at least this tall hide what is behind them. Kept up with edits through the //
+    // wall heights as last seen, 0 for empty cells, and how many walls there are of each.    //
+    float occluder_height;
+    uint8_t *wall_heights;
+    int wall_height_counts[256];
+
+    // cell -> entry, -1 for wall cells //
+    int32_t *cell_entries;
+    int32_t *entry_cells;
+    uint32_t *entry_sets; // Offsets into set_data, entries with equal sets share one //
+    int entry_count;
+
+    uint8_t *set_data;
+    uint32_t set_size;
+    uint32_t set_capacity;
+    uint32_t compacted_size; // Past it sets were appended by rebakes, the ones they replaced are garbage //
+
+    // Sets an edit may have changed, a ring of entries waiting to be rebaked. Until then //
+    // their cells see everything; a changed set is appended, the old one compacted away. //
+    uint8_t *entry_dirty;
+    int32_t *dirty_entries;
+    int dirty_head;
+    int dirty_count;
+    int dirty_capacity;
+    RayCastPVSScratch *rebake_scratch;
+
+    // Bake Only, One Set Per Entry Until Packed //
+    uint8_t **baked_sets;
+    SDL_AtomicInt next_entry;
+};
+
+static const char pvs_magic[4] = { 'R', 'C', 'P', 'V' };
+static const uint32_t pvs_version = 3;
+
+// Bakes take about 55 us and 250 bytes per empty cell on one core with scattered walls, //
+// so the largest level costs some 14 s and 64 MB the first time it is loaded            //
+static const int pvs_max_cells = 512 * 512;
+
+static const int pvs_query_samples = 1 << 16;
+
+static const char program_log_tag[] = "[RayCastPVS.c]";
+
+static uint64_t RayCastPVS_HashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t RayCastPVS_HashInputs(const RayCastPVS *pvs)
+{
+    const RayCastLevelView *level = &pvs->level;
+
+    size_t cell_count = (size_t)level->size_x * (size_t)level->size_y;
+
+    const int radius = PVS_RADIUS;
+
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    hash = RayCastPVS_HashBytes(hash, &level->size_x, sizeof(level->size_x));
+    hash = RayCastPVS_HashBytes(hash, &level->size_y, sizeof(level->size_y));
+    hash = RayCastPVS_HashBytes(hash, level->cells, cell_count);
+    hash = RayCastPVS_HashBytes(hash, level->heights, cell_count);
+    hash = RayCastPVS_HashBytes(hash, &level->height_unit, sizeof(level->height_unit));
+
+    // Only as far as it applies to the cells there are //
+    if (level->see_through != NULL)
+    {
+        for (size_t i = 0; i < cell_count; i++)
+            hash = RayCastPVS_HashBytes(hash, &level->see_through[level->cells[i]], 1);
+    }
+
+    hash = RayCastPVS_HashBytes(hash, &radius, sizeof(radius));
+
+    return hash;
+}
+
+static float RayCastPVS_GetTallestWall(const RayCastPVS *pvs)
+{
+    int height = 255;
+    while (height > 0 && pvs->wall_height_counts[height] == 0)
+        height--;
+
+    return height * pvs->level.height_unit;
+}
+
+static inline bool RayCastPVS_IsOpaque(const RayCastPVS *pvs, int x, int y)
+{
+    if (x < 0 || x >= pvs->level.size_x || y < 0 || y >= pvs->level.size_y)
+        return true;
+
+    return RayCastLevel_BlocksSight(&pvs->level, x, y) && RayCastLevel_GetHeight(&pvs->level, x, y) >= pvs->occluder_height;
+}
+
+// Marks the cell if it is in the level and the window; true if sight continues past it //
+static inline bool RayCastPVS_Mark(const RayCastPVS *pvs, uint8_t *window, int source_x, int source_y, int x, int y)
+{
+    int local_x = x - source_x + PVS_RADIUS;
+    int local_y = y - source_y + PVS_RADIUS;
+
+    if (local_x < 0 || local_x >= PVS_WINDOW_SIZE || local_y < 0 || local_y >= PVS_WINDOW_SIZE)
+        return false;
+
+    if (x < 0 || x >= pvs->level.size_x || y < 0 || y >= pvs->level.size_y)
+        return false;
+
+    window[(local_y * PVS_WINDOW_SIZE) + local_x] = 1;
+
+    return !RayCastPVS_IsOpaque(pvs, x, y);
+}
+
+// Positive when the line passes below the point, negative above it, zero through it //
+static inline int RayCastPVS_RelativeSlope(const RayCastPVSLine *line, int x, int y)
+{
+    return ((line->far_y - line->near_y) * (line->far_x - x)) - ((line->far_y - y) * (line->far_x - line->near_x));
+}
+
+static void RayCastPVS_RemoveView(RayCastPVSScratch *scratch, int view_index)
+{
+    scratch->view_count--;
+
+    memmove(&scratch->views[view_index], &scratch->views[view_index + 1], sizeof(RayCastPVSView) * (size_t)(scratch->view_count - view_index));
+}
+
+// The shallow line now clears the corner at x, y, pivoting on steep bumps it would cut //
+static void RayCastPVS_AddShallowBump(RayCastPVSScratch *scratch, int view_index, int x, int y)
+{
+    RayCastPVSView *view = &scratch->views[view_index];
+
+    view->shallow.far_x = x;
+    view->shallow.far_y = y;
+
+    RayCastPVSBump *bump = &scratch->bumps[scratch->bump_count];
+    bump->x = x;
+    bump->y = y;
+    bump->parent = view->shallow_bump;
+    view->shallow_bump = scratch->bump_count++;
+
+    for (int i = view->steep_bump; i >= 0; i = scratch->bumps[i].parent)
+    {
+        if (RayCastPVS_RelativeSlope(&view->shallow, scratch->bumps[i].x, scratch->bumps[i].y) < 0)
+        {
+            view->shallow.near_x = scratch->bumps[i].x;
+            view->shallow.near_y = scratch->bumps[i].y;
+        }
+    }
+}
+
+static void RayCastPVS_AddSteepBump(RayCastPVSScratch *scratch, int view_index, int x, int y)
+{
+    RayCastPVSView *view = &scratch->views[view_index];
+
+    view->steep.far_x = x;
+    view->steep.far_y = y;
+
+    RayCastPVSBump *bump = &scratch->bumps[scratch->bump_count];
+    bump->x = x;
+    bump->y = y;
+    bump->parent = view->steep_bump;
+    view->steep_bump = scratch->bump_count++;
+
+    for (int i = view->shallow_bump; i >= 0; i = scratch->bumps[i].parent)
+    {
+        if (RayCastPVS_RelativeSlope(&view->steep, scratch->bumps[i].x, scratch->bumps[i].y) > 0)
+        {
+            view->steep.near_x = scratch->bumps[i].x;
+            view->steep.near_y = scratch->bumps[i].y;
+        }
+    }
+}
+
+// Cell x, y of the quadrant spans [x, x + 1] by [y, y + 1] //
+static void RayCastPVS_VisitCell(const RayCastPVS *pvs, RayCastPVSScratch *scratch, int source_x, int source_y, int dir_x, int dir_y, int x, int y)
+{
+    const int top_left_x = x, top_left_y = y + 1;
+    const int bottom_right_x = x + 1, bottom_right_y = y;
+
+    // Views are ordered shallow to steep, skip those the cell is wholly above. A view //
+    // that only touches a corner of the cell still sees it, the grid walk may too.    //
+    int view_index = 0;
+    while (view_index < scratch->view_count && RayCastPVS_RelativeSlope(&scratch->views[view_index].steep, bottom_right_x, bottom_right_y) > 0)
+        view_index++;
+
+    if (view_index == scratch->view_count || RayCastPVS_RelativeSlope(&scratch->views[view_index].shallow, top_left_x, top_left_y) < 0)
+        return;
+
+    if (RayCastPVS_Mark(pvs, scratch->window, source_x, source_y, source_x + (x * dir_x), source_y + (y * dir_y)))
+        return;
+
+    const RayCastPVSView *view = &scratch->views[view_index];
+
+    bool cuts_shallow = RayCastPVS_RelativeSlope(&view->shallow, bottom_right_x, bottom_right_y) < 0;
+    bool cuts_steep = RayCastPVS_RelativeSlope(&view->steep, top_left_x, top_left_y) > 0;
+
+    if (cuts_shallow && cuts_steep)
+        RayCastPVS_RemoveView(scratch, view_index);
+    else if (cuts_shallow)
+        RayCastPVS_AddShallowBump(scratch, view_index, top_left_x, top_left_y);
+    else if (cuts_steep)
+        RayCastPVS_AddSteepBump(scratch, view_index, bottom_right_x, bottom_right_y);
+    else
+    {
+        // Strictly inside, split into the views below and above the cell //
+        memmove(&scratch->views[view_index + 1], &scratch->views[view_index], sizeof(RayCastPVSView) * (size_t)(scratch->view_count - view_index));
+        scratch->view_count++;
+
+        RayCastPVS_AddSteepBump(scratch, view_index, bottom_right_x, bottom_right_y);
+        RayCastPVS_AddShallowBump(scratch, view_index + 1, top_left_x, top_left_y);
+    }
+}
+
+// Diagonal by diagonal outwards, every open view narrowed by the opaque cells it meets //
+static void RayCastPVS_CheckQuadrant(const RayCastPVS *pvs, RayCastPVSScratch *scratch, int source_x, int source_y, int dir_x, int dir_y)
+{
+    const int extent = PVS_RADIUS;
+
+    RayCastPVSView *view = &scratch->views[0];
+    view->shallow.near_x = 0;
+    view->shallow.near_y = 1;
+    view->shallow.far_x = extent;
+    view->shallow.far_y = 0;
+    view->steep.near_x = 1;
+    view->steep.near_y = 0;
+    view->steep.far_x = 0;
+    view->steep.far_y = extent;
+    view->shallow_bump = -1;
+    view->steep_bump = -1;
+
+    scratch->view_count = 1;
+    scratch->bump_count = 0;
+
+    for (int i = 1; i <= 2 * extent && scratch->view_count > 0; i++)
+    {
+        int first_j = (i > extent) ? i - extent : 0;
+        int last_j = (i < extent) ? i : extent;
+
+        for (int j = first_j; j <= last_j && scratch->view_count > 0; j++)
+            RayCastPVS_VisitCell(pvs, scratch, source_x, source_y, dir_x, dir_y, i - j, j);
+    }
+}
+
+static inline int RayCastPVS_ReadU16(const uint8_t *bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static inline void RayCastPVS_WriteU16(uint8_t *bytes, int value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+// Fills scratch->set, returns its size in bytes //
+static int RayCastPVS_BakeSet(const RayCastPVS *pvs, int cell, RayCastPVSScratch *scratch)
+{
+    int source_x = cell % pvs->level.size_x;
+    int source_y = cell / pvs->level.size_x;
+
+    uint8_t *window = scratch->window;
+
+    memset(window, 0, PVS_WINDOW_SIZE * PVS_WINDOW_SIZE);
+    window[(PVS_RADIUS * PVS_WINDOW_SIZE) + PVS_RADIUS] = 1;
+
+    RayCastPVS_CheckQuadrant(pvs, scratch, source_x, source_y, 1, 1);
+    RayCastPVS_CheckQuadrant(pvs, scratch, source_x, source_y, 1, -1);
+    RayCastPVS_CheckQuadrant(pvs, scratch, source_x, source_y, -1, -1);
+    RayCastPVS_CheckQuadrant(pvs, scratch, source_x, source_y, -1, 1);
+
+    int min_x = PVS_WINDOW_SIZE, min_y = PVS_WINDOW_SIZE, max_x = -1, max_y = -1;
+
+    for (int local_y = 0; local_y < PVS_WINDOW_SIZE; local_y++)
+    {
+        for (int local_x = 0; local_x < PVS_WINDOW_SIZE; local_x++)
+        {
+            if (window[(local_y * PVS_WINDOW_SIZE) + local_x] == 0)
+                continue;
+
+            if (local_x < min_x)
+                min_x = local_x;
+            if (local_x > max_x)
+                max_x = local_x;
+            if (local_y < min_y)
+                min_y = local_y;
+            if (local_y > max_y)
+                max_y = local_y;
+        }
+    }
+
+    int width = max_x - min_x + 1;
+    int height = max_y - min_y + 1;
+
+    uint8_t *set = scratch->set;
+
+    RayCastPVS_WriteU16(set, source_x + min_x - PVS_RADIUS);
+    RayCastPVS_WriteU16(set + 2, source_y + min_y - PVS_RADIUS);
+    set[4] = (uint8_t)width;
+    set[5] = (uint8_t)height;
+
+    int size = PVS_SET_HEADER_SIZE + (2 * ((height + PVS_ROWS_PER_SKIP - 1) / PVS_ROWS_PER_SKIP));
+
+    for (int row = 0; row < height; row++)
+    {
+        if ((row % PVS_ROWS_PER_SKIP) == 0)
+            RayCastPVS_WriteU16(set + PVS_SET_HEADER_SIZE + (2 * (row / PVS_ROWS_PER_SKIP)), size);
+
+        const uint8_t *ptr_marks = window + ((min_y + row) * PVS_WINDOW_SIZE) + min_x;
+
+        uint8_t *ptr_run_count = &set[size++];
+        *ptr_run_count = 0;
+
+        for (int x = 0; x < width; )
+        {
+            if (ptr_marks[x] == 0)
+            {
+                x++;
+                continue;
+            }
+
+            int start = x;
+            while (x < width && ptr_marks[x] != 0)
+                x++;
+
+            set[size++] = (uint8_t)start;
+            set[size++] = (uint8_t)(x - start);
+            (*ptr_run_count)++;
+        }
+    }
+
+    return size;
+}
+
+// Walks the rows, so a damaged set is caught before it is read; 0 if it is not one //
+static uint32_t RayCastPVS_GetSetSize(const uint8_t *set, uint32_t available)
+{
+    if (available < PVS_SET_HEADER_SIZE)
+        return 0;
+
+    int width = set[4];
+    int height = set[5];
+    if (width < 1 || width > PVS_WINDOW_SIZE || height < 1 || height > PVS_WINDOW_SIZE)
+        return 0;
+
+    uint32_t size = PVS_SET_HEADER_SIZE + (2 * (uint32_t)((height + PVS_ROWS_PER_SKIP - 1) / PVS_ROWS_PER_SKIP));
+
+    for (int row = 0; row < height; row++)
+    {
+        if (size >= available)
+            return 0;
+
+        if ((row % PVS_ROWS_PER_SKIP) == 0 &&
+            (uint32_t)RayCastPVS_ReadU16(set + PVS_SET_HEADER_SIZE + (2 * (row / PVS_ROWS_PER_SKIP))) != size)
+            return 0;
+
+        int run_count = set[size++];
+        if (size + (2 * (uint32_t)run_count) > available)
+            return 0;
+
+        int run_end = 0;
+        for (int i = 0; i < run_count; i++, size += 2)
+        {
+            if (set[size] < run_end || set[size + 1] == 0 || set[size] + set[size + 1] > width)
+                return 0;
+
+            run_end = set[size] + set[size + 1];
+        }
+    }
+
+    return size;
+}
+
+static inline bool RayCastPVS_TestSet(const uint8_t *set, int to_x, int to_y)
+{
+    int local_x = to_x - RayCastPVS_ReadU16(set);
+    int local_y = to_y - RayCastPVS_ReadU16(set + 2);
+
+    if (local_x < 0 || local_x >= set[4] || local_y < 0 || local_y >= set[5])
+        return false;
+
+    const uint8_t *ptr_row = set + RayCastPVS_ReadU16(set + PVS_SET_HEADER_SIZE + (2 * (local_y / PVS_ROWS_PER_SKIP)));
+
+    for (int row = local_y % PVS_ROWS_PER_SKIP; row > 0; row--)
+        ptr_row += 1 + (2 * ptr_row[0]);
+
+    const uint8_t *ptr_run = ptr_row + 1;
+
+    // Runs are in order, the first that does not end before the cell decides //
+    for (int i = 0; i < ptr_row[0]; i++, ptr_run += 2)
+    {
+        if (local_x < ptr_run[0])
+            return false;
+        if (local_x < ptr_run[0] + ptr_run[1])
+            return true;
+    }
+
+    return false;
+}
+
+static int SDLCALL RayCastPVS_BakeWorker(void *data)
+{
+    RayCastPVS *pvs = (RayCastPVS *)data;
+
+    // Without it this thread takes no entries, the others bake them //
+    RayCastPVSScratch *scratch = (RayCastPVSScratch *)malloc(sizeof(RayCastPVSScratch));
+    if (scratch == NULL)
+        return 0;
+
+    while (true)
+    {
+        int first_entry = SDL_AddAtomicInt(&pvs->next_entry, PVS_BAKE_CHUNK);
+        if (first_entry >= pvs->entry_count)
+            break;
+
+        int last_entry = first_entry + PVS_BAKE_CHUNK;
+        if (last_entry > pvs->entry_count)
+            last_entry = pvs->entry_count;
+
+        for (int entry_index = first_entry; entry_index < last_entry; entry_index++)
+        {
+            int size = RayCastPVS_BakeSet(pvs, pvs->entry_cells[entry_index], scratch);
+
+            uint8_t *set = (uint8_t *)malloc((size_t)size);
+            if (set != NULL)
+                memcpy(set, scratch->set, (size_t)size);
+
+            pvs->baked_sets[entry_index] = set;
+        }
+    }
+
+    free(scratch);
+
+    return 0;
+}
+
+// Identical sets are kept once, the cells of an open room often share theirs //
+static bool RayCastPVS_Pack(RayCastPVS *pvs)
+{
+    uint64_t total_size = 0;
+
+    for (int i = 0; i < pvs->entry_count; i++)
+    {
+        if (pvs->baked_sets[i] == NULL)
+            return false;
+
+        total_size += RayCastPVS_GetSetSize(pvs->baked_sets[i], PVS_MAX_SET_SIZE);
+    }
+
+    if (total_size >= UINT32_MAX)
+        return false;
+
+    uint32_t slot_count = 64;
+    while (slot_count < 2 * (uint32_t)pvs->entry_count)
+        slot_count *= 2;
+
+    uint32_t *slots = (uint32_t *)malloc(sizeof(uint32_t) * slot_count);
+    pvs->set_data = (uint8_t *)malloc((size_t)total_size);
+    if (slots == NULL || pvs->set_data == NULL)
+    {
+        free(slots);
+        return false;
+    }
+
+    pvs->set_capacity = (uint32_t)total_size;
+    pvs->set_size = 0;
+
+    for (uint32_t i = 0; i < slot_count; i++)
+        slots[i] = PVS_NO_SET;
+
+    for (int i = 0; i < pvs->entry_count; i++)
+    {
+        const uint8_t *set = pvs->baked_sets[i];
+        uint32_t size = RayCastPVS_GetSetSize(set, PVS_MAX_SET_SIZE);
+
+        uint32_t slot = (uint32_t)RayCastPVS_HashBytes(0xCBF29CE484222325ULL, set, size) & (slot_count - 1);
+
+        while (slots[slot] != PVS_NO_SET)
+        {
+            const uint8_t *stored = pvs->set_data + slots[slot];
+
+            if (RayCastPVS_GetSetSize(stored, pvs->set_size - slots[slot]) == size && memcmp(stored, set, size) == 0)
+                break;
+
+            slot = (slot + 1) & (slot_count - 1);
+        }
+
+        if (slots[slot] == PVS_NO_SET)
+        {
+            slots[slot] = pvs->set_size;
+
+            memcpy(pvs->set_data + pvs->set_size, set, size);
+            pvs->set_size += size;
+        }
+
+        pvs->entry_sets[i] = slots[slot];
+    }
+
+    free(slots);
+
+    pvs->compacted_size = pvs->set_size;
+
+    return true;
+}
+
+static bool RayCastPVS_Bake(RayCastPVS *pvs)
+{
+    pvs->baked_sets = (uint8_t **)calloc((size_t)pvs->entry_count + 1, sizeof(uint8_t *));
+    if (pvs->baked_sets == NULL)
+        return false;
+
+    SDL_SetAtomicInt(&pvs->next_entry, 0);
+
+    int worker_count = SDL_GetNumLogicalCPUCores();
+    int max_useful_workers = (pvs->entry_count + PVS_BAKE_CHUNK - 1) / PVS_BAKE_CHUNK;
+    if (worker_count > max_useful_workers)
+        worker_count = max_useful_workers;
+    if (worker_count < 1)
+        worker_count = 1;
+
+    // The calling thread is one of the workers //
+    SDL_Thread **threads = (SDL_Thread **)calloc((size_t)worker_count, sizeof(SDL_Thread *));
+
+    if (threads != NULL)
+    {
+        for (int i = 1; i < worker_count; i++)
+            threads[i] = SDL_CreateThread(RayCastPVS_BakeWorker, "PVSBake", (void *)pvs);
+    }
+
+    RayCastPVS_BakeWorker((void *)pvs);
+
+    if (threads != NULL)
+    {
+        for (int i = 1; i < worker_count; i++)
+        {
+            if (threads[i] != NULL)
+                SDL_WaitThread(threads[i], NULL);
+        }
+
+        free(threads);
+    }
+
+    bool packed = RayCastPVS_Pack(pvs);
+
+    for (int i = 0; i < pvs->entry_count; i++)
+        free(pvs->baked_sets[i]);
+    free(pvs->baked_sets);
+    pvs->baked_sets = NULL;
+
+    return packed;
+}
+
+static void RayCastPVS_GetCachePath(uint64_t level_hash, char *path, size_t path_size)
+{
+    snprintf(path, path_size, "pvs_%016llx.bin", (unsigned long long)level_hash);
+}
+
+static bool RayCastPVS_LoadCache(RayCastPVS *pvs, uint64_t level_hash)
+{
+    char path[64];
+    RayCastPVS_GetCachePath(level_hash, path, sizeof(path));
+
+    SDL_IOStream *stream = SDL_IOFromFile(path, "rb");
+    if (stream == NULL)
+        return false;
+
+    RayCastPVSFileHeader header;
+
+    bool valid =
+        SDL_ReadIO(stream, &header, sizeof(header)) == sizeof(header) &&
+        memcmp(header.magic, pvs_magic, sizeof(pvs_magic)) == 0 &&
+        header.version == pvs_version &&
+        header.level_hash == level_hash &&
+        header.size_x == pvs->level.size_x &&
+        header.size_y == pvs->level.size_y &&
+        header.entry_count == (uint32_t)pvs->entry_count &&
+        header.set_size < UINT32_MAX;
+
+    if (valid)
+    {
+        size_t entry_bytes = sizeof(uint32_t) * (size_t)pvs->entry_count;
+
+        pvs->set_data = (uint8_t *)malloc((size_t)header.set_size + 1);
+        pvs->set_size = header.set_size;
+        pvs->set_capacity = header.set_size + 1;
+
+        valid =
+            pvs->set_data != NULL &&
+            SDL_ReadIO(stream, pvs->entry_sets, entry_bytes) == entry_bytes &&
+            SDL_ReadIO(stream, pvs->set_data, header.set_size) == header.set_size;
+    }
+
+    SDL_CloseIO(stream);
+
+    pvs->compacted_size = pvs->set_size;
+
+    // A damaged file must not read past the sets //
+    for (int i = 0; valid && i < pvs->entry_count; i++)
+    {
+        uint32_t offset = pvs->entry_sets[i];
+
+        valid = offset < pvs->set_size && RayCastPVS_GetSetSize(pvs->set_data + offset, pvs->set_size - offset) != 0;
+    }
+
+    if (!valid && pvs->set_data != NULL)
+    {
+        free(pvs->set_data);
+        pvs->set_data = NULL;
+        pvs->set_size = 0;
+        pvs->set_capacity = 0;
+    }
+
+    return valid;
+}
+
+static void RayCastPVS_SaveCache(RayCastPVS *pvs, uint64_t level_hash)
+{
+    char path[64];
+    RayCastPVS_GetCachePath(level_hash, path, sizeof(path));
+
+    SDL_IOStream *stream = SDL_IOFromFile(path, "wb");
+    if (stream == NULL)
+    {
+        SDL_Log("%s Failed to write PVS cache \"%s\": %s", program_log_tag, path, SDL_GetError());
+        return;
+    }
+
+    RayCastPVSFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, pvs_magic, sizeof(pvs_magic));
+    header.version = pvs_version;
+    header.level_hash = level_hash;
+    header.size_x = pvs->level.size_x;
+    header.size_y = pvs->level.size_y;
+    header.entry_count = (uint32_t)pvs->entry_count;
+    header.set_size = pvs->set_size;
+
+    size_t entry_bytes = sizeof(uint32_t) * (size_t)pvs->entry_count;
+
+    if (SDL_WriteIO(stream, &header, sizeof(header)) != sizeof(header) ||
+        SDL_WriteIO(stream, pvs->entry_sets, entry_bytes) != entry_bytes ||
+        SDL_WriteIO(stream, pvs->set_data, pvs->set_size) != pvs->set_size)
+        SDL_Log("%s Failed to write PVS cache \"%s\": %s", program_log_tag, path, SDL_GetError());
+
+    SDL_CloseIO(stream);
+}
+
+static void RayCastPVS_LogQueryCost(const RayCastPVS *pvs)
+{
+    int cell_count = pvs->level.size_x * pvs->level.size_y;
+
+    uint32_t random_state = 0x9E3779B9U;
+    int visible_count = 0;
+
+    uint64_t query_start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < pvs_query_samples; i++)
+    {
+        random_state = (random_state * 1664525U) + 1013904223U;
+        int from_cell = pvs->entry_cells[(random_state >> 8) % (uint32_t)pvs->entry_count];
+
+        random_state = (random_state * 1664525U) + 1013904223U;
+        int to_cell = (int)((random_state >> 8) % (uint32_t)cell_count);
+
+        visible_count += RayCastPVS_IsVisible(pvs, from_cell, to_cell);
+    }
+
+    double query_ns = (double)(SDL_GetPerformanceCounter() - query_start) * 1000000000.0 / (double)SDL_GetPerformanceFrequency() / pvs_query_samples;
+
+    // As if every empty cell had a bit for every cell //
+    double full_bytes = (double)pvs->entry_count * (double)cell_count / 8.0;
+
+    // The sets themselves, then everything with the per-cell tables //
+    size_t set_bytes = pvs->set_size + (sizeof(uint32_t) * (size_t)pvs->entry_count);
+
+    SDL_Log("%s %zu bytes of sets for %d cells (%.2f%% of an uncompressed bit matrix), %zu bytes in all, %.1f ns per query, %.1f%% of random pairs visible",
+        program_log_tag, set_bytes, pvs->entry_count, 100.0 * (double)set_bytes / full_bytes,
+        RayCastPVS_GetMemoryBytes(pvs), query_ns, 100.0 * visible_count / pvs_query_samples);
+}
+
+RayCastPVS *RayCastPVS_Create(const RayCastLevelView *level)
+{
+    if (level == NULL)
+        return NULL;
+
+    int cell_count = level->size_x * level->size_y;
+    if (cell_count > pvs_max_cells || level->size_x > PVS_MAX_SIZE || level->size_y > PVS_MAX_SIZE)
+    {
+        SDL_Log("%s Level has %d cells, above %d no PVS is built", program_log_tag, cell_count, pvs_max_cells);
+        return NULL;
+    }
+
+    RayCastPVS *pvs = (RayCastPVS *)calloc(1, sizeof(RayCastPVS));
+    if (pvs == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for PVS", program_log_tag);
+        return NULL;
+    }
+
+    pvs->level = *level;
+
+    pvs->wall_heights = (uint8_t *)malloc((size_t)cell_count);
+    pvs->cell_entries = (int32_t *)malloc(sizeof(int32_t) * (size_t)cell_count);
+    pvs->entry_cells = (int32_t *)malloc(sizeof(int32_t) * ((size_t)cell_count + 1));
+    pvs->entry_sets = (uint32_t *)malloc(sizeof(uint32_t) * ((size_t)cell_count + 1));
+
+    // Room for every cell, edits may empty any of them //
+    pvs->entry_dirty = (uint8_t *)calloc((size_t)cell_count + 1, sizeof(uint8_t));
+    pvs->dirty_entries = (int32_t *)malloc(sizeof(int32_t) * ((size_t)cell_count + 1));
+    pvs->dirty_capacity = cell_count + 1;
+
+    if (pvs->wall_heights == NULL || pvs->cell_entries == NULL || pvs->entry_cells == NULL || pvs->entry_sets == NULL ||
+        pvs->entry_dirty == NULL || pvs->dirty_entries == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for PVS tables", program_log_tag);
+        goto Error;
+    }
+
+    for (int cell = 0; cell < cell_count; cell++)
+    {
+        pvs->wall_heights[cell] = (level->cells[cell] != 0) ? level->heights[cell] : 0;
+        pvs->wall_height_counts[pvs->wall_heights[cell]]++;
+    }
+
+    pvs->occluder_height = RayCastPVS_GetTallestWall(pvs);
+
+    for (int cell = 0; cell < cell_count; cell++)
+    {
+        if (level->cells[cell] == 0)
+        {
+            pvs->entry_cells[pvs->entry_count] = cell;
+            pvs->cell_entries[cell] = pvs->entry_count++;
+        }
+        else
+            pvs->cell_entries[cell] = -1;
+    }
+
+    if (pvs->entry_count == 0)
+        goto Error;
+
+    // Re-Bake Only When The Level Changed //
+
+    uint64_t level_hash = RayCastPVS_HashInputs(pvs);
+
+    if (RayCastPVS_LoadCache(pvs, level_hash))
+        SDL_Log("%s Loaded cached PVS for level %016llx (%d cells)", program_log_tag, (unsigned long long)level_hash, pvs->entry_count);
+    else
+    {
+        uint64_t bake_start = SDL_GetPerformanceCounter();
+
+        if (!RayCastPVS_Bake(pvs))
+        {
+            SDL_Log("%s Failed to allocate memory for PVS sets", program_log_tag);
+            goto Error;
+        }
+
+        double bake_ms = (double)(SDL_GetPerformanceCounter() - bake_start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+        SDL_Log("%s Baked PVS for level %016llx: %d cells in %.2f ms", program_log_tag, (unsigned long long)level_hash, pvs->entry_count, bake_ms);
+
+        RayCastPVS_SaveCache(pvs, level_hash);
+    }
+
+    RayCastPVS_LogQueryCost(pvs);
+
+    return pvs;
+
+Error:
+    RayCastPVS_Destroy(pvs);
+
+    return NULL;
+}
+
+void RayCastPVS_Destroy(RayCastPVS *pvs)
+{
+    if (pvs == NULL)
+        return;
+
+    if (pvs->wall_heights != NULL)
+        free(pvs->wall_heights);
+    if (pvs->cell_entries != NULL)
+        free(pvs->cell_entries);
+    if (pvs->entry_cells != NULL)
+        free(pvs->entry_cells);
+    if (pvs->entry_sets != NULL)
+        free(pvs->entry_sets);
+    if (pvs->set_data != NULL)
+        free(pvs->set_data);
+    if (pvs->entry_dirty != NULL)
+        free(pvs->entry_dirty);
+    if (pvs->dirty_entries != NULL)
+        free(pvs->dirty_entries);
+    if (pvs->rebake_scratch != NULL)
+        free(pvs->rebake_scratch);
+
+    free(pvs);
+}
+
+bool RayCastPVS_IsVisible(const RayCastPVS *pvs, int from_cell, int to_cell)
+{
+    if (pvs == NULL)
+        return true;
+
+    const int size_x = pvs->level.size_x;
+
+    if (from_cell < 0 || to_cell < 0 || from_cell >= size_x * pvs->level.size_y || to_cell >= size_x * pvs->level.size_y)
+        return true;
+
+    // Only empty cells have sets, a wall keeps the one from when it was open //
+    int entry_index = pvs->cell_entries[from_cell];
+    if (entry_index < 0 || pvs->entry_dirty[entry_index] || pvs->level.cells[from_cell] != 0)
+        return true;
+
+    int from_x = from_cell % size_x;
+    int from_y = from_cell / size_x;
+
+    int to_x = to_cell % size_x;
+    int to_y = to_cell / size_x;
+
+    // Past the bake radius nothing was ruled out //
+    if (abs(to_x - from_x) > PVS_RADIUS || abs(to_y - from_y) > PVS_RADIUS)
+        return true;
+
+    return RayCastPVS_TestSet(pvs->set_data + pvs->entry_sets[entry_index], to_x, to_y);
+}
+
+size_t RayCastPVS_GetMemoryBytes(const RayCastPVS *pvs)
+{
+    if (pvs == NULL)
+        return 0;
+
+    size_t cell_count = (size_t)pvs->level.size_x * (size_t)pvs->level.size_y;
+
+    return
+        ((sizeof(uint8_t) + sizeof(int32_t)) * cell_count) +
+        ((sizeof(int32_t) + sizeof(uint32_t)) * (size_t)pvs->entry_count) +
+        pvs->set_capacity +
+        ((sizeof(uint8_t) + sizeof(int32_t)) * (size_t)pvs->dirty_capacity);
+}
+
+static void RayCastPVS_MarkDirty(RayCastPVS *pvs, int entry_index)
+{
+    if (pvs->entry_dirty[entry_index])
+        return;
+
+    pvs->entry_dirty[entry_index] = 1;
+    pvs->dirty_entries[(pvs->dirty_head + pvs->dirty_count) % pvs->dirty_capacity] = entry_index;
+    pvs->dirty_count++;
+}
+
+// The bake only tests the cells it adds, so a set without an edited cell cannot change //
+// unless the tallest wall did; otherwise only the window around each edit is looked at. //
+void RayCastPVS_UpdateCells(RayCastPVS *pvs, const int *cells, int count)
+{
+    if (pvs == NULL)
+        return;
+
+    const int size_x = pvs->level.size_x;
+    const int size_y = pvs->level.size_y;
+
+    for (int i = 0; i < count; i++)
+    {
+        int cell = cells[i];
+        if (cell < 0 || cell >= size_x * size_y)
+            continue;
+
+        int edit_x = cell % size_x;
+        int edit_y = cell / size_x;
+
+        pvs->wall_height_counts[pvs->wall_heights[cell]]--;
+        pvs->wall_heights[cell] = (pvs->level.cells[cell] != 0) ? pvs->level.heights[cell] : 0;
+        pvs->wall_height_counts[pvs->wall_heights[cell]]++;
+
+        if (pvs->level.cells[cell] == 0 && pvs->cell_entries[cell] < 0)
+        {
+            pvs->entry_cells[pvs->entry_count] = cell;
+            pvs->entry_sets[pvs->entry_count] = PVS_NO_SET;
+            pvs->cell_entries[cell] = pvs->entry_count++;
+        }
+
+        if (pvs->cell_entries[cell] >= 0)
+            RayCastPVS_MarkDirty(pvs, pvs->cell_entries[cell]);
+
+        int min_x = (edit_x > PVS_RADIUS) ? edit_x - PVS_RADIUS : 0;
+        int min_y = (edit_y > PVS_RADIUS) ? edit_y - PVS_RADIUS : 0;
+        int max_x = (edit_x + PVS_RADIUS < size_x) ? edit_x + PVS_RADIUS : size_x - 1;
+        int max_y = (edit_y + PVS_RADIUS < size_y) ? edit_y + PVS_RADIUS : size_y - 1;
+
+        for (int y = min_y; y <= max_y; y++)
+        {
+            for (int x = min_x; x <= max_x; x++)
+            {
+                int entry_index = pvs->cell_entries[(y * size_x) + x];
+
+                // A cell that closed again before its first rebake has no set //
+                if (entry_index >= 0 && !pvs->entry_dirty[entry_index] && pvs->entry_sets[entry_index] != PVS_NO_SET &&
+                    RayCastPVS_TestSet(pvs->set_data + pvs->entry_sets[entry_index], edit_x, edit_y))
+                    RayCastPVS_MarkDirty(pvs, entry_index);
+            }
+        }
+    }
+
+    // Which walls occlude changed, so may any set: all of them see everything until rebaked //
+    float occluder_height = RayCastPVS_GetTallestWall(pvs);
+    if (occluder_height != pvs->occluder_height)
+    {
+        pvs->occluder_height = occluder_height;
+
+        for (int entry_index = 0; entry_index < pvs->entry_count; entry_index++)
+            RayCastPVS_MarkDirty(pvs, entry_index);
+    }
+}
+
+// A set may be shared, so a changed one is appended rather than written over //
+static bool RayCastPVS_RebakeEntry(RayCastPVS *pvs, int entry_index, RayCastPVSScratch *scratch)
+{
+    uint32_t size = (uint32_t)RayCastPVS_BakeSet(pvs, pvs->entry_cells[entry_index], scratch);
+
+    uint32_t old_offset = pvs->entry_sets[entry_index];
+
+    if (old_offset != PVS_NO_SET &&
+        RayCastPVS_GetSetSize(pvs->set_data + old_offset, pvs->set_size - old_offset) == size &&
+        memcmp(pvs->set_data + old_offset, scratch->set, size) == 0)
+        return true;
+
+    if (pvs->set_size + size > pvs->set_capacity)
+    {
+        uint64_t set_capacity = ((uint64_t)pvs->set_capacity * 2) + size;
+        if (set_capacity >= UINT32_MAX)
+            return false;
+
+        uint8_t *set_data = (uint8_t *)realloc(pvs->set_data, (size_t)set_capacity);
+        if (set_data == NULL)
+            return false;
+
+        pvs->set_data = set_data;
+        pvs->set_capacity = (uint32_t)set_capacity;
+    }
+
+    memcpy(pvs->set_data + pvs->set_size, scratch->set, size);
+
+    pvs->entry_sets[entry_index] = pvs->set_size;
+    pvs->set_size += size;
+
+    return true;
+}
+
+static int RayCastPVS_CompareSetOrder(const void *a, const void *b)
+{
+    uint64_t order_a = *(const uint64_t *)a;
+    uint64_t order_b = *(const uint64_t *)b;
+
+    return (order_a > order_b) - (order_a < order_b);
+}
+
+// Slides the sets still in use down over the ones rebakes left behind, keeping their order //
+static void RayCastPVS_Compact(RayCastPVS *pvs)
+{
+    // Offset in the high half, so sorting groups the entries sharing a set //
+    uint64_t *set_order = (uint64_t *)malloc(sizeof(uint64_t) * ((size_t)pvs->entry_count + 1));
+    if (set_order == NULL)
+        return;
+
+    int order_count = 0;
+
+    for (int i = 0; i < pvs->entry_count; i++)
+    {
+        if (pvs->entry_sets[i] != PVS_NO_SET)
+            set_order[order_count++] = ((uint64_t)pvs->entry_sets[i] << 32) | (uint32_t)i;
+    }
+
+    qsort(set_order, (size_t)order_count, sizeof(uint64_t), RayCastPVS_CompareSetOrder);
+
+    uint32_t read_offset = PVS_NO_SET;
+    uint32_t write_offset = 0;
+    uint32_t write_size = 0;
+
+    for (int i = 0; i < order_count; i++)
+    {
+        uint32_t offset = (uint32_t)(set_order[i] >> 32);
+
+        if (offset != read_offset)
+        {
+            read_offset = offset;
+            write_offset += write_size;
+            write_size = RayCastPVS_GetSetSize(pvs->set_data + offset, pvs->set_size - offset);
+
+            memmove(pvs->set_data + write_offset, pvs->set_data + offset, write_size);
+        }
+
+        pvs->entry_sets[(uint32_t)set_order[i]] = write_offset;
+    }
+
+    free(set_order);
+
+    pvs->set_size = write_offset + write_size;
+    pvs->compacted_size = pvs->set_size;
+}
+
+int RayCastPVS_Rebake(RayCastPVS *pvs, int max_entries)
+{
+    if (pvs == NULL)
+        return 0;
+
+    if (pvs->dirty_count == 0)
+        return 0;
+
+    if (pvs->rebake_scratch == NULL)
+    {
+        pvs->rebake_scratch = (RayCastPVSScratch *)malloc(sizeof(RayCastPVSScratch));
+        if (pvs->rebake_scratch == NULL)
+        {
+            SDL_Log("%s Failed to allocate memory for PVS rebakes", program_log_tag);
+            return 0;
+        }
+    }
+
+    int rebaked = 0;
+
+    while (pvs->dirty_count > 0 && rebaked < max_entries)
+    {
+        int entry_index = pvs->dirty_entries[pvs->dirty_head];
+
+        // A wall answers visible anyway, its set is baked if it ever opens again //
+        if (pvs->level.cells[pvs->entry_cells[entry_index]] == 0)
+        {
+            if (!RayCastPVS_RebakeEntry(pvs, entry_index, pvs->rebake_scratch))
+            {
+                SDL_Log("%s Failed to allocate memory for a rebaked PVS set", program_log_tag);
+                break;
+            }
+
+            rebaked++;
+        }
+
+        pvs->entry_dirty[entry_index] = 0;
+        pvs->dirty_head = (pvs->dirty_head + 1) % pvs->dirty_capacity;
+        pvs->dirty_count--;
+    }
+
+    // Once rebakes have appended half again what was there, most of it has usually replaced something //
+    if (pvs->set_size - pvs->compacted_size > pvs->compacted_size / 2)
+        RayCastPVS_Compact(pvs);
+
+    return rebaked;
+}
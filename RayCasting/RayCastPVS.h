@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastLevel.h"
+
+typedef struct RayCastPVS RayCastPVS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Loads the baked sets from disk or bakes them in parallel; NULL for levels too large to bother //
+    extern RayCastPVS *RayCastPVS_Create(const RayCastLevelView *level);
+    extern void RayCastPVS_Destroy(RayCastPVS *pvs);
+
+    // False only when every line from anywhere in one cell to anywhere in the other crosses //
+    // the inside of an opaque cell; true for anything outside the baked sets.               //
+    extern bool RayCastPVS_IsVisible(const RayCastPVS *pvs, int from_cell, int to_cell);
+
+    // The level's cells changed in place at these indices. Sets that could see them answer //
+    // visible until rebaked, cells that opened up get sets of their own.                   //
+    extern void RayCastPVS_UpdateCells(RayCastPVS *pvs, const int *cells, int count);
+
+    // Rebakes up to max_entries of the sets edits left stale, returns how many it did //
+    extern int RayCastPVS_Rebake(RayCastPVS *pvs, int max_entries);
+
+    extern size_t RayCastPVS_GetMemoryBytes(const RayCastPVS *pvs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,413 @@
+#include "RayCastPerf.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <memory.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include <SDL3/SDL.h>
+
+#define RAYCAST_PERF_MAX_STAGES 16
+
+struct RayCastPerf
+{
+    // Cycles lead the group, so one read returns every counter at the same instant //
+    int fds[RAYCAST_PERF_COUNTER_COUNT];
+    int slots[RAYCAST_PERF_COUNTER_COUNT]; // Position in a group read, -1 if the host lacks it //
+
+    const char *const *stage_names;
+    int stage_count;
+
+    RayCastPerfCounters stage_begin[RAYCAST_PERF_MAX_STAGES];
+    bool stage_open[RAYCAST_PERF_MAX_STAGES];
+    RayCastPerfCounters frame[RAYCAST_PERF_MAX_STAGES];
+    bool frame_ran[RAYCAST_PERF_MAX_STAGES];
+
+    // Current Second //
+    RayCastPerfCounters window_sum[RAYCAST_PERF_MAX_STAGES];
+    int window_runs[RAYCAST_PERF_MAX_STAGES];
+    uint64_t window_start_ns;
+
+    // Last Full Second, Per Run Of Each Stage //
+    RayCastPerfCounters average[RAYCAST_PERF_MAX_STAGES];
+    bool has_average[RAYCAST_PERF_MAX_STAGES];
+
+    SDL_IOStream *csv;
+};
+
+static const char *const counter_columns[RAYCAST_PERF_COUNTER_COUNT] =
+{
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses"
+};
+
+static const uint64_t average_window_ns = 1000000000ULL;
+
+static const char program_log_tag[] = "[RayCastPerf.c]";
+
+#ifdef __linux__
+static int RayCastPerf_OpenCounter(uint32_t type, uint64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (group_fd == -1); // The group starts once every member is in //
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static bool RayCastPerf_OpenCounters(RayCastPerf *perf)
+{
+    static const uint32_t types[RAYCAST_PERF_COUNTER_COUNT] =
+    {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE
+    };
+    static const uint64_t configs[RAYCAST_PERF_COUNTER_COUNT] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES, // Last level on most cores //
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    int slot_count = 0;
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+    {
+        perf->fds[i] = RayCastPerf_OpenCounter(types[i], configs[i], (i == 0) ? -1 : perf->fds[0]);
+
+        if (perf->fds[i] < 0)
+        {
+            if (i == 0)
+            {
+                SDL_Log("%s perf_event_open refused: %s", program_log_tag, strerror(errno));
+                return false;
+            }
+
+            SDL_Log("%s No %s counter on this host: %s", program_log_tag, counter_columns[i], strerror(errno));
+            continue;
+        }
+
+        perf->slots[i] = slot_count++;
+    }
+
+    ioctl(perf->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return true;
+}
+
+// Scaled up when the kernel had to multiplex the group with other users of the PMU //
+static void RayCastPerf_Read(const RayCastPerf *perf, RayCastPerfCounters *counters)
+{
+    uint64_t buffer[3 + RAYCAST_PERF_COUNTER_COUNT];
+
+    memset(counters, 0, sizeof(RayCastPerfCounters));
+
+    ssize_t read_size = read(perf->fds[0], buffer, sizeof(buffer));
+    if (read_size < (ssize_t)(sizeof(uint64_t) * 3))
+        return;
+
+    uint64_t value_count = buffer[0];
+    uint64_t time_enabled = buffer[1];
+    uint64_t time_running = buffer[2];
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+    {
+        int slot = perf->slots[i];
+        if (slot < 0 || (uint64_t)slot >= value_count)
+            continue;
+
+        uint64_t value = buffer[3 + slot];
+        if (time_running > 0 && time_running < time_enabled)
+            value = (uint64_t)((double)value * time_enabled / time_running);
+
+        counters->values[i] = value;
+    }
+}
+#else
+static bool RayCastPerf_OpenCounters(RayCastPerf *perf)
+{
+    SDL_Log("%s Hardware counters need Linux perf_event_open", program_log_tag);
+    return false;
+}
+
+static void RayCastPerf_Read(const RayCastPerf *perf, RayCastPerfCounters *counters)
+{
+    memset(counters, 0, sizeof(RayCastPerfCounters));
+}
+#endif
+
+static void RayCastPerf_WriteCsvHeader(RayCastPerf *perf)
+{
+    char line[256];
+    int length = snprintf(line, sizeof(line), "tick,stage");
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+        length += snprintf(line + length, sizeof(line) - length, ",%s", counter_columns[i]);
+
+    length += snprintf(line + length, sizeof(line) - length, "\n");
+
+    SDL_WriteIO(perf->csv, line, (size_t)length);
+}
+
+// Counters the host lacks are left empty rather than written as zero //
+static void RayCastPerf_WriteCsvRow(RayCastPerf *perf, uint64_t tick, int stage)
+{
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%llu,%s", (unsigned long long)tick, perf->stage_names[stage]);
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+    {
+        if (perf->slots[i] >= 0)
+            length += snprintf(line + length, sizeof(line) - length, ",%llu", (unsigned long long)perf->frame[stage].values[i]);
+        else
+            length += snprintf(line + length, sizeof(line) - length, ",");
+    }
+
+    length += snprintf(line + length, sizeof(line) - length, "\n");
+
+    SDL_WriteIO(perf->csv, line, (size_t)length);
+}
+
+RayCastPerf *RayCastPerf_Create(const char *const *stage_names, int stage_count, const char *csv_path)
+{
+    if (stage_count < 1 || stage_count > RAYCAST_PERF_MAX_STAGES)
+        return NULL;
+
+    RayCastPerf *perf = (RayCastPerf *)malloc(sizeof(RayCastPerf));
+    if (perf == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for counters", program_log_tag);
+        return NULL;
+    }
+    memset(perf, 0, sizeof(RayCastPerf));
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+    {
+        perf->fds[i] = -1;
+        perf->slots[i] = -1;
+    }
+
+    perf->stage_names = stage_names;
+    perf->stage_count = stage_count;
+
+    if (!RayCastPerf_OpenCounters(perf))
+        goto Error;
+
+    if (csv_path != NULL)
+    {
+        perf->csv = SDL_IOFromFile(csv_path, "wb");
+        if (perf->csv == NULL)
+        {
+            SDL_Log("%s Failed to open \"%s\": %s", program_log_tag, csv_path, SDL_GetError());
+            goto Error;
+        }
+
+        RayCastPerf_WriteCsvHeader(perf);
+    }
+
+    perf->window_start_ns = SDL_GetTicksNS();
+
+    SDL_Log("%s Counting %s%s", program_log_tag, (perf->slots[RAYCAST_PERF_INSTRUCTIONS] >= 0) ? "cycles and instructions" : "cycles",
+        (csv_path != NULL) ? ", writing per-stage rows" : "");
+
+    return perf;
+
+Error:
+    RayCastPerf_Destroy(perf);
+
+    return NULL;
+}
+
+void RayCastPerf_Destroy(RayCastPerf *perf)
+{
+    if (perf == NULL)
+        return;
+
+    if (perf->csv != NULL)
+        SDL_CloseIO(perf->csv);
+
+#ifdef __linux__
+    // Members first, the leader holds the group together //
+    for (int i = RAYCAST_PERF_COUNTER_COUNT - 1; i >= 0; i--)
+    {
+        if (perf->fds[i] >= 0)
+            close(perf->fds[i]);
+    }
+#endif
+
+    free(perf);
+}
+
+void RayCastPerf_Begin(RayCastPerf *perf, int stage)
+{
+    if (perf == NULL || stage < 0 || stage >= perf->stage_count)
+        return;
+
+    RayCastPerf_Read(perf, &perf->stage_begin[stage]);
+    perf->stage_open[stage] = true;
+}
+
+void RayCastPerf_End(RayCastPerf *perf, int stage)
+{
+    // Also covers counters created halfway through the stage //
+    if (perf == NULL || stage < 0 || stage >= perf->stage_count || !perf->stage_open[stage])
+        return;
+
+    RayCastPerfCounters now;
+    RayCastPerf_Read(perf, &now);
+
+    for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+        perf->frame[stage].values[i] += now.values[i] - perf->stage_begin[stage].values[i];
+
+    perf->frame_ran[stage] = true;
+    perf->stage_open[stage] = false;
+}
+
+bool RayCastPerf_EndFrame(RayCastPerf *perf, uint64_t tick)
+{
+    if (perf == NULL)
+        return false;
+
+    for (int stage = 0; stage < perf->stage_count; stage++)
+    {
+        if (!perf->frame_ran[stage])
+            continue;
+
+        if (perf->csv != NULL)
+            RayCastPerf_WriteCsvRow(perf, tick, stage);
+
+        for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+            perf->window_sum[stage].values[i] += perf->frame[stage].values[i];
+        perf->window_runs[stage]++;
+
+        memset(&perf->frame[stage], 0, sizeof(RayCastPerfCounters));
+        perf->frame_ran[stage] = false;
+    }
+
+    uint64_t current_ns = SDL_GetTicksNS();
+    if (current_ns - perf->window_start_ns < average_window_ns)
+        return false;
+
+    // Stages that did not run this second keep their last average //
+    for (int stage = 0; stage < perf->stage_count; stage++)
+    {
+        int runs = perf->window_runs[stage];
+        if (runs == 0)
+            continue;
+
+        for (int i = 0; i < RAYCAST_PERF_COUNTER_COUNT; i++)
+            perf->average[stage].values[i] = perf->window_sum[stage].values[i] / (uint64_t)runs;
+        perf->has_average[stage] = true;
+
+        memset(&perf->window_sum[stage], 0, sizeof(RayCastPerfCounters));
+        perf->window_runs[stage] = 0;
+    }
+
+    perf->window_start_ns = current_ns;
+
+    return true;
+}
+
+bool RayCastPerf_HasCounter(const RayCastPerf *perf, RayCastPerfCounter counter)
+{
+    return (perf != NULL && counter >= 0 && counter < RAYCAST_PERF_COUNTER_COUNT && perf->slots[counter] >= 0);
+}
+
+bool RayCastPerf_GetAverage(const RayCastPerf *perf, int stage, RayCastPerfCounters *counters)
+{
+    if (perf == NULL || stage < 0 || stage >= perf->stage_count || !perf->has_average[stage])
+        return false;
+
+    *counters = perf->average[stage];
+
+    return true;
+}
+
+// Thousands of events, or a dash where the host has no such counter //
+static int RayCastPerf_FormatKilo(const RayCastPerf *perf, const RayCastPerfCounters *counters, RayCastPerfCounter counter, char *text, size_t size)
+{
+    if (!RayCastPerf_HasCounter(perf, counter))
+        return snprintf(text, size, " %8s", "-");
+
+    return snprintf(text, size, " %8.2f", counters->values[counter] / 1000.0);
+}
+
+void RayCastPerf_DrawOverlay(const RayCastPerf *perf, SDL_Renderer *renderer)
+{
+    if (perf == NULL || renderer == NULL)
+        return;
+
+    const float char_size = (float)SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE;
+    const float margin = char_size;
+    const float line_height = char_size + 2.0F;
+
+    char header[128];
+    int header_length = snprintf(header, sizeof(header), "%-10s %7s %5s %8s %8s %8s", "stage", "Mcyc", "IPC", "L1D k", "LLC k", "brm k");
+
+    SDL_FRect background;
+    background.x = margin - 4.0F;
+    background.y = margin - 4.0F;
+    background.w = (header_length * char_size) + 8.0F;
+    background.h = (perf->stage_count + 1) * line_height + 6.0F;
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 176);
+    SDL_RenderFillRect(renderer, &background);
+
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderDebugText(renderer, margin, margin, header);
+
+    for (int stage = 0; stage < perf->stage_count; stage++)
+    {
+        char line[128];
+        int length = snprintf(line, sizeof(line), "%-10s", perf->stage_names[stage]);
+
+        RayCastPerfCounters counters;
+        if (RayCastPerf_GetAverage(perf, stage, &counters))
+        {
+            uint64_t cycles = counters.values[RAYCAST_PERF_CYCLES];
+            uint64_t instructions = counters.values[RAYCAST_PERF_INSTRUCTIONS];
+
+            length += snprintf(line + length, sizeof(line) - length, " %7.3f", cycles / 1000000.0);
+
+            if (RayCastPerf_HasCounter(perf, RAYCAST_PERF_INSTRUCTIONS) && cycles > 0)
+                length += snprintf(line + length, sizeof(line) - length, " %5.2f", (double)instructions / cycles);
+            else
+                length += snprintf(line + length, sizeof(line) - length, " %5s", "-");
+
+            length += RayCastPerf_FormatKilo(perf, &counters, RAYCAST_PERF_L1D_MISSES, line + length, sizeof(line) - length);
+            length += RayCastPerf_FormatKilo(perf, &counters, RAYCAST_PERF_LLC_MISSES, line + length, sizeof(line) - length);
+            RayCastPerf_FormatKilo(perf, &counters, RAYCAST_PERF_BRANCH_MISSES, line + length, sizeof(line) - length);
+        }
+        else
+            snprintf(line + length, sizeof(line) - length, " (not run)");
+
+        SDL_RenderDebugText(renderer, margin, margin + ((stage + 1) * line_height), line);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <SDL3/SDL.h>
+
+typedef enum
+{
+    RAYCAST_PERF_CYCLES,
+    RAYCAST_PERF_INSTRUCTIONS,
+    RAYCAST_PERF_L1D_MISSES,
+    RAYCAST_PERF_LLC_MISSES,
+    RAYCAST_PERF_BRANCH_MISSES,
+    RAYCAST_PERF_COUNTER_COUNT
+}
+RayCastPerfCounter;
+
+typedef struct
+{
+    uint64_t values[RAYCAST_PERF_COUNTER_COUNT];
+}
+RayCastPerfCounters;
+
+typedef struct RayCastPerf RayCastPerf;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Counts on the calling thread only, user space only. NULL where perf_event_open is missing //
+    // or refused, e.g. off Linux or under a strict perf_event_paranoid. csv_path may be NULL.    //
+    extern RayCastPerf *RayCastPerf_Create(const char *const *stage_names, int stage_count, const char *csv_path);
+    extern void RayCastPerf_Destroy(RayCastPerf *perf);
+
+    // Stages must not nest; a stage may run several times per frame //
+    extern void RayCastPerf_Begin(RayCastPerf *perf, int stage);
+    extern void RayCastPerf_End(RayCastPerf *perf, int stage);
+
+    // One CSV row per stage that ran. True when the per-second averages were refreshed //
+    extern bool RayCastPerf_EndFrame(RayCastPerf *perf, uint64_t tick);
+
+    extern bool RayCastPerf_HasCounter(const RayCastPerf *perf, RayCastPerfCounter counter);
+
+    // Per-frame averages over the last full second //
+    extern bool RayCastPerf_GetAverage(const RayCastPerf *perf, int stage, RayCastPerfCounters *counters);
+
+    extern void RayCastPerf_DrawOverlay(const RayCastPerf *perf, SDL_Renderer *renderer);
+
+#ifdef __cplusplus
+}
+#endif
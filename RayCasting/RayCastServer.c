@@ -0,0 +1,841 @@
+#include "RayCastServer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <memory.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#include <SDL3/SDL.h>
+
+static const char program_log_tag[] = "[RayCastServer.c]";
+
+// Platform Sockets //
+
+#ifdef _WIN32
+typedef SOCKET RayCastSocket;
+typedef WSAPOLLFD RayCastPollFd;
+#define RAYCAST_INVALID_SOCKET INVALID_SOCKET
+#define RAYCAST_SEND_FLAGS 0
+#else
+typedef int RayCastSocket;
+typedef struct pollfd RayCastPollFd;
+#define RAYCAST_INVALID_SOCKET -1
+#ifdef MSG_NOSIGNAL
+#define RAYCAST_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define RAYCAST_SEND_FLAGS 0
+#endif
+#endif
+
+#define RAYCAST_SERVER_MAX_CLIENTS      16
+#define RAYCAST_SERVER_MAX_BATCH        64
+#define RAYCAST_SERVER_MAX_WORKERS      32
+#define RAYCAST_SERVER_RECEIVE_REQUESTS 16
+
+typedef struct
+{
+    uint8_t *base;
+    size_t size;
+    char name[RAYCAST_SERVER_SHARED_NAME_SIZE];
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+}
+RayCastSharedMemory;
+
+typedef struct
+{
+    RayCastSocket socket;
+    RayCastSharedMemory frames;
+
+    // Requests may arrive split across reads //
+    uint8_t receive_buffer[RAYCAST_SERVER_RECEIVE_REQUESTS * sizeof(RayCastServerRequest)];
+    int receive_length;
+}
+RayCastServerClient;
+
+typedef struct
+{
+    int client;
+    RayCastServerRequest request;
+    Uint64 received_ns;
+
+    int status;
+}
+RayCastServerJob;
+
+typedef struct
+{
+    SDL_Thread *thread;
+    SDL_Semaphore *start;
+    RayCastRenderContext *context;
+}
+RayCastServerWorker;
+
+// Settings //
+
+static const int slots_per_client = 8;
+static const int slot_alignment = 4096;
+static const int poll_timeout_ms = 100;
+static const int send_wait_ms = 1000;
+static const int texture_wait_ms = 10000;
+static const Uint64 stats_interval_ns = 1000000000;
+static const int max_latency_samples = 1 << 16;
+
+// Server State //
+
+static RayCastSocket listen_socket = RAYCAST_INVALID_SOCKET;
+static RayCastServerClient clients[RAYCAST_SERVER_MAX_CLIENTS];
+static int shared_memory_serial = 0;
+
+static int frame_width;
+static int frame_height;
+static int frame_bytes_per_pixel;
+static int frame_pitch;
+static size_t frame_slot_size;
+
+// Batch Dispatch //
+
+static RayCastServerWorker workers[RAYCAST_SERVER_MAX_WORKERS];
+static int worker_count = 0;
+
+static SDL_Semaphore *batch_done = NULL;
+static SDL_AtomicInt next_job;
+static SDL_AtomicInt workers_quit;
+
+static RayCastServerJob batch_jobs[RAYCAST_SERVER_MAX_BATCH];
+static int batch_count = 0;
+static int next_client = 0;
+
+// Stats Window //
+
+static Uint64 *latency_samples = NULL;
+static int latency_sample_count = 0;
+static int stats_requests = 0;
+static int stats_batches = 0;
+static Uint64 stats_start_ns = 0;
+
+static void RayCastServer_CloseSocket(RayCastSocket socket_handle)
+{
+#ifdef _WIN32
+    closesocket(socket_handle);
+#else
+    close(socket_handle);
+#endif
+}
+
+static bool RayCastServer_SetNonBlocking(RayCastSocket socket_handle)
+{
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    return (ioctlsocket(socket_handle, FIONBIO, &non_blocking) == 0);
+#else
+    int flags = fcntl(socket_handle, F_GETFL, 0);
+    return (flags >= 0 && fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK) == 0);
+#endif
+}
+
+static bool RayCastServer_WouldBlock(void)
+{
+#ifdef _WIN32
+    return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+#endif
+}
+
+static int RayCastServer_Poll(RayCastPollFd *fds, int count, int timeout_ms)
+{
+#ifdef _WIN32
+    return WSAPoll(fds, (ULONG)count, timeout_ms);
+#else
+    return poll(fds, (nfds_t)count, timeout_ms);
+#endif
+}
+
+// Responses are small, a briefly full socket buffer is waited out. A client that reads //
+// nothing for send_wait_ms has stopped and is dropped, like one whose socket failed.    //
+static bool RayCastServer_Send(RayCastSocket socket_handle, const void *data, int size)
+{
+    const char *ptr_data = (const char *)data;
+
+    while (size > 0)
+    {
+        int sent = (int)send(socket_handle, ptr_data, size, RAYCAST_SEND_FLAGS);
+        if (sent < 0 && RayCastServer_WouldBlock())
+        {
+            RayCastPollFd poll_fd;
+            poll_fd.fd = socket_handle;
+            poll_fd.events = POLLOUT;
+            poll_fd.revents = 0;
+
+            int ready = RayCastServer_Poll(&poll_fd, 1, send_wait_ms);
+            if (ready == 0 || (ready < 0 && !RayCastServer_WouldBlock()))
+                return false;
+
+            continue;
+        }
+
+        if (sent <= 0)
+            return false;
+
+        ptr_data += sent;
+        size -= sent;
+    }
+
+    return true;
+}
+
+// Shared Memory //
+
+static bool RayCastServer_CreateSharedMemory(RayCastSharedMemory *shared, size_t size)
+{
+    memset(shared, 0, sizeof(RayCastSharedMemory));
+
+#ifdef _WIN32
+    snprintf(shared->name, sizeof(shared->name), "Local\\raycast_%lu_%d", (unsigned long)GetCurrentProcessId(), shared_memory_serial++);
+
+    shared->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, shared->name);
+    if (shared->mapping == NULL)
+        return false;
+
+    shared->base = (uint8_t *)MapViewOfFile(shared->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (shared->base == NULL)
+    {
+        CloseHandle(shared->mapping);
+        return false;
+    }
+#else
+    snprintf(shared->name, sizeof(shared->name), "/raycast_%d_%d", (int)getpid(), shared_memory_serial++);
+
+    int fd = shm_open(shared->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(shared->name);
+        return false;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the object alive //
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(shared->name);
+        return false;
+    }
+
+    shared->base = (uint8_t *)base;
+#endif
+
+    shared->size = size;
+
+    return true;
+}
+
+static void RayCastServer_DestroySharedMemory(RayCastSharedMemory *shared)
+{
+    if (shared->base == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(shared->base);
+    CloseHandle(shared->mapping);
+#else
+    munmap(shared->base, shared->size);
+    shm_unlink(shared->name);
+#endif
+
+    memset(shared, 0, sizeof(RayCastSharedMemory));
+}
+
+// Clients //
+
+static void RayCastServer_AcceptClient(void)
+{
+    RayCastSocket client_socket = accept(listen_socket, NULL, NULL);
+    if (client_socket == RAYCAST_INVALID_SOCKET)
+        return;
+
+    RayCastServerClient *client = NULL;
+    int client_index = 0;
+
+    for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS; i++)
+    {
+        if (clients[i].socket == RAYCAST_INVALID_SOCKET)
+        {
+            client = &clients[i];
+            client_index = i;
+            break;
+        }
+    }
+
+    if (client == NULL)
+    {
+        SDL_Log("%s Refusing client, %d already connected", program_log_tag, RAYCAST_SERVER_MAX_CLIENTS);
+        RayCastServer_CloseSocket(client_socket);
+        return;
+    }
+
+    if (!RayCastServer_CreateSharedMemory(&client->frames, frame_slot_size * (size_t)slots_per_client))
+    {
+        SDL_Log("%s Failed to create shared frames for client", program_log_tag);
+        RayCastServer_CloseSocket(client_socket);
+        return;
+    }
+
+    RayCastServerHello hello;
+    memset(&hello, 0, sizeof(hello));
+
+    hello.magic = RAYCAST_SERVER_MAGIC_HELLO;
+    hello.version = RAYCAST_SERVER_VERSION;
+    hello.width = frame_width;
+    hello.height = frame_height;
+    hello.bytes_per_pixel = frame_bytes_per_pixel;
+    hello.pitch = frame_pitch;
+    hello.slot_count = slots_per_client;
+    hello.slot_size = (uint32_t)frame_slot_size;
+    memcpy(hello.shared_memory_name, client->frames.name, sizeof(hello.shared_memory_name));
+
+    if (!RayCastServer_Send(client_socket, &hello, sizeof(hello)) || !RayCastServer_SetNonBlocking(client_socket))
+    {
+        RayCastServer_DestroySharedMemory(&client->frames);
+        RayCastServer_CloseSocket(client_socket);
+        return;
+    }
+
+    client->socket = client_socket;
+    client->receive_length = 0;
+
+    SDL_Log("%s Client %d connected, frames in %s", program_log_tag, client_index, client->frames.name);
+}
+
+static void RayCastServer_DisconnectClient(int client_index)
+{
+    RayCastServerClient *client = &clients[client_index];
+
+    if (client->socket == RAYCAST_INVALID_SOCKET)
+        return;
+
+    RayCastServer_CloseSocket(client->socket);
+    RayCastServer_DestroySharedMemory(&client->frames);
+
+    client->socket = RAYCAST_INVALID_SOCKET;
+    client->receive_length = 0;
+
+    SDL_Log("%s Client %d disconnected", program_log_tag, client_index);
+}
+
+// False when the client hung up or broke protocol //
+static bool RayCastServer_ReceiveRequests(int client_index)
+{
+    RayCastServerClient *client = &clients[client_index];
+
+    int free_bytes = (int)sizeof(client->receive_buffer) - client->receive_length;
+    if (free_bytes <= 0)
+        return true;
+
+    int received = (int)recv(client->socket, (char *)client->receive_buffer + client->receive_length, free_bytes, 0);
+    if (received == 0)
+        return false;
+    if (received < 0)
+        return RayCastServer_WouldBlock();
+
+    client->receive_length += received;
+
+    // Checked here so a bad stream is dropped before anything is queued from it //
+    for (int offset = 0; offset + (int)sizeof(RayCastServerRequest) <= client->receive_length; offset += (int)sizeof(RayCastServerRequest))
+    {
+        uint32_t magic;
+        memcpy(&magic, client->receive_buffer + offset, sizeof(magic));
+
+        if (magic != RAYCAST_SERVER_MAGIC_REQUEST)
+        {
+            SDL_Log("%s Client %d sent a malformed request", program_log_tag, client_index);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool RayCastServer_TakeRequest(int client_index, Uint64 now_ns)
+{
+    RayCastServerClient *client = &clients[client_index];
+
+    if (client->socket == RAYCAST_INVALID_SOCKET || client->receive_length < (int)sizeof(RayCastServerRequest))
+        return false;
+
+    RayCastServerJob *job = &batch_jobs[batch_count++];
+
+    job->client = client_index;
+    job->received_ns = now_ns;
+    job->status = 0;
+    memcpy(&job->request, client->receive_buffer, sizeof(RayCastServerRequest));
+
+    client->receive_length -= (int)sizeof(RayCastServerRequest);
+    memmove(client->receive_buffer, client->receive_buffer + sizeof(RayCastServerRequest), (size_t)client->receive_length);
+
+    return true;
+}
+
+// One request per client per pass, so a client streaming poses cannot starve the rest //
+static void RayCastServer_GatherBatch(Uint64 now_ns)
+{
+    batch_count = 0;
+
+    bool took_any = true;
+
+    while (took_any && batch_count < RAYCAST_SERVER_MAX_BATCH)
+    {
+        took_any = false;
+
+        for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS && batch_count < RAYCAST_SERVER_MAX_BATCH; i++)
+        {
+            int client_index = (next_client + i) % RAYCAST_SERVER_MAX_CLIENTS;
+
+            if (RayCastServer_TakeRequest(client_index, now_ns))
+                took_any = true;
+        }
+    }
+
+    next_client = (next_client + 1) % RAYCAST_SERVER_MAX_CLIENTS;
+}
+
+static bool RayCastServer_HasBufferedRequests(void)
+{
+    for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS; i++)
+    {
+        if (clients[i].socket != RAYCAST_INVALID_SOCKET && clients[i].receive_length >= (int)sizeof(RayCastServerRequest))
+            return true;
+    }
+
+    return false;
+}
+
+// Rendering //
+
+static void RayCastServer_RenderJob(RayCastRenderContext *context, RayCastServerJob *job)
+{
+    if (job->request.slot >= (uint32_t)slots_per_client)
+    {
+        job->status = RAYCAST_SERVER_STATUS_BAD_SLOT;
+        return;
+    }
+
+    uint8_t *pixels = clients[job->client].frames.base + frame_slot_size * job->request.slot;
+
+    int rays_traversed = RayCast_RenderPose(context, &job->request.pose, pixels, frame_pitch);
+
+    job->status = (rays_traversed < 0) ? RAYCAST_SERVER_STATUS_BAD_POSE : rays_traversed;
+}
+
+static int SDLCALL RayCastServer_WorkerThread(void *data)
+{
+    RayCastServerWorker *worker = (RayCastServerWorker *)data;
+
+    while (true)
+    {
+        SDL_WaitSemaphore(worker->start);
+
+        if (SDL_GetAtomicInt(&workers_quit) != 0)
+            break;
+
+        int job_index;
+        while ((job_index = SDL_AddAtomicInt(&next_job, 1)) < batch_count)
+            RayCastServer_RenderJob(worker->context, &batch_jobs[job_index]);
+
+        SDL_SignalSemaphore(batch_done);
+    }
+
+    return 0;
+}
+
+static void RayCastServer_RenderBatch(void)
+{
+    RayCast_PrepareBatch();
+
+    SDL_SetAtomicInt(&next_job, 0);
+
+    // No point waking more workers than there are jobs //
+    int wake_count = (batch_count < worker_count) ? batch_count : worker_count;
+
+    for (int i = 0; i < wake_count; i++)
+        SDL_SignalSemaphore(workers[i].start);
+
+    for (int i = 0; i < wake_count; i++)
+        SDL_WaitSemaphore(batch_done);
+}
+
+static void RayCastServer_SendResponses(void)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        const RayCastServerJob *job = &batch_jobs[i];
+
+        // Dropped earlier in this loop //
+        if (clients[job->client].socket == RAYCAST_INVALID_SOCKET)
+            continue;
+
+        Uint64 latency_ns = SDL_GetTicksNS() - job->received_ns;
+
+        RayCastServerResponse response;
+        response.magic = RAYCAST_SERVER_MAGIC_RESPONSE;
+        response.request_id = job->request.request_id;
+        response.slot = job->request.slot;
+        response.status = job->status;
+        response.latency_ns = latency_ns;
+
+        if (!RayCastServer_Send(clients[job->client].socket, &response, sizeof(response)))
+        {
+            RayCastServer_DisconnectClient(job->client);
+            continue;
+        }
+
+        if (latency_sample_count < max_latency_samples)
+            latency_samples[latency_sample_count++] = latency_ns;
+    }
+
+    stats_requests += batch_count;
+    stats_batches++;
+}
+
+// Workers //
+
+static bool RayCastServer_StartWorkers(void)
+{
+    worker_count = SDL_GetNumLogicalCPUCores();
+    if (worker_count > RAYCAST_SERVER_MAX_WORKERS)
+        worker_count = RAYCAST_SERVER_MAX_WORKERS;
+    if (worker_count < 1)
+        worker_count = 1;
+
+    SDL_SetAtomicInt(&workers_quit, 0);
+
+    batch_done = SDL_CreateSemaphore(0);
+    if (batch_done == NULL)
+        return false;
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        RayCastServerWorker *worker = &workers[i];
+
+        worker->context = RayCast_CreateRenderContext();
+        worker->start = SDL_CreateSemaphore(0);
+
+        if (worker->context != NULL && worker->start != NULL)
+            worker->thread = SDL_CreateThread(RayCastServer_WorkerThread, "RayCastServer", (void *)worker);
+
+        if (worker->thread == NULL)
+        {
+            SDL_Log("%s Failed to start worker %d", program_log_tag, i);
+
+            if (worker->start != NULL)
+                SDL_DestroySemaphore(worker->start);
+
+            RayCast_DestroyRenderContext(worker->context);
+
+            memset(worker, 0, sizeof(RayCastServerWorker));
+
+            // Serve with whatever started //
+            worker_count = i;
+            return (i > 0);
+        }
+    }
+
+    return true;
+}
+
+static void RayCastServer_StopWorkers(void)
+{
+    SDL_SetAtomicInt(&workers_quit, 1);
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        RayCastServerWorker *worker = &workers[i];
+
+        if (worker->thread != NULL)
+        {
+            SDL_SignalSemaphore(worker->start);
+            SDL_WaitThread(worker->thread, NULL);
+        }
+
+        if (worker->start != NULL)
+            SDL_DestroySemaphore(worker->start);
+
+        RayCast_DestroyRenderContext(worker->context);
+
+        memset(worker, 0, sizeof(RayCastServerWorker));
+    }
+
+    worker_count = 0;
+
+    if (batch_done != NULL)
+    {
+        SDL_DestroySemaphore(batch_done);
+        batch_done = NULL;
+    }
+}
+
+// Stats //
+
+static int RayCastServer_CompareLatency(const void *a, const void *b)
+{
+    Uint64 latency_a = *(const Uint64 *)a;
+    Uint64 latency_b = *(const Uint64 *)b;
+
+    return (latency_a > latency_b) - (latency_a < latency_b);
+}
+
+static double RayCastServer_Percentile(int percent)
+{
+    int index = (int)(((int64_t)(latency_sample_count - 1) * percent) / 100);
+
+    return (double)latency_samples[index] / 1000000.0;
+}
+
+static void RayCastServer_LogStats(Uint64 now_ns)
+{
+    Uint64 elapsed_ns = now_ns - stats_start_ns;
+    if (elapsed_ns < stats_interval_ns)
+        return;
+
+    if (stats_requests > 0 && latency_sample_count > 0)
+    {
+        qsort(latency_samples, (size_t)latency_sample_count, sizeof(Uint64), RayCastServer_CompareLatency);
+
+        double requests_per_second = (double)stats_requests * 1000000000.0 / (double)elapsed_ns;
+
+        SDL_Log("%s %.1f requests/s, %.1f per batch, latency p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms",
+            program_log_tag, requests_per_second, (double)stats_requests / (double)stats_batches,
+            RayCastServer_Percentile(50), RayCastServer_Percentile(90), RayCastServer_Percentile(99), RayCastServer_Percentile(100));
+    }
+
+    latency_sample_count = 0;
+    stats_requests = 0;
+    stats_batches = 0;
+    stats_start_ns = now_ns;
+}
+
+// Listening //
+
+static bool RayCastServer_Listen(const char *socket_path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+
+    size_t path_length = strlen(socket_path);
+    if (path_length >= sizeof(address.sun_path))
+    {
+        SDL_Log("%s Socket path too long: %s", program_log_tag, socket_path);
+        return false;
+    }
+
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socket_path, path_length + 1);
+
+    // A socket file left by a previous run makes bind fail //
+    remove(socket_path);
+
+    listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_socket == RAYCAST_INVALID_SOCKET)
+    {
+        SDL_Log("%s Failed to create socket", program_log_tag);
+        return false;
+    }
+
+    if (bind(listen_socket, (const struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listen_socket, RAYCAST_SERVER_MAX_CLIENTS) != 0 ||
+        !RayCastServer_SetNonBlocking(listen_socket))
+    {
+        SDL_Log("%s Failed to listen on %s", program_log_tag, socket_path);
+        RayCastServer_CloseSocket(listen_socket);
+        listen_socket = RAYCAST_INVALID_SOCKET;
+        return false;
+    }
+
+    return true;
+}
+
+static bool RayCastServer_IsQuitRequested(void)
+{
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_EVENT_QUIT)
+            return true;
+    }
+
+    return false;
+}
+
+static void RayCastServer_Serve(void)
+{
+    RayCastPollFd poll_fds[1 + RAYCAST_SERVER_MAX_CLIENTS];
+    int poll_clients[1 + RAYCAST_SERVER_MAX_CLIENTS];
+
+    stats_start_ns = SDL_GetTicksNS();
+
+    while (!RayCastServer_IsQuitRequested())
+    {
+        int poll_count = 0;
+
+        poll_fds[poll_count].fd = listen_socket;
+        poll_fds[poll_count].events = POLLIN;
+        poll_fds[poll_count].revents = 0;
+        poll_clients[poll_count++] = -1;
+
+        for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS; i++)
+        {
+            if (clients[i].socket == RAYCAST_INVALID_SOCKET)
+                continue;
+
+            poll_fds[poll_count].fd = clients[i].socket;
+            poll_fds[poll_count].events = POLLIN;
+            poll_fds[poll_count].revents = 0;
+            poll_clients[poll_count++] = i;
+        }
+
+        // Do not sleep while requests are already buffered //
+        int timeout_ms = RayCastServer_HasBufferedRequests() ? 0 : poll_timeout_ms;
+
+        if (RayCastServer_Poll(poll_fds, poll_count, timeout_ms) > 0)
+        {
+            for (int i = 0; i < poll_count; i++)
+            {
+                if (poll_fds[i].revents == 0)
+                    continue;
+
+                if (poll_clients[i] < 0)
+                    RayCastServer_AcceptClient();
+                else if (!RayCastServer_ReceiveRequests(poll_clients[i]))
+                    RayCastServer_DisconnectClient(poll_clients[i]);
+            }
+        }
+
+        Uint64 now_ns = SDL_GetTicksNS();
+
+        RayCastServer_GatherBatch(now_ns);
+
+        if (batch_count > 0)
+        {
+            RayCastServer_RenderBatch();
+            RayCastServer_SendResponses();
+        }
+
+        RayCastServer_LogStats(SDL_GetTicksNS());
+    }
+}
+
+int RayCastServer_Run(const char *socket_path)
+{
+    int exit_code = 1;
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        SDL_Log("%s Failed to initialize sockets", program_log_tag);
+        return exit_code;
+    }
+#endif
+
+    for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS; i++)
+    {
+        memset(&clients[i], 0, sizeof(RayCastServerClient));
+        clients[i].socket = RAYCAST_INVALID_SOCKET;
+    }
+
+    if (!RayCast_InitializeHeadless())
+        goto Error;
+
+    // Ctrl+C and SIGTERM arrive as SDL_EVENT_QUIT //
+    if (!SDL_Init(SDL_INIT_EVENTS))
+    {
+        SDL_Log("%s Failed to initialize events: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+
+    RayCast_GetFrameLayout(&frame_width, &frame_height, &frame_bytes_per_pixel);
+    frame_pitch = frame_width * frame_bytes_per_pixel;
+    frame_slot_size = ((size_t)frame_pitch * (size_t)frame_height + (size_t)(slot_alignment - 1)) & ~(size_t)(slot_alignment - 1);
+
+    latency_samples = (Uint64 *)malloc(sizeof(Uint64) * (size_t)max_latency_samples);
+    if (latency_samples == NULL)
+        goto Error;
+
+    // Textures stream in on a background thread, frames rendered before would have placeholders //
+    Uint64 wait_start = SDL_GetTicks();
+    while (!RayCast_PrepareBatch())
+    {
+        if (SDL_GetTicks() - wait_start >= (Uint64)texture_wait_ms)
+        {
+            SDL_Log("%s Textures still loading, serving anyway", program_log_tag);
+            break;
+        }
+
+        SDL_Delay(1);
+    }
+
+    if (!RayCastServer_StartWorkers())
+        goto Error;
+
+    if (!RayCastServer_Listen(socket_path))
+        goto Error;
+
+    SDL_Log("%s Serving %dx%d frames on %s with %d workers", program_log_tag, frame_width, frame_height, socket_path, worker_count);
+
+    RayCastServer_Serve();
+
+    exit_code = 0;
+
+Error:
+    for (int i = 0; i < RAYCAST_SERVER_MAX_CLIENTS; i++)
+        RayCastServer_DisconnectClient(i);
+
+    if (listen_socket != RAYCAST_INVALID_SOCKET)
+    {
+        RayCastServer_CloseSocket(listen_socket);
+        listen_socket = RAYCAST_INVALID_SOCKET;
+
+        remove(socket_path);
+    }
+
+    RayCastServer_StopWorkers();
+
+    free(latency_samples);
+    latency_samples = NULL;
+
+    RayCast_Deinitialize();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return exit_code;
+}
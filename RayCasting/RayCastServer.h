@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "RayCastEngine.h"
+
+// Wire Protocol, Native Byte Order, Same Host Only //
+
+#define RAYCAST_SERVER_VERSION          1
+
+#define RAYCAST_SERVER_MAGIC_HELLO      0x49484352U // "RCHI" //
+#define RAYCAST_SERVER_MAGIC_REQUEST    0x51524352U // "RCRQ" //
+#define RAYCAST_SERVER_MAGIC_RESPONSE   0x53524352U // "RCRS" //
+
+#define RAYCAST_SERVER_SHARED_NAME_SIZE 64
+
+// Sent once on connect. Frame slot i starts at i * slot_size in the named region //
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+
+    int32_t width;
+    int32_t height;
+    int32_t bytes_per_pixel;
+    int32_t pitch;
+
+    int32_t slot_count;
+    uint32_t slot_size;
+
+    char shared_memory_name[RAYCAST_SERVER_SHARED_NAME_SIZE];
+}
+RayCastServerHello;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t request_id;
+    uint32_t slot;
+
+    RayCastPose pose;
+}
+RayCastServerRequest;
+
+// The slot may be read once the response with its request_id arrives //
+typedef struct
+{
+    uint32_t magic;
+    uint32_t request_id;
+    uint32_t slot;
+
+    int32_t status; // Rays traversed, or < 0 on failure //
+
+    uint64_t latency_ns; // Request received to response sent //
+}
+RayCastServerResponse;
+
+#define RAYCAST_SERVER_STATUS_BAD_POSE  -1
+#define RAYCAST_SERVER_STATUS_BAD_SLOT  -2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Initializes the engine headless, serves until SDL_EVENT_QUIT. Returns the exit code //
+    extern int RayCastServer_Run(const char *socket_path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,159 @@
+#include "RayCastSnapshot.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include <SDL3/SDL.h>
+
+struct RayCastSnapshotRing
+{
+    RayCastSnapshot *slots;
+    int capacity;
+
+    int head; // Next slot to write //
+    int count;
+};
+
+static const char snapshot_magic[4] = { 'R', 'C', 'S', 'S' };
+
+static const char program_log_tag[] = "[RayCastSnapshot.c]";
+
+// Zeroes padding too, so equal states give byte-equal snapshots //
+void RayCastSnapshot_Init(RayCastSnapshot *snapshot, uint32_t flags)
+{
+    memset(snapshot, 0, sizeof(RayCastSnapshot));
+
+    memcpy(snapshot->magic, snapshot_magic, sizeof(snapshot_magic));
+    snapshot->version = RAYCAST_SNAPSHOT_VERSION;
+    snapshot->size = (uint32_t)sizeof(RayCastSnapshot);
+    snapshot->flags = flags;
+}
+
+bool RayCastSnapshot_IsValid(const RayCastSnapshot *snapshot)
+{
+    return
+        memcmp(snapshot->magic, snapshot_magic, sizeof(snapshot_magic)) == 0 &&
+        snapshot->version == RAYCAST_SNAPSHOT_VERSION &&
+        snapshot->size == (uint32_t)sizeof(RayCastSnapshot);
+}
+
+bool RayCastSnapshot_Save(const RayCastSnapshot *snapshot, const char *path)
+{
+    SDL_IOStream *stream = SDL_IOFromFile(path, "wb");
+    if (stream == NULL)
+    {
+        SDL_Log("%s Failed to write snapshot \"%s\": %s", program_log_tag, path, SDL_GetError());
+        return false;
+    }
+
+    bool written = (SDL_WriteIO(stream, snapshot, sizeof(RayCastSnapshot)) == sizeof(RayCastSnapshot));
+    if (!written)
+        SDL_Log("%s Failed to write snapshot \"%s\": %s", program_log_tag, path, SDL_GetError());
+
+    return SDL_CloseIO(stream) && written;
+}
+
+bool RayCastSnapshot_Load(RayCastSnapshot *snapshot, const char *path)
+{
+    SDL_IOStream *stream = SDL_IOFromFile(path, "rb");
+    if (stream == NULL)
+        return false;
+
+    RayCastSnapshot loaded;
+
+    bool valid =
+        SDL_ReadIO(stream, &loaded, sizeof(loaded)) == sizeof(loaded) &&
+        RayCastSnapshot_IsValid(&loaded);
+
+    SDL_CloseIO(stream);
+
+    if (!valid)
+    {
+        SDL_Log("%s Snapshot \"%s\" is from another version or damaged", program_log_tag, path);
+        return false;
+    }
+
+    *snapshot = loaded;
+
+    return true;
+}
+
+RayCastSnapshotRing *RayCastSnapshotRing_Create(int capacity)
+{
+    if (capacity < 1)
+        return NULL;
+
+    RayCastSnapshotRing *ring = (RayCastSnapshotRing *)malloc(sizeof(RayCastSnapshotRing));
+    if (ring == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for snapshot ring", program_log_tag);
+        return NULL;
+    }
+    memset(ring, 0, sizeof(RayCastSnapshotRing));
+
+    ring->slots = (RayCastSnapshot *)malloc(sizeof(RayCastSnapshot) * (size_t)capacity);
+    if (ring->slots == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for snapshot ring", program_log_tag);
+        free(ring);
+        return NULL;
+    }
+
+    ring->capacity = capacity;
+
+    return ring;
+}
+
+void RayCastSnapshotRing_Destroy(RayCastSnapshotRing *ring)
+{
+    if (ring == NULL)
+        return;
+
+    free(ring->slots);
+    free(ring);
+}
+
+RayCastSnapshot *RayCastSnapshotRing_Push(RayCastSnapshotRing *ring)
+{
+    RayCastSnapshot *snapshot = &ring->slots[ring->head];
+
+    ring->head = (ring->head + 1) % ring->capacity;
+    if (ring->count < ring->capacity)
+        ring->count++;
+
+    return snapshot;
+}
+
+const RayCastSnapshot *RayCastSnapshotRing_Get(const RayCastSnapshotRing *ring, int age)
+{
+    if (age < 0 || age >= ring->count)
+        return NULL;
+
+    int index = (ring->head - 1 - age + ring->capacity) % ring->capacity;
+
+    return &ring->slots[index];
+}
+
+int RayCastSnapshotRing_GetCount(const RayCastSnapshotRing *ring)
+{
+    return ring->count;
+}
+
+void RayCastSnapshotRing_Drop(RayCastSnapshotRing *ring, int count)
+{
+    if (count > ring->count)
+        count = ring->count;
+    if (count <= 0)
+        return;
+
+    ring->head = (ring->head - count + ring->capacity) % ring->capacity;
+    ring->count -= count;
+}
+
+void RayCastSnapshotRing_Clear(RayCastSnapshotRing *ring)
+{
+    ring->head = 0;
+    ring->count = 0;
+}
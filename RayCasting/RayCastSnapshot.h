@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "KeyStatesSDL.h"
+
+#define RAYCAST_SNAPSHOT_VERSION        3
+
+// Flags //
+#define RAYCAST_SNAPSHOT_FIXED_POINT    0x1U // Taken by the fixed-point build, player_fixed_* are authoritative //
+
+// Everything a tick advances and nothing derived from it. Plain data: copied //
+// with memcpy, compared with memcmp and written to disk as is.              //
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t size;
+    uint32_t flags;
+
+    uint64_t tick;
+
+    // Level, as how far along the engine's edit history it was: edits queued since the   //
+    // level was loaded, how many of those were applied, and hashes to tell histories apart //
+    uint32_t level_edit_count;
+    uint32_t level_edit_applied;
+    uint64_t level_applied_hash; // The applied edits and the ticks they were applied at //
+    uint64_t level_queued_hash; // The ones still queued //
+
+    // Player //
+    float player_x, player_y;
+    float player_vel_x, player_vel_y;
+    float player_angle;
+
+    int32_t player_fixed_x, player_fixed_y;
+    int32_t player_fixed_vel_x, player_fixed_vel_y;
+    int32_t player_fixed_angle;
+
+    // Input //
+    KeyStatesSDL key_states;
+
+    // Settings //
+    uint8_t fog_enabled;
+    uint8_t adaptive_cast_enabled;
+    uint8_t lighting_enabled;
+    uint8_t lantern_enabled;
+    uint8_t antialias_enabled;
+}
+RayCastSnapshot;
+
+typedef struct RayCastSnapshotRing RayCastSnapshotRing;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern void RayCastSnapshot_Init(RayCastSnapshot *snapshot, uint32_t flags);
+    extern bool RayCastSnapshot_IsValid(const RayCastSnapshot *snapshot);
+
+    extern bool RayCastSnapshot_Save(const RayCastSnapshot *snapshot, const char *path);
+    extern bool RayCastSnapshot_Load(RayCastSnapshot *snapshot, const char *path);
+
+    // Fixed capacity, the oldest snapshot is overwritten once full //
+    extern RayCastSnapshotRing *RayCastSnapshotRing_Create(int capacity);
+    extern void RayCastSnapshotRing_Destroy(RayCastSnapshotRing *ring);
+
+    extern RayCastSnapshot *RayCastSnapshotRing_Push(RayCastSnapshotRing *ring);
+
+    // Age 0 is the newest, NULL past the oldest //
+    extern const RayCastSnapshot *RayCastSnapshotRing_Get(const RayCastSnapshotRing *ring, int age);
+    extern int RayCastSnapshotRing_GetCount(const RayCastSnapshotRing *ring);
+
+    // Drops the count newest snapshots, e.g. the future after a rollback //
+    extern void RayCastSnapshotRing_Drop(RayCastSnapshotRing *ring, int count);
+    extern void RayCastSnapshotRing_Clear(RayCastSnapshotRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
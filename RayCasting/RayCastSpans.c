@@ -0,0 +1,186 @@
+#include "RayCastSpans.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <memory.h>
+
+#include "RayCastLightMap.h"
+
+// Every feature switch below is a compile-time constant of the variant being //
+// generated, so the compiler folds them and the row loops stay branch free.  //
+
+#define RAYCAST_DEFINE_TEXTURED_SPAN(NAME, FOG, LIT, OUT_BPP, TEX_BPP)                      \
+    static void NAME(const RayCastSpan *span)                                               \
+    {                                                                                       \
+        uint8_t *ptr_pixel = span->ptr_pixels;                                              \
+        const int pitch = span->pitch;                                                      \
+                                                                                            \
+        const float brightness = span->brightness;                                          \
+                                                                                            \
+        const int texture_height = span->texture_height;                                    \
+                                                                                            \
+        for (int y = span->y_begin; y < span->y_end; y++)                                   \
+        {                                                                                   \
+            int texture_y = (int)(((float)(y - span->wall_start_y) / (float)span->wall_range_y) * texture_height); \
+            if (texture_y < 0)                                                              \
+                texture_y = 0;                                                              \
+            if (texture_y >= texture_height)                                                \
+                texture_y = texture_height - 1;                                             \
+                                                                                            \
+            const uint8_t *ptr_texel = span->ptr_texels + (texture_y * span->texture_pitch); \
+                                                                                            \
+            if (LIT)                                                                        \
+            {                                                                               \
+                const float light = span->light_table[((uint32_t)texture_y * span->light_scale) >> 16]; \
+                                                                                            \
+                ptr_pixel[0] = (uint8_t)(ptr_texel[0] * light);                             \
+                ptr_pixel[1] = (uint8_t)(ptr_texel[1] * light);                             \
+                ptr_pixel[2] = (uint8_t)(ptr_texel[2] * light);                             \
+            }                                                                               \
+            else if (!(FOG) && (OUT_BPP) == 4 && (TEX_BPP) == 4)                            \
+            {                                                                               \
+                memcpy(ptr_pixel, ptr_texel, 4);                                            \
+            }                                                                               \
+            else if (FOG)                                                                   \
+            {                                                                               \
+                ptr_pixel[0] = (uint8_t)(ptr_texel[0] * brightness);                        \
+                ptr_pixel[1] = (uint8_t)(ptr_texel[1] * brightness);                        \
+                ptr_pixel[2] = (uint8_t)(ptr_texel[2] * brightness);                        \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                ptr_pixel[0] = ptr_texel[0];                                                \
+                ptr_pixel[1] = ptr_texel[1];                                                \
+                ptr_pixel[2] = ptr_texel[2];                                                \
+            }                                                                               \
+                                                                                            \
+            if ((OUT_BPP) == 4)                                                             \
+                ptr_pixel[3] = 0xFF;                                                        \
+                                                                                            \
+            ptr_pixel += pitch;                                                             \
+        }                                                                                   \
+    }
+
+#define RAYCAST_DEFINE_UNTEXTURED_SPAN(NAME, FOG, LIT, OUT_BPP)                             \
+    static void NAME(const RayCastSpan *span)                                               \
+    {                                                                                       \
+        uint8_t *ptr_pixel = span->ptr_pixels;                                              \
+        const int pitch = span->pitch;                                                      \
+                                                                                            \
+        /* Default White Wall Without Texture */                                            \
+        uint8_t brightness_byte = (FOG) ? (uint8_t)(span->brightness * 255.0F) : 0xFF;      \
+                                                                                            \
+        for (int y = span->y_begin; y < span->y_end; y++)                                   \
+        {                                                                                   \
+            if (LIT)                                                                        \
+            {                                                                               \
+                int light_y = (int)(((float)(y - span->wall_start_y) / (float)span->wall_range_y) * LIGHTMAP_SIZE); \
+                if (light_y < 0)                                                            \
+                    light_y = 0;                                                            \
+                if (light_y >= LIGHTMAP_SIZE)                                               \
+                    light_y = LIGHTMAP_SIZE - 1;                                            \
+                                                                                            \
+                brightness_byte = (uint8_t)(span->light_table[light_y] * 255.0F);           \
+            }                                                                               \
+                                                                                            \
+            ptr_pixel[0] = brightness_byte;                                                 \
+            ptr_pixel[1] = brightness_byte;                                                 \
+            ptr_pixel[2] = brightness_byte;                                                 \
+                                                                                            \
+            if ((OUT_BPP) == 4)                                                             \
+                ptr_pixel[3] = 0xFF;                                                        \
+                                                                                            \
+            ptr_pixel += pitch;                                                             \
+        }                                                                                   \
+    }
+
+#define RAYCAST_DEFINE_BACKGROUND_SPAN(NAME, OUT_BPP)                                       \
+    static void NAME(const RayCastSpan *span)                                               \
+    {                                                                                       \
+        uint8_t *ptr_pixel = span->ptr_pixels;                                              \
+        const int pitch = span->pitch;                                                      \
+                                                                                            \
+        for (int y = span->y_begin; y < span->y_end; y++)                                   \
+        {                                                                                   \
+            ptr_pixel[0] = 0;                                                               \
+            ptr_pixel[1] = 0;                                                               \
+            ptr_pixel[2] = 0;                                                               \
+                                                                                            \
+            if ((OUT_BPP) == 4)                                                             \
+                ptr_pixel[3] = 0xFF;                                                        \
+                                                                                            \
+            ptr_pixel += pitch;                                                             \
+        }                                                                                   \
+    }
+
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_NoFog_Out3_Tex3, false, false, 3, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_NoFog_Out3_Tex4, false, false, 3, 4)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_NoFog_Out4_Tex3, false, false, 4, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_NoFog_Out4_Tex4, false, false, 4, 4)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Fog_Out3_Tex3, true, false, 3, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Fog_Out3_Tex4, true, false, 3, 4)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Fog_Out4_Tex3, true, false, 4, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Fog_Out4_Tex4, true, false, 4, 4)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Lit_Out3_Tex3, true, true, 3, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Lit_Out3_Tex4, true, true, 3, 4)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Lit_Out4_Tex3, true, true, 4, 3)
+RAYCAST_DEFINE_TEXTURED_SPAN(RayCastSpans_Textured_Lit_Out4_Tex4, true, true, 4, 4)
+
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_NoFog_Out3, false, false, 3)
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_NoFog_Out4, false, false, 4)
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_Fog_Out3, true, false, 3)
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_Fog_Out4, true, false, 4)
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_Lit_Out3, true, true, 3)
+RAYCAST_DEFINE_UNTEXTURED_SPAN(RayCastSpans_Untextured_Lit_Out4, true, true, 4)
+
+RAYCAST_DEFINE_BACKGROUND_SPAN(RayCastSpans_Background_Out3, 3)
+RAYCAST_DEFINE_BACKGROUND_SPAN(RayCastSpans_Background_Out4, 4)
+
+// [no fog, fog, lit][output layout] //
+static const RayCastSpanRenderers span_renderers[3][2] =
+{
+    {
+        {
+            RayCastSpans_Untextured_NoFog_Out3,
+            { RayCastSpans_Textured_NoFog_Out3_Tex3, RayCastSpans_Textured_NoFog_Out3_Tex4 },
+            RayCastSpans_Background_Out3
+        },
+        {
+            RayCastSpans_Untextured_NoFog_Out4,
+            { RayCastSpans_Textured_NoFog_Out4_Tex3, RayCastSpans_Textured_NoFog_Out4_Tex4 },
+            RayCastSpans_Background_Out4
+        }
+    },
+    {
+        {
+            RayCastSpans_Untextured_Fog_Out3,
+            { RayCastSpans_Textured_Fog_Out3_Tex3, RayCastSpans_Textured_Fog_Out3_Tex4 },
+            RayCastSpans_Background_Out3
+        },
+        {
+            RayCastSpans_Untextured_Fog_Out4,
+            { RayCastSpans_Textured_Fog_Out4_Tex3, RayCastSpans_Textured_Fog_Out4_Tex4 },
+            RayCastSpans_Background_Out4
+        }
+    },
+    {
+        {
+            RayCastSpans_Untextured_Lit_Out3,
+            { RayCastSpans_Textured_Lit_Out3_Tex3, RayCastSpans_Textured_Lit_Out3_Tex4 },
+            RayCastSpans_Background_Out3
+        },
+        {
+            RayCastSpans_Untextured_Lit_Out4,
+            { RayCastSpans_Textured_Lit_Out4_Tex3, RayCastSpans_Textured_Lit_Out4_Tex4 },
+            RayCastSpans_Background_Out4
+        }
+    }
+};
+
+const RayCastSpanRenderers *RayCastSpans_Select(bool fog_enabled, bool lighting_enabled, int output_bytes_per_pixel)
+{
+    int mode_index = lighting_enabled ? 2 : (fog_enabled ? 1 : 0);
+    int output_index = (output_bytes_per_pixel == 4) ? 1 : 0;
+
+    return &span_renderers[mode_index][output_index];
+}
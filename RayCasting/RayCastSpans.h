@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    // Framebuffer //
+    uint8_t *ptr_pixels;
+    int pitch;
+
+    int y_begin;
+    int y_end;
+
+    // Wall Projection (Unclamped) //
+    int wall_start_y;
+    int wall_range_y;
+
+    // Texture Column, Row 0 At The Hit Texel //
+    const uint8_t *ptr_texels;
+    int texture_pitch;
+    int texture_height;
+
+    float brightness;
+
+    // Lit Variants: Per-Row Light, Fog Already Folded In //
+    const float *light_table;
+    uint32_t light_scale; // 16.16, texture rows to light_table rows //
+}
+RayCastSpan;
+
+typedef void (*RayCastSpanFunc)(const RayCastSpan *span);
+
+typedef struct
+{
+    RayCastSpanFunc untextured;
+    RayCastSpanFunc textured[2]; // Indexed by texture layout: 0 = 3 bytes, 1 = 4 bytes per texel //
+    RayCastSpanFunc background;
+}
+RayCastSpanRenderers;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern const RayCastSpanRenderers *RayCastSpans_Select(bool fog_enabled, bool lighting_enabled, int output_bytes_per_pixel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+#include "RayCastUpscale.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <memory.h>
+
+// Source rows are widened this many pixels at a time through a stack buffer //
+#define RAYCAST_UPSCALE_CHUNK   64
+
+// Pixels are handled as native 32-bit words, 0xAARRGGBB for XRGB / ARGB //
+static const uint32_t alpha_bits = 0xFF000000U;
+static const uint32_t keep_bits = 0xFF00FF00U;
+
+static bool RayCastUpscale_IsSupportedSource(SDL_PixelFormat format)
+{
+    return (format == SDL_PIXELFORMAT_BGR24 || format == SDL_PIXELFORMAT_XRGB8888 || format == SDL_PIXELFORMAT_ARGB8888);
+}
+
+// -1 if unsupported, otherwise whether red and blue trade places //
+static int RayCastUpscale_GetSwap(SDL_PixelFormat format)
+{
+    switch (format)
+    {
+    case SDL_PIXELFORMAT_XRGB8888:
+    case SDL_PIXELFORMAT_ARGB8888:
+        return 0;
+    case SDL_PIXELFORMAT_XBGR8888:
+    case SDL_PIXELFORMAT_ABGR8888:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+bool RayCastUpscale_IsSupported(SDL_PixelFormat src_format, SDL_PixelFormat dst_format)
+{
+    return RayCastUpscale_IsSupportedSource(src_format) && (RayCastUpscale_GetSwap(dst_format) >= 0);
+}
+
+static void RayCastUpscale_ExpandRow(const uint8_t *src, SDL_PixelFormat src_format, uint32_t *row, int count)
+{
+    if (src_format == SDL_PIXELFORMAT_BGR24)
+    {
+        for (int x = 0; x < count; x++)
+        {
+            row[x] = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16);
+            src += 3;
+        }
+    }
+    else
+        memcpy(row, src, (size_t)count * sizeof(uint32_t));
+}
+
+static inline uint32_t RayCastUpscale_Convert(uint32_t pixel, bool swap_red_blue)
+{
+    if (swap_red_blue)
+        pixel = (pixel & keep_bits) | ((pixel >> 16) & 0xFFU) | ((pixel & 0xFFU) << 16);
+
+    return pixel | alpha_bits;
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+static inline __m128i RayCastUpscale_Convert4(__m128i pixels, bool swap_red_blue)
+{
+    if (swap_red_blue)
+    {
+        const __m128i low_byte = _mm_set1_epi32(0xFF);
+
+        __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte);
+        __m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, low_byte), 16);
+
+        pixels = _mm_or_si128(_mm_and_si128(pixels, _mm_set1_epi32((int)keep_bits)), _mm_or_si128(red, blue));
+    }
+
+    return _mm_or_si128(pixels, _mm_set1_epi32((int)alpha_bits));
+}
+#endif
+
+static void RayCastUpscale_WidenRow(const uint32_t *row, uint32_t *dst, int count, int scale, bool swap_red_blue)
+{
+    int x = 0;
+
+#ifdef SDL_SSE2_INTRINSICS
+    // Four source pixels per step, replicated with shuffles instead of per-pixel stores //
+    switch (scale)
+    {
+    case 1:
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i pixels = RayCastUpscale_Convert4(_mm_loadu_si128((const __m128i *)(row + x)), swap_red_blue);
+
+            _mm_storeu_si128((__m128i *)(dst + x), pixels);
+        }
+        break;
+    case 2:
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i pixels = RayCastUpscale_Convert4(_mm_loadu_si128((const __m128i *)(row + x)), swap_red_blue);
+            __m128i *ptr_out = (__m128i *)(dst + (x * 2));
+
+            _mm_storeu_si128(ptr_out + 0, _mm_unpacklo_epi32(pixels, pixels));
+            _mm_storeu_si128(ptr_out + 1, _mm_unpackhi_epi32(pixels, pixels));
+        }
+        break;
+    case 3:
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i pixels = RayCastUpscale_Convert4(_mm_loadu_si128((const __m128i *)(row + x)), swap_red_blue);
+            __m128i *ptr_out = (__m128i *)(dst + (x * 3));
+
+            _mm_storeu_si128(ptr_out + 0, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 0, 0)));
+            _mm_storeu_si128(ptr_out + 1, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 1, 1)));
+            _mm_storeu_si128(ptr_out + 2, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 2)));
+        }
+        break;
+    case 4:
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i pixels = RayCastUpscale_Convert4(_mm_loadu_si128((const __m128i *)(row + x)), swap_red_blue);
+            __m128i *ptr_out = (__m128i *)(dst + (x * 4));
+
+            _mm_storeu_si128(ptr_out + 0, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+            _mm_storeu_si128(ptr_out + 1, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+            _mm_storeu_si128(ptr_out + 2, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+            _mm_storeu_si128(ptr_out + 3, _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+        break;
+    default:
+        break;
+    }
+#endif
+
+    // Tail, larger scales and the non-SIMD build //
+    for (; x < count; x++)
+    {
+        uint32_t pixel = RayCastUpscale_Convert(row[x], swap_red_blue);
+        uint32_t *ptr_out = dst + (x * scale);
+
+        for (int i = 0; i < scale; i++)
+            ptr_out[i] = pixel;
+    }
+}
+
+void RayCastUpscale_Blit(const uint8_t *src, int src_pitch, SDL_PixelFormat src_format, int width, int height,
+    uint8_t *dst, int dst_pitch, SDL_PixelFormat dst_format, int scale)
+{
+    uint32_t row[RAYCAST_UPSCALE_CHUNK];
+
+    const bool swap_red_blue = (RayCastUpscale_GetSwap(dst_format) == 1);
+    const int src_bytes_per_pixel = (src_format == SDL_PIXELFORMAT_BGR24) ? 3 : 4;
+    const size_t dst_row_bytes = (size_t)width * (size_t)scale * sizeof(uint32_t);
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *src_row = src + ((size_t)y * src_pitch);
+        uint8_t *dst_row = dst + ((size_t)y * scale * dst_pitch);
+
+        for (int x = 0; x < width; x += RAYCAST_UPSCALE_CHUNK)
+        {
+            int count = width - x;
+            if (count > RAYCAST_UPSCALE_CHUNK)
+                count = RAYCAST_UPSCALE_CHUNK;
+
+            RayCastUpscale_ExpandRow(src_row + (x * src_bytes_per_pixel), src_format, row, count);
+            RayCastUpscale_WidenRow(row, (uint32_t *)dst_row + (x * scale), count, scale, swap_red_blue);
+        }
+
+        // The other rows of the block are byte copies of the first //
+        for (int i = 1; i < scale; i++)
+            memcpy(dst_row + ((size_t)i * dst_pitch), dst_row, dst_row_bytes);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <SDL3/SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // 24/32-bit BGR sources into XRGB/ARGB/XBGR/ABGR8888; anything else needs SDL_BlitSurfaceScaled //
+    extern bool RayCastUpscale_IsSupported(SDL_PixelFormat src_format, SDL_PixelFormat dst_format);
+
+    // Nearest neighbour, every source pixel becomes a scale x scale block at dst //
+    extern void RayCastUpscale_Blit(const uint8_t *src, int src_pitch, SDL_PixelFormat src_format, int width, int height,
+        uint8_t *dst, int dst_pitch, SDL_PixelFormat dst_format, int scale);
+
+#ifdef __cplusplus
+}
+#endif
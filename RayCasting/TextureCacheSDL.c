@@ -0,0 +1,441 @@
+#include "TextureCacheSDL.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <malloc.h>
+#include <memory.h>
+
+#include <SDL3/SDL.h>
+
+#define PLACEHOLDER_SIZE    8
+
+typedef enum
+{
+    TEXTURE_STATE_UNLOADED,
+    TEXTURE_STATE_PENDING,
+    TEXTURE_STATE_RESIDENT,
+    TEXTURE_STATE_FAILED
+}
+TextureState;
+
+typedef struct
+{
+    const char *file_name;
+
+    // Owned by the main thread //
+    TextureState state;
+    SDL_Surface *surface;
+    SDL_Surface *placeholder;
+    size_t size_bytes;
+    uint64_t last_used_frame;
+
+    // Handed over from the loader thread, guarded by the mutex //
+    bool load_done;
+    SDL_Surface *loaded_surface;
+    SDL_Surface *loaded_placeholder;
+}
+TextureCacheEntry;
+
+struct TextureCacheSDL
+{
+    TextureCacheEntry *entries;
+    int texture_count;
+
+    SDL_PixelFormat pixel_format;
+
+    size_t memory_budget;
+    size_t resident_bytes;
+
+    uint64_t current_frame;
+    bool acquired_this_frame;
+
+    SDL_Surface *default_placeholder;
+
+    SDL_Thread *loader_thread;
+    SDL_Mutex *mutex;
+    SDL_Condition *condition;
+
+    int *load_queue;
+    int load_queue_head;
+    int load_queue_count;
+
+    bool any_load_done;
+    bool quit;
+};
+
+static const char program_log_tag[] = "[TextureCacheSDL.c]";
+
+static SDL_Surface *TextureCacheSDL_CreatePlaceholder(SDL_Surface *source)
+{
+    SDL_Surface *placeholder = SDL_CreateSurface(PLACEHOLDER_SIZE, PLACEHOLDER_SIZE, source->format);
+    if (placeholder == NULL)
+        return NULL;
+
+    int bytes_per_pixel = SDL_BYTESPERPIXEL(source->format);
+
+    int block_w = source->w / PLACEHOLDER_SIZE;
+    int block_h = source->h / PLACEHOLDER_SIZE;
+    if (block_w < 1)
+        block_w = 1;
+    if (block_h < 1)
+        block_h = 1;
+
+    uint8_t *src_pixels = (uint8_t *)source->pixels;
+    uint8_t *dst_pixels = (uint8_t *)placeholder->pixels;
+
+    for (int y = 0; y < PLACEHOLDER_SIZE; y++)
+    {
+        for (int x = 0; x < PLACEHOLDER_SIZE; x++)
+        {
+            int src_x = (x * source->w) / PLACEHOLDER_SIZE;
+            int src_y = (y * source->h) / PLACEHOLDER_SIZE;
+
+            uint8_t *ptr_dst = dst_pixels + (y * placeholder->pitch) + (x * bytes_per_pixel);
+
+            // Box Filter Over The Block //
+            for (int channel = 0; channel < bytes_per_pixel; channel++)
+            {
+                uint32_t sum = 0;
+
+                for (int block_y = 0; block_y < block_h; block_y++)
+                {
+                    uint8_t *ptr_src = src_pixels + ((src_y + block_y) * source->pitch) + (src_x * bytes_per_pixel) + channel;
+
+                    for (int block_x = 0; block_x < block_w; block_x++)
+                    {
+                        sum += *ptr_src;
+                        ptr_src += bytes_per_pixel;
+                    }
+                }
+
+                ptr_dst[channel] = (uint8_t)(sum / (uint32_t)(block_w * block_h));
+            }
+        }
+    }
+
+    return placeholder;
+}
+
+static int SDLCALL TextureCacheSDL_LoaderThread(void *data)
+{
+    TextureCacheSDL *cache = (TextureCacheSDL *)data;
+
+    SDL_LockMutex(cache->mutex);
+
+    while (true)
+    {
+        while (!cache->quit && cache->load_queue_count == 0)
+            SDL_WaitCondition(cache->condition, cache->mutex);
+
+        if (cache->quit)
+            break;
+
+        int texture_id = cache->load_queue[cache->load_queue_head];
+        cache->load_queue_head = (cache->load_queue_head + 1) % cache->texture_count;
+        cache->load_queue_count--;
+
+        const char *file_name = cache->entries[texture_id].file_name;
+
+        SDL_UnlockMutex(cache->mutex);
+
+        // Decode & Convert Outside The Lock //
+
+        SDL_Surface *surface = NULL;
+        SDL_Surface *placeholder = NULL;
+
+        SDL_Surface *decoded = SDL_LoadBMP(file_name);
+        if (decoded != NULL)
+        {
+            surface = SDL_ConvertSurface(decoded, cache->pixel_format);
+            SDL_DestroySurface(decoded);
+        }
+
+        if (surface != NULL)
+            placeholder = TextureCacheSDL_CreatePlaceholder(surface);
+        else
+            SDL_Log("%s Failed to load texture \"%s\": %s", program_log_tag, file_name, SDL_GetError());
+
+        SDL_LockMutex(cache->mutex);
+
+        TextureCacheEntry *entry = &cache->entries[texture_id];
+        entry->loaded_surface = surface;
+        entry->loaded_placeholder = placeholder;
+        entry->load_done = true;
+
+        cache->any_load_done = true;
+    }
+
+    SDL_UnlockMutex(cache->mutex);
+
+    return 0;
+}
+
+TextureCacheSDL *TextureCacheSDL_Create(const char *const *file_names, int texture_count, SDL_PixelFormat pixel_format, size_t memory_budget)
+{
+    if (file_names == NULL || texture_count <= 0)
+        return NULL;
+
+    TextureCacheSDL *cache = (TextureCacheSDL *)calloc(1, sizeof(TextureCacheSDL));
+    if (cache == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for texture cache", program_log_tag);
+        return NULL;
+    }
+
+    cache->texture_count = texture_count;
+    cache->pixel_format = pixel_format;
+    cache->memory_budget = memory_budget;
+
+    cache->entries = (TextureCacheEntry *)calloc((size_t)texture_count, sizeof(TextureCacheEntry));
+    cache->load_queue = (int *)malloc(sizeof(int) * texture_count);
+    if (cache->entries == NULL || cache->load_queue == NULL)
+    {
+        SDL_Log("%s Failed to allocate memory for texture entries", program_log_tag);
+        goto Error;
+    }
+
+    for (int i = 0; i < texture_count; i++)
+    {
+        cache->entries[i].file_name = file_names[i];
+        cache->entries[i].state = (file_names[i] != NULL) ? TEXTURE_STATE_UNLOADED : TEXTURE_STATE_FAILED;
+    }
+
+    // Neutral Grey Until The First Decode Of A Texture Finishes //
+    cache->default_placeholder = SDL_CreateSurface(1, 1, pixel_format);
+    if (cache->default_placeholder == NULL)
+    {
+        SDL_Log("%s Failed to create placeholder: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+    memset(cache->default_placeholder->pixels, 0x80, (size_t)cache->default_placeholder->pitch);
+
+    cache->mutex = SDL_CreateMutex();
+    cache->condition = SDL_CreateCondition();
+    if (cache->mutex == NULL || cache->condition == NULL)
+    {
+        SDL_Log("%s Failed to create loader synchronization: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+
+    cache->loader_thread = SDL_CreateThread(TextureCacheSDL_LoaderThread, "TextureLoader", (void *)cache);
+    if (cache->loader_thread == NULL)
+    {
+        SDL_Log("%s Failed to create loader thread: %s", program_log_tag, SDL_GetError());
+        goto Error;
+    }
+
+    return cache;
+
+Error:
+    TextureCacheSDL_Destroy(cache);
+
+    return NULL;
+}
+
+void TextureCacheSDL_Destroy(TextureCacheSDL *cache)
+{
+    if (cache == NULL)
+        return;
+
+    if (cache->loader_thread != NULL)
+    {
+        SDL_LockMutex(cache->mutex);
+        cache->quit = true;
+        SDL_SignalCondition(cache->condition);
+        SDL_UnlockMutex(cache->mutex);
+
+        SDL_WaitThread(cache->loader_thread, NULL);
+        cache->loader_thread = NULL;
+    }
+
+    if (cache->entries != NULL)
+    {
+        for (int i = 0; i < cache->texture_count; i++)
+        {
+            TextureCacheEntry *entry = &cache->entries[i];
+
+            if (entry->surface != NULL)
+                SDL_DestroySurface(entry->surface);
+            if (entry->placeholder != NULL)
+                SDL_DestroySurface(entry->placeholder);
+            if (entry->loaded_surface != NULL)
+                SDL_DestroySurface(entry->loaded_surface);
+            if (entry->loaded_placeholder != NULL)
+                SDL_DestroySurface(entry->loaded_placeholder);
+        }
+
+        free(cache->entries);
+    }
+
+    if (cache->load_queue != NULL)
+        free(cache->load_queue);
+
+    if (cache->default_placeholder != NULL)
+        SDL_DestroySurface(cache->default_placeholder);
+
+    if (cache->condition != NULL)
+        SDL_DestroyCondition(cache->condition);
+
+    if (cache->mutex != NULL)
+        SDL_DestroyMutex(cache->mutex);
+
+    free(cache);
+}
+
+static void TextureCacheSDL_EvictOverBudget(TextureCacheSDL *cache)
+{
+    while (cache->resident_bytes > cache->memory_budget)
+    {
+        TextureCacheEntry *lru_entry = NULL;
+
+        for (int i = 0; i < cache->texture_count; i++)
+        {
+            TextureCacheEntry *entry = &cache->entries[i];
+
+            if (entry->state != TEXTURE_STATE_RESIDENT)
+                continue;
+
+            // Never Drop Something The Previous Frame Drew //
+            if (entry->last_used_frame + 1 >= cache->current_frame)
+                continue;
+
+            if (lru_entry == NULL || entry->last_used_frame < lru_entry->last_used_frame)
+                lru_entry = entry;
+        }
+
+        if (lru_entry == NULL)
+            break;
+
+        SDL_DestroySurface(lru_entry->surface);
+        lru_entry->surface = NULL;
+
+        cache->resident_bytes -= lru_entry->size_bytes;
+        lru_entry->size_bytes = 0;
+
+        lru_entry->state = TEXTURE_STATE_UNLOADED;
+    }
+}
+
+bool TextureCacheSDL_Update(TextureCacheSDL *cache)
+{
+    if (cache == NULL)
+        return false;
+
+    bool changed = false;
+
+    // Frames that drew nothing do not age the resident textures //
+    if (cache->acquired_this_frame)
+    {
+        cache->current_frame++;
+        cache->acquired_this_frame = false;
+    }
+
+    SDL_LockMutex(cache->mutex);
+
+    if (cache->any_load_done)
+    {
+        for (int i = 0; i < cache->texture_count; i++)
+        {
+            TextureCacheEntry *entry = &cache->entries[i];
+
+            if (!entry->load_done)
+                continue;
+
+            entry->load_done = false;
+
+            if (entry->loaded_surface != NULL)
+            {
+                entry->surface = entry->loaded_surface;
+                entry->size_bytes = (size_t)entry->surface->pitch * (size_t)entry->surface->h;
+
+                cache->resident_bytes += entry->size_bytes;
+
+                entry->state = TEXTURE_STATE_RESIDENT;
+            }
+            else
+                entry->state = TEXTURE_STATE_FAILED;
+
+            if (entry->loaded_placeholder != NULL)
+            {
+                if (entry->placeholder != NULL)
+                    SDL_DestroySurface(entry->placeholder);
+
+                entry->placeholder = entry->loaded_placeholder;
+            }
+
+            entry->loaded_surface = NULL;
+            entry->loaded_placeholder = NULL;
+
+            changed = true;
+        }
+
+        cache->any_load_done = false;
+    }
+
+    SDL_UnlockMutex(cache->mutex);
+
+    // Only textures the last frame did not draw are evicted, so this never changes what is on screen //
+    TextureCacheSDL_EvictOverBudget(cache);
+
+    return changed;
+}
+
+SDL_Surface *TextureCacheSDL_Acquire(TextureCacheSDL *cache, int texture_id)
+{
+    if (cache == NULL || texture_id < 0 || texture_id >= cache->texture_count)
+        return NULL;
+
+    TextureCacheEntry *entry = &cache->entries[texture_id];
+
+    entry->last_used_frame = cache->current_frame;
+    cache->acquired_this_frame = true;
+
+    switch (entry->state)
+    {
+    case TEXTURE_STATE_RESIDENT:
+        return entry->surface;
+    case TEXTURE_STATE_FAILED:
+        return NULL;
+    case TEXTURE_STATE_UNLOADED:
+        SDL_LockMutex(cache->mutex);
+        cache->load_queue[(cache->load_queue_head + cache->load_queue_count) % cache->texture_count] = texture_id;
+        cache->load_queue_count++;
+        SDL_SignalCondition(cache->condition);
+        SDL_UnlockMutex(cache->mutex);
+
+        entry->state = TEXTURE_STATE_PENDING;
+        break;
+    case TEXTURE_STATE_PENDING:
+        break;
+    }
+
+    if (entry->placeholder != NULL)
+        return entry->placeholder;
+
+    return cache->default_placeholder;
+}
+
+size_t TextureCacheSDL_GetResidentBytes(TextureCacheSDL *cache)
+{
+    if (cache == NULL)
+        return 0;
+
+    return cache->resident_bytes;
+}
+
+int TextureCacheSDL_GetPendingCount(TextureCacheSDL *cache)
+{
+    if (cache == NULL)
+        return 0;
+
+    int pending_count = 0;
+
+    for (int i = 0; i < cache->texture_count; i++)
+    {
+        if (cache->entries[i].state == TEXTURE_STATE_PENDING)
+            pending_count++;
+    }
+
+    return pending_count;
+}
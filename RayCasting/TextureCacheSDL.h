@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <SDL3/SDL.h>
+
+typedef struct TextureCacheSDL TextureCacheSDL;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern TextureCacheSDL *TextureCacheSDL_Create(const char *const *file_names, int texture_count, SDL_PixelFormat pixel_format, size_t memory_budget);
+    extern void TextureCacheSDL_Destroy(TextureCacheSDL *cache);
+
+    extern bool TextureCacheSDL_Update(TextureCacheSDL *cache);
+
+    extern SDL_Surface *TextureCacheSDL_Acquire(TextureCacheSDL *cache, int texture_id);
+
+    extern size_t TextureCacheSDL_GetResidentBytes(TextureCacheSDL *cache);
+    extern int TextureCacheSDL_GetPendingCount(TextureCacheSDL *cache);
+
+#ifdef __cplusplus
+}
+#endif
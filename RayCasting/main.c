@@ -1,14 +1,38 @@
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include <SDL3/SDL.h>
 
 #include "RayCastEngine.h"
+#include "RayCastServer.h"
+#include "RayCastBench.h"
 
 int main(int argc, char *argv[])
 {
     float time_ms = 0.0F;
     const float ms_per_tick = 1000.0F / 60.0F;
+    const int idle_wait_ms = 250;
+
+    // Long-running headless mode: poses in over the socket, frames out through shared memory //
+    if (argc >= 3 && strcmp(argv[1], "--server") == 0)
+    {
+        int exit_code = RayCastServer_Run(argv[2]);
+
+        SDL_Quit();
+
+        return exit_code;
+    }
+
+    // Generated levels rendered headless, one CSV row per configuration //
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0)
+    {
+        int exit_code = RayCastBench_Run(argc - 2, argv + 2);
+
+        SDL_Quit();
+
+        return exit_code;
+    }
 
     if (RayCast_Initialize())
     {
@@ -30,7 +54,16 @@ int main(int argc, char *argv[])
                 time_ms = fmodf(time_ms, ms_per_tick);
             }
 
-            SDL_Delay(1);
+            // Nothing changed last tick, sleep until input arrives instead of polling //
+            if (RayCast_IsIdle())
+            {
+                SDL_WaitEventTimeout(NULL, idle_wait_ms);
+
+                last_tick = SDL_GetTicks();
+                time_ms = ms_per_tick;
+            }
+            else
+                SDL_Delay(1);
         }
     }
 